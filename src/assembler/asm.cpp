@@ -1,5 +1,7 @@
 #include <cstdint>
+#include <optional>
 #include <unordered_map>
+#include <utility>
 #include <variant>
 
 #include "opcodes.h"
@@ -43,15 +45,21 @@ bool matches (const std::vector<Token>& tokens, size_t index) {
     return index + sizeof...(Types) <= tokens.size() && matchesUnsafe<0, Types...>(tokens, index);
 }
 
+template <typename Variant>
+std::optional<uint8_t> findOpcode (std::optional<Instruction> instruction, AddressingMode mode) {
+    return instruction ? findOpcode<Variant>(*instruction, mode) : std::nullopt;
+}
+
 struct Link {
     uint16_t offset;
     std::string name;
     int lineIndex;
 };
 
-std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Token>& tokens) {
+template <typename Variant>
+std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Token>& tokens, Labels* exported) {
     std::vector<uint8_t> bytes;
-    std::unordered_map<std::string, uint16_t> labels;
+    Labels labels;
     std::vector<Link> links;
 
     auto index = 0;
@@ -82,19 +90,22 @@ std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Toke
             const auto& name = getIdentifierName(tokens[index]);
             index++;
 
-            if (name != "BYTE" && name != "WORD" && !insNames.contains(name)) {
+            const auto instruction = findInstruction(name);
+
+            // mnemonics of the other variants are as unknown as any other word
+            if (name != "BYTE" && name != "WORD" && !(instruction && hasInstruction<Variant>(*instruction))) {
                 return ParserError { "Unrecognized instruction '" + name + '\'', lineIndex };
             }
 
             if (matches<TokenType::NewLine>(tokens, index)) {
                 // implied
-                const InsAndMode insAndMode { name, AddressingMode::Implied };
+                const auto opcode = findOpcode<Variant>(instruction, AddressingMode::Implied);
 
-                if (!opcodes.contains(insAndMode)) {
+                if (!opcode) {
                     return ParserError { name + " is not available with implied addressing", lineIndex };
                 }
 
-                bytes.push_back(opcodes[insAndMode]);
+                bytes.push_back(*opcode);
                 index++;
                 continue;
             }
@@ -123,23 +134,23 @@ std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Toke
                 }
 
                 if (std::in_range<uint8_t>(value)) {
-                    const InsAndMode insAndMode { name, AddressingMode::ZeroPage };
+                    const auto opcode = findOpcode<Variant>(instruction, AddressingMode::ZeroPage);
 
-                    if (opcodes.contains(insAndMode)) {
-                        bytes.insert(bytes.end(), { opcodes[insAndMode], getByte<0>(value) });
+                    if (opcode) {
+                        bytes.insert(bytes.end(), { *opcode, getByte<0>(value) });
                         index += 2;
                         continue;
                     }
                 }
 
                 if (std::in_range<uint16_t>(value)) {
-                    const InsAndMode insAndMode { name, AddressingMode::Absolute };
+                    const auto opcode = findOpcode<Variant>(instruction, AddressingMode::Absolute);
 
-                    if (!opcodes.contains(insAndMode)) {
+                    if (!opcode) {
                         return ParserError { name + " is not available with zero-page or absolute addressing", lineIndex };
                     }
 
-                    bytes.insert(bytes.end(), { opcodes[insAndMode], getByte<0>(value), getByte<1>(value) });
+                    bytes.insert(bytes.end(), { *opcode, getByte<0>(value), getByte<1>(value) });
 
                     index += 2;
                     continue;
@@ -151,22 +162,22 @@ std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Toke
             if (matches<TokenType::Identifier, TokenType::NewLine>(tokens, index)) {
                 if (getIdentifierName(tokens[index]) == "A") {
                     // accumulator
-                    const InsAndMode insAndMode { name, AddressingMode::Accumulator };
+                    const auto opcode = findOpcode<Variant>(instruction, AddressingMode::Accumulator);
 
-                    if (!opcodes.contains(insAndMode)) {
+                    if (!opcode) {
                         return ParserError { name + " is not available with accumulator addressing", lineIndex };
                     }
 
-                    bytes.push_back(opcodes[insAndMode]);
+                    bytes.push_back(*opcode);
                 } else {
                     // relative
-                    const InsAndMode insAndMode { name, AddressingMode::Relative };
+                    const auto opcode = findOpcode<Variant>(instruction, AddressingMode::Relative);
 
-                    if (!opcodes.contains(insAndMode)) {
+                    if (!opcode) {
                         return ParserError { name + " is not available with relative addressing", lineIndex };
                     }
 
-                    bytes.insert(bytes.end(), { opcodes[insAndMode], 0x00 });
+                    bytes.insert(bytes.end(), { *opcode, 0x00 });
                     links.emplace_back(bytes.size() - 1, getIdentifierName(tokens[index]), lineIndex);
                 }
 
@@ -176,9 +187,9 @@ std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Toke
 
             if (matches<TokenType::Star, TokenType::Number, TokenType::NewLine>(tokens, index)) {
                 // relative
-                const InsAndMode insAndMode { name, AddressingMode::Relative };
+                const auto opcode = findOpcode<Variant>(instruction, AddressingMode::Relative);
 
-                if (!opcodes.contains(insAndMode)) {
+                if (!opcode) {
                     return ParserError { name + " is not available with relative addressing", lineIndex };
                 }
 
@@ -187,7 +198,7 @@ std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Toke
                     return ParserError { "jump target is too far from jump instruction", lineIndex };
                 }
 
-                bytes.insert(bytes.end(), { opcodes[insAndMode], static_cast<uint8_t>(offset) });
+                bytes.insert(bytes.end(), { *opcode, static_cast<uint8_t>(offset) });
 
                 index += 3;
                 continue;
@@ -195,9 +206,9 @@ std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Toke
 
             if (matches<TokenType::Hash, TokenType::Number, TokenType::NewLine>(tokens, index)) {
                 // immediate
-                const InsAndMode insAndMode { name, AddressingMode::Immediate };
+                const auto opcode = findOpcode<Variant>(instruction, AddressingMode::Immediate);
 
-                if (!opcodes.contains(insAndMode)) {
+                if (!opcode) {
                     return ParserError { name + " is not available with immediate addressing", lineIndex };
                 }
 
@@ -207,7 +218,7 @@ std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Toke
                     return ParserError { std::to_string(value) + " does not fit in a byte", lineIndex };
                 }
 
-                bytes.insert(bytes.end(), { opcodes[insAndMode], getByte<0>(value) });
+                bytes.insert(bytes.end(), { *opcode, getByte<0>(value) });
 
                 index += 3;
                 continue;
@@ -222,23 +233,23 @@ std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Toke
                 const auto value = getNumberValue(tokens[index]);
 
                 if (std::in_range<uint8_t>(value)) {
-                    const InsAndMode insAndMode { name, xy == "X" ? AddressingMode::ZeroPageX : AddressingMode::ZeroPageY };
+                    const auto opcode = findOpcode<Variant>(instruction, xy == "X" ? AddressingMode::ZeroPageX : AddressingMode::ZeroPageY);
 
-                    if (opcodes.contains(insAndMode)) {
-                        bytes.insert(bytes.end(), { opcodes[insAndMode], getByte<0>(value) });
+                    if (opcode) {
+                        bytes.insert(bytes.end(), { *opcode, getByte<0>(value) });
                         index += 4;
                         continue;
                     }
                 }
 
                 if (std::in_range<uint16_t>(value)) {
-                    const InsAndMode insAndMode { name, xy == "X" ? AddressingMode::AbsoluteX : AddressingMode::AbsoluteY };
+                    const auto opcode = findOpcode<Variant>(instruction, xy == "X" ? AddressingMode::AbsoluteX : AddressingMode::AbsoluteY);
 
-                    if (!opcodes.contains(insAndMode)) {
+                    if (!opcode) {
                         return ParserError { name + " is not available with zero-page-x/z or absolute-x/z addressing", lineIndex };
                     }
 
-                    bytes.insert(bytes.end(), { opcodes[insAndMode], getByte<0>(value), getByte<1>(value) });
+                    bytes.insert(bytes.end(), { *opcode, getByte<0>(value), getByte<1>(value) });
 
                     index += 4;
                     continue;
@@ -248,19 +259,29 @@ std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Toke
             }
 
             if (matches<TokenType::ParOpen, TokenType::Number, TokenType::ParClosed, TokenType::NewLine>(tokens, index)) {
-                const InsAndMode insAndMode { name, AddressingMode::Indirect };
+                const auto value = getNumberValue(tokens[index + 1]);
 
-                if (!opcodes.contains(insAndMode)) {
-                    return ParserError { name + " is not available with indirect addressing", lineIndex };
+                if (std::in_range<uint8_t>(value)) {
+                    const auto opcode = findOpcode<Variant>(instruction, AddressingMode::ZeroPageIndirect);
+
+                    if (opcode) {
+                        bytes.insert(bytes.end(), { *opcode, getByte<0>(value) });
+                        index += 4;
+                        continue;
+                    }
                 }
 
-                const auto value = getNumberValue(tokens[index + 1]);
+                const auto opcode = findOpcode<Variant>(instruction, AddressingMode::Indirect);
+
+                if (!opcode) {
+                    return ParserError { name + " is not available with indirect addressing", lineIndex };
+                }
 
                 if (!std::in_range<uint16_t>(value)) {
                     return ParserError { std::to_string(value) + " does not fit in a word", lineIndex };
                 }
 
-                bytes.insert(bytes.end(), { opcodes[insAndMode], getByte<0>(value), getByte<1>(value) });
+                bytes.insert(bytes.end(), { *opcode, getByte<0>(value), getByte<1>(value) });
 
                 index += 4;
                 continue;
@@ -270,9 +291,23 @@ std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Toke
                 matches<TokenType::ParOpen, TokenType::Number, TokenType::Comma, TokenType::Identifier, TokenType::ParClosed, TokenType::NewLine>(tokens, index) &&
                 getIdentifierName(tokens[index + 3]) == "X"
             ) {
-                const InsAndMode insAndMode { name, AddressingMode::IndirectX };
+                // JMP on the 65C02 takes a whole word
+                if (const auto opcode = findOpcode<Variant>(instruction, AddressingMode::AbsoluteIndirectX)) {
+                    const auto value = getNumberValue(tokens[index + 1]);
 
-                if (!opcodes.contains(insAndMode)) {
+                    if (!std::in_range<uint16_t>(value)) {
+                        return ParserError { std::to_string(value) + " does not fit in a word", lineIndex };
+                    }
+
+                    bytes.insert(bytes.end(), { *opcode, getByte<0>(value), getByte<1>(value) });
+
+                    index += 6;
+                    continue;
+                }
+
+                const auto opcode = findOpcode<Variant>(instruction, AddressingMode::IndirectX);
+
+                if (!opcode) {
                     return ParserError { name + " is not available with indirect-x addressing", lineIndex };
                 }
 
@@ -282,7 +317,7 @@ std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Toke
                     return ParserError { std::to_string(value) + " does not fit in a byte", lineIndex };
                 }
 
-                bytes.insert(bytes.end(), { opcodes[insAndMode], getByte<0>(value) });
+                bytes.insert(bytes.end(), { *opcode, getByte<0>(value) });
 
                 index += 6;
                 continue;
@@ -292,9 +327,9 @@ std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Toke
                 matches<TokenType::ParOpen, TokenType::Number, TokenType::ParClosed, TokenType::Comma, TokenType::Identifier, TokenType::NewLine>(tokens, index) &&
                 getIdentifierName(tokens[index + 4]) == "Y"
             ) {
-                const InsAndMode insAndMode { name, AddressingMode::IndirectY };
+                const auto opcode = findOpcode<Variant>(instruction, AddressingMode::IndirectY);
 
-                if (!opcodes.contains(insAndMode)) {
+                if (!opcode) {
                     return ParserError { name + " is not available with indirect-y addressing", lineIndex };
                 }
 
@@ -304,7 +339,7 @@ std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Toke
                     return ParserError { std::to_string(value) + " does not fit in a byte", lineIndex };
                 }
 
-                bytes.insert(bytes.end(), { opcodes[insAndMode], getByte<0>(value) });
+                bytes.insert(bytes.end(), { *opcode, getByte<0>(value) });
 
                 index += 6;
                 continue;
@@ -328,5 +363,13 @@ std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Toke
         bytes[link.offset] = delta;
     }
 
+    if (exported != nullptr) {
+        *exported = std::move(labels);
+    }
+
     return bytes;
-}
\ No newline at end of file
+}
+
+template std::variant<std::vector<uint8_t>, ParserError> assemble<Nmos6502> (const std::vector<Token>&, Labels*);
+template std::variant<std::vector<uint8_t>, ParserError> assemble<Nmos6502Undocumented> (const std::vector<Token>&, Labels*);
+template std::variant<std::vector<uint8_t>, ParserError> assemble<Cmos65C02> (const std::vector<Token>&, Labels*);
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef ASM_H
 #define ASM_H
 
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "ParserError.h"
@@ -8,7 +10,12 @@
 
 
 
-std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Token>&);
+// label names and their offsets from the start of the program
+typedef std::unordered_map<std::string, uint16_t> Labels;
+
+// instantiated for the cpu variants in opcodes.h, the labels are handed out when asked for
+template <typename Variant>
+std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Token>&, Labels* labels = nullptr);
 
 
 
@@ -1,13 +1,17 @@
 #ifndef OPCODES_H
 #define OPCODES_H
 
-#include <string>
-#include <unordered_map>
-#include <unordered_set>
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <span>
+#include <string_view>
 
 
 enum class AddressingMode : uint8_t {
     Absolute,
+    AbsoluteIndirectX,
     AbsoluteX,
     AbsoluteY,
     Accumulator,
@@ -18,243 +22,609 @@ enum class AddressingMode : uint8_t {
     IndirectY,
     Relative,
     ZeroPage,
+    ZeroPageIndirect,
     ZeroPageX,
     ZeroPageY,
 };
 
-struct InsAndMode {
-    std::string name;
-    AddressingMode mode;
+enum class Instruction : uint8_t {
+    ADC, AND, ASL, BCC, BCS, BEQ, BIT, BMI,
+    BNE, BPL, BRK, BVC, BVS, CLC, CLD, CLI,
+    CLV, CMP, CPX, CPY, DEC, DEX, DEY, EOR,
+    INC, INX, INY, JMP, JSR, LDA, LDX, LDY,
+    LSR, NOP, ORA, PHA, PHP, PLA, PLP, ROL,
+    ROR, RTI, RTS, SBC, SEC, SED, SEI, STA,
+    STX, STY, TAX, TAY, TSX, TXA, TXS, TYA,
+
+    // undocumented NMOS
+    ALR, ANC, ARR, DCP, ISC, LAS, LAX, RLA,
+    RRA, SAX, SBX, SLO, SRE,
+
+    // 65C02
+    BRA, PHX, PHY, PLX, PLY, STZ, TRB, TSB,
+};
+
+constexpr std::string_view instructionNames[] {
+    "ADC", "AND", "ASL", "BCC", "BCS", "BEQ", "BIT", "BMI",
+    "BNE", "BPL", "BRK", "BVC", "BVS", "CLC", "CLD", "CLI",
+    "CLV", "CMP", "CPX", "CPY", "DEC", "DEX", "DEY", "EOR",
+    "INC", "INX", "INY", "JMP", "JSR", "LDA", "LDX", "LDY",
+    "LSR", "NOP", "ORA", "PHA", "PHP", "PLA", "PLP", "ROL",
+    "ROR", "RTI", "RTS", "SBC", "SEC", "SED", "SEI", "STA",
+    "STX", "STY", "TAX", "TAY", "TSX", "TXA", "TXS", "TYA",
 
-    bool operator== (const InsAndMode& rhs) const { return mode == rhs.mode && name == rhs.name; }
+    "ALR", "ANC", "ARR", "DCP", "ISC", "LAS", "LAX", "RLA",
+    "RRA", "SAX", "SBX", "SLO", "SRE",
+
+    "BRA", "PHX", "PHY", "PLX", "PLY", "STZ", "TRB", "TSB",
 };
 
-template<>
-struct std::hash<InsAndMode> {
-    std::size_t operator() (const InsAndMode& cursor) const noexcept {
-        return std::hash<std::string>()(cursor.name) ^ static_cast<std::size_t>(cursor.mode);
+constexpr std::string_view getName (Instruction instruction) {
+    return instructionNames[static_cast<size_t>(instruction)];
+}
+
+constexpr int operandSize (AddressingMode mode) {
+    switch (mode) {
+        case AddressingMode::Absolute: [[fallthrough]];
+        case AddressingMode::AbsoluteIndirectX: [[fallthrough]];
+        case AddressingMode::AbsoluteX: [[fallthrough]];
+        case AddressingMode::AbsoluteY: return 2;
+        case AddressingMode::Accumulator: return 0;
+        case AddressingMode::Immediate: return 1;
+        case AddressingMode::Implied: return 0;
+        case AddressingMode::Indirect: return 2;
+        case AddressingMode::IndirectX: [[fallthrough]];
+        case AddressingMode::IndirectY: return 1;
+        case AddressingMode::Relative: return 1;
+        case AddressingMode::ZeroPage: [[fallthrough]];
+        case AddressingMode::ZeroPageIndirect: [[fallthrough]];
+        case AddressingMode::ZeroPageX: [[fallthrough]];
+        case AddressingMode::ZeroPageY: return 1;
+        default: return 0;
     }
+}
+
+struct OpcodeEntry {
+    Instruction instruction;
+    AddressingMode mode;
+    uint8_t opcode;
+    uint8_t cycles; // base cost, without page-crossing or branch-taken penalties
 };
 
-static std::unordered_map<InsAndMode, uint8_t> opcodes {
-    { { "ADC", AddressingMode::Absolute }, 0x6D },
-    { { "ADC", AddressingMode::AbsoluteX }, 0x7D },
-    { { "ADC", AddressingMode::AbsoluteY }, 0x79 },
-    { { "ADC", AddressingMode::Immediate }, 0x69 },
-    { { "ADC", AddressingMode::IndirectX }, 0x61 },
-    { { "ADC", AddressingMode::IndirectY }, 0x71 },
-    { { "ADC", AddressingMode::ZeroPage }, 0x65 },
-    { { "ADC", AddressingMode::ZeroPageX }, 0x75 },
+// single source of truth for the assembler, the disassembler and the cpu core, the documented NMOS set
+constexpr OpcodeEntry opcodeEntries[] {
+    { Instruction::ADC, AddressingMode::Absolute, 0x6D, 4 },
+    { Instruction::ADC, AddressingMode::AbsoluteX, 0x7D, 4 },
+    { Instruction::ADC, AddressingMode::AbsoluteY, 0x79, 4 },
+    { Instruction::ADC, AddressingMode::Immediate, 0x69, 2 },
+    { Instruction::ADC, AddressingMode::IndirectX, 0x61, 6 },
+    { Instruction::ADC, AddressingMode::IndirectY, 0x71, 5 },
+    { Instruction::ADC, AddressingMode::ZeroPage, 0x65, 3 },
+    { Instruction::ADC, AddressingMode::ZeroPageX, 0x75, 4 },
+
+    { Instruction::AND, AddressingMode::Absolute, 0x2D, 4 },
+    { Instruction::AND, AddressingMode::AbsoluteX, 0x3D, 4 },
+    { Instruction::AND, AddressingMode::AbsoluteY, 0x39, 4 },
+    { Instruction::AND, AddressingMode::Immediate, 0x29, 2 },
+    { Instruction::AND, AddressingMode::IndirectX, 0x21, 6 },
+    { Instruction::AND, AddressingMode::IndirectY, 0x31, 5 },
+    { Instruction::AND, AddressingMode::ZeroPage, 0x25, 3 },
+    { Instruction::AND, AddressingMode::ZeroPageX, 0x35, 4 },
+
+    { Instruction::ASL, AddressingMode::Absolute, 0x0E, 6 },
+    { Instruction::ASL, AddressingMode::AbsoluteX, 0x1E, 7 },
+    { Instruction::ASL, AddressingMode::Accumulator, 0x0A, 2 },
+    { Instruction::ASL, AddressingMode::ZeroPage, 0x06, 5 },
+    { Instruction::ASL, AddressingMode::ZeroPageX, 0x16, 6 },
+
+    { Instruction::BCC, AddressingMode::Relative, 0x90, 2 },
+
+    { Instruction::BCS, AddressingMode::Relative, 0xB0, 2 },
+
+    { Instruction::BEQ, AddressingMode::Relative, 0xF0, 2 },
+
+    { Instruction::BIT, AddressingMode::Absolute, 0x2C, 4 },
+    { Instruction::BIT, AddressingMode::ZeroPage, 0x24, 3 },
+
+    { Instruction::BMI, AddressingMode::Relative, 0x30, 2 },
+
+    { Instruction::BNE, AddressingMode::Relative, 0xD0, 2 },
+
+    { Instruction::BPL, AddressingMode::Relative, 0x10, 2 },
+
+    { Instruction::BRK, AddressingMode::Implied, 0x00, 7 },
+
+    { Instruction::BVC, AddressingMode::Relative, 0x50, 2 },
+
+    { Instruction::BVS, AddressingMode::Relative, 0x70, 2 },
+
+    { Instruction::CLC, AddressingMode::Implied, 0x18, 2 },
+
+    { Instruction::CLD, AddressingMode::Implied, 0xD8, 2 },
+
+    { Instruction::CLI, AddressingMode::Implied, 0x58, 2 },
+
+    { Instruction::CLV, AddressingMode::Implied, 0xB8, 2 },
+
+    { Instruction::CMP, AddressingMode::Absolute, 0xCD, 4 },
+    { Instruction::CMP, AddressingMode::AbsoluteX, 0xDD, 4 },
+    { Instruction::CMP, AddressingMode::AbsoluteY, 0xD9, 4 },
+    { Instruction::CMP, AddressingMode::Immediate, 0xC9, 2 },
+    { Instruction::CMP, AddressingMode::IndirectX, 0xC1, 6 },
+    { Instruction::CMP, AddressingMode::IndirectY, 0xD1, 5 },
+    { Instruction::CMP, AddressingMode::ZeroPage, 0xC5, 3 },
+    { Instruction::CMP, AddressingMode::ZeroPageX, 0xD5, 4 },
+
+    { Instruction::CPX, AddressingMode::Absolute, 0xEC, 4 },
+    { Instruction::CPX, AddressingMode::Immediate, 0xE0, 2 },
+    { Instruction::CPX, AddressingMode::ZeroPage, 0xE4, 3 },
+
+    { Instruction::CPY, AddressingMode::Absolute, 0xCC, 4 },
+    { Instruction::CPY, AddressingMode::Immediate, 0xC0, 2 },
+    { Instruction::CPY, AddressingMode::ZeroPage, 0xC4, 3 },
+
+    { Instruction::DEC, AddressingMode::Absolute, 0xCE, 6 },
+    { Instruction::DEC, AddressingMode::AbsoluteX, 0xDE, 7 },
+    { Instruction::DEC, AddressingMode::ZeroPage, 0xC6, 5 },
+    { Instruction::DEC, AddressingMode::ZeroPageX, 0xD6, 6 },
+
+    { Instruction::DEX, AddressingMode::Implied, 0xCA, 2 },
+
+    { Instruction::DEY, AddressingMode::Implied, 0x88, 2 },
+
+    { Instruction::EOR, AddressingMode::Absolute, 0x4D, 4 },
+    { Instruction::EOR, AddressingMode::AbsoluteX, 0x5D, 4 },
+    { Instruction::EOR, AddressingMode::AbsoluteY, 0x59, 4 },
+    { Instruction::EOR, AddressingMode::Immediate, 0x49, 2 },
+    { Instruction::EOR, AddressingMode::IndirectX, 0x41, 6 },
+    { Instruction::EOR, AddressingMode::IndirectY, 0x51, 5 },
+    { Instruction::EOR, AddressingMode::ZeroPage, 0x45, 3 },
+    { Instruction::EOR, AddressingMode::ZeroPageX, 0x55, 4 },
+
+    { Instruction::INC, AddressingMode::Absolute, 0xEE, 6 },
+    { Instruction::INC, AddressingMode::AbsoluteX, 0xFE, 7 },
+    { Instruction::INC, AddressingMode::ZeroPage, 0xE6, 5 },
+    { Instruction::INC, AddressingMode::ZeroPageX, 0xF6, 6 },
+
+    { Instruction::INX, AddressingMode::Implied, 0xE8, 2 },
+
+    { Instruction::INY, AddressingMode::Implied, 0xC8, 2 },
+
+    { Instruction::JMP, AddressingMode::Absolute, 0x4C, 3 },
+    { Instruction::JMP, AddressingMode::Indirect, 0x6C, 5 },
+
+    { Instruction::JSR, AddressingMode::Absolute, 0x20, 6 },
+
+    { Instruction::LDA, AddressingMode::Absolute, 0xAD, 4 },
+    { Instruction::LDA, AddressingMode::AbsoluteX, 0xBD, 4 },
+    { Instruction::LDA, AddressingMode::AbsoluteY, 0xB9, 4 },
+    { Instruction::LDA, AddressingMode::Immediate, 0xA9, 2 },
+    { Instruction::LDA, AddressingMode::IndirectX, 0xA1, 6 },
+    { Instruction::LDA, AddressingMode::IndirectY, 0xB1, 5 },
+    { Instruction::LDA, AddressingMode::ZeroPage, 0xA5, 3 },
+    { Instruction::LDA, AddressingMode::ZeroPageX, 0xB5, 4 },
+
+    { Instruction::LDX, AddressingMode::Absolute, 0xAE, 4 },
+    { Instruction::LDX, AddressingMode::AbsoluteY, 0xBE, 4 },
+    { Instruction::LDX, AddressingMode::Immediate, 0xA2, 2 },
+    { Instruction::LDX, AddressingMode::ZeroPage, 0xA6, 3 },
+    { Instruction::LDX, AddressingMode::ZeroPageY, 0xB6, 4 },
 
-    { { "AND", AddressingMode::Absolute }, 0x2D },
-    { { "AND", AddressingMode::AbsoluteX }, 0x3D },
-    { { "AND", AddressingMode::AbsoluteY }, 0x39 },
-    { { "AND", AddressingMode::Immediate }, 0x29 },
-    { { "AND", AddressingMode::IndirectX }, 0x21 },
-    { { "AND", AddressingMode::IndirectY }, 0x31 },
-    { { "AND", AddressingMode::ZeroPage }, 0x25 },
-    { { "AND", AddressingMode::ZeroPageX }, 0x35 },
+    { Instruction::LDY, AddressingMode::Absolute, 0xAC, 4 },
+    { Instruction::LDY, AddressingMode::AbsoluteX, 0xBC, 4 },
+    { Instruction::LDY, AddressingMode::Immediate, 0xA0, 2 },
+    { Instruction::LDY, AddressingMode::ZeroPage, 0xA4, 3 },
+    { Instruction::LDY, AddressingMode::ZeroPageX, 0xB4, 4 },
 
-    { { "ASL", AddressingMode::Absolute }, 0x0E },
-    { { "ASL", AddressingMode::AbsoluteX }, 0x1E },
-    { { "ASL", AddressingMode::Accumulator }, 0x0A },
-    { { "ASL", AddressingMode::ZeroPage }, 0x06 },
-    { { "ASL", AddressingMode::ZeroPageX }, 0x16 },
+    { Instruction::LSR, AddressingMode::Absolute, 0x4E, 6 },
+    { Instruction::LSR, AddressingMode::AbsoluteX, 0x5E, 7 },
+    { Instruction::LSR, AddressingMode::Accumulator, 0x4A, 2 },
+    { Instruction::LSR, AddressingMode::ZeroPage, 0x46, 5 },
+    { Instruction::LSR, AddressingMode::ZeroPageX, 0x56, 6 },
 
-    { { "BCC", AddressingMode::Relative }, 0x90 },
+    { Instruction::NOP, AddressingMode::Implied, 0xEA, 2 },
 
-    { { "BCS", AddressingMode::Relative }, 0xB0 },
+    { Instruction::ORA, AddressingMode::Absolute, 0x0D, 4 },
+    { Instruction::ORA, AddressingMode::AbsoluteX, 0x1D, 4 },
+    { Instruction::ORA, AddressingMode::AbsoluteY, 0x19, 4 },
+    { Instruction::ORA, AddressingMode::Immediate, 0x09, 2 },
+    { Instruction::ORA, AddressingMode::IndirectX, 0x01, 6 },
+    { Instruction::ORA, AddressingMode::IndirectY, 0x11, 5 },
+    { Instruction::ORA, AddressingMode::ZeroPage, 0x05, 3 },
+    { Instruction::ORA, AddressingMode::ZeroPageX, 0x15, 4 },
 
-    { { "BEQ", AddressingMode::Relative }, 0xF0 },
+    { Instruction::PHA, AddressingMode::Implied, 0x48, 3 },
 
-    { { "BIT", AddressingMode::Absolute }, 0x2C },
-    { { "BIT", AddressingMode::ZeroPage }, 0x24 },
+    { Instruction::PHP, AddressingMode::Implied, 0x08, 3 },
 
-    { { "BMI", AddressingMode::Relative }, 0x30 },
+    { Instruction::PLA, AddressingMode::Implied, 0x68, 4 },
 
-    { { "BNE", AddressingMode::Relative }, 0xD0 },
+    { Instruction::PLP, AddressingMode::Implied, 0x28, 4 },
 
-    { { "BPL", AddressingMode::Relative }, 0x10 },
+    { Instruction::ROL, AddressingMode::Absolute, 0x2E, 6 },
+    { Instruction::ROL, AddressingMode::AbsoluteX, 0x3E, 7 },
+    { Instruction::ROL, AddressingMode::Accumulator, 0x2A, 2 },
+    { Instruction::ROL, AddressingMode::ZeroPage, 0x26, 5 },
+    { Instruction::ROL, AddressingMode::ZeroPageX, 0x36, 6 },
 
-    { { "BRK", AddressingMode::Implied }, 0x00 },
+    { Instruction::ROR, AddressingMode::Absolute, 0x6E, 6 },
+    { Instruction::ROR, AddressingMode::AbsoluteX, 0x7E, 7 },
+    { Instruction::ROR, AddressingMode::Accumulator, 0x6A, 2 },
+    { Instruction::ROR, AddressingMode::ZeroPage, 0x66, 5 },
+    { Instruction::ROR, AddressingMode::ZeroPageX, 0x76, 6 },
 
-    { { "BVC", AddressingMode::Relative }, 0x50 },
+    { Instruction::RTI, AddressingMode::Implied, 0x40, 6 },
 
-    { { "BVS", AddressingMode::Relative }, 0x70 },
+    { Instruction::RTS, AddressingMode::Implied, 0x60, 6 },
 
-    { { "CLC", AddressingMode::Implied }, 0x18 },
+    { Instruction::SBC, AddressingMode::Absolute, 0xED, 4 },
+    { Instruction::SBC, AddressingMode::AbsoluteX, 0xFD, 4 },
+    { Instruction::SBC, AddressingMode::AbsoluteY, 0xF9, 4 },
+    { Instruction::SBC, AddressingMode::Immediate, 0xE9, 2 },
+    { Instruction::SBC, AddressingMode::IndirectX, 0xE1, 6 },
+    { Instruction::SBC, AddressingMode::IndirectY, 0xF1, 5 },
+    { Instruction::SBC, AddressingMode::ZeroPage, 0xE5, 3 },
+    { Instruction::SBC, AddressingMode::ZeroPageX, 0xF5, 4 },
 
-    { { "CLD", AddressingMode::Implied }, 0xD8 },
+    { Instruction::SEC, AddressingMode::Implied, 0x38, 2 },
 
-    { { "CLI", AddressingMode::Implied }, 0x58 },
+    { Instruction::SED, AddressingMode::Implied, 0xF8, 2 },
 
-    { { "CLV", AddressingMode::Implied }, 0xB8 },
+    { Instruction::SEI, AddressingMode::Implied, 0x78, 2 },
 
-    { { "CMP", AddressingMode::Absolute }, 0xCD },
-    { { "CMP", AddressingMode::AbsoluteX }, 0xDD },
-    { { "CMP", AddressingMode::AbsoluteY }, 0xD9 },
-    { { "CMP", AddressingMode::Immediate }, 0xC9 },
-    { { "CMP", AddressingMode::IndirectX }, 0xC1 },
-    { { "CMP", AddressingMode::IndirectY }, 0xD1 },
-    { { "CMP", AddressingMode::ZeroPage }, 0xC5 },
-    { { "CMP", AddressingMode::ZeroPageX }, 0xD5 },
+    { Instruction::STA, AddressingMode::Absolute, 0x8D, 4 },
+    { Instruction::STA, AddressingMode::AbsoluteX, 0x9D, 5 },
+    { Instruction::STA, AddressingMode::AbsoluteY, 0x99, 5 },
+    { Instruction::STA, AddressingMode::IndirectX, 0x81, 6 },
+    { Instruction::STA, AddressingMode::IndirectY, 0x91, 6 },
+    { Instruction::STA, AddressingMode::ZeroPage, 0x85, 3 },
+    { Instruction::STA, AddressingMode::ZeroPageX, 0x95, 4 },
 
-    { { "CPX", AddressingMode::Absolute }, 0xEC },
-    { { "CPX", AddressingMode::Immediate }, 0xE0 },
-    { { "CPX", AddressingMode::ZeroPage }, 0xE4 },
+    { Instruction::STX, AddressingMode::Absolute, 0x8E, 4 },
+    { Instruction::STX, AddressingMode::ZeroPage, 0x86, 3 },
+    { Instruction::STX, AddressingMode::ZeroPageY, 0x96, 4 },
 
-    { { "CPY", AddressingMode::Absolute }, 0xCC },
-    { { "CPY", AddressingMode::Immediate }, 0xC0 },
-    { { "CPY", AddressingMode::ZeroPage }, 0xC4 },
+    { Instruction::STY, AddressingMode::Absolute, 0x8C, 4 },
+    { Instruction::STY, AddressingMode::ZeroPage, 0x84, 3 },
+    { Instruction::STY, AddressingMode::ZeroPageX, 0x94, 4 },
 
-    { { "DEC", AddressingMode::Absolute }, 0xCE },
-    { { "DEC", AddressingMode::AbsoluteX }, 0xDE },
-    { { "DEC", AddressingMode::ZeroPage }, 0xC6 },
-    { { "DEC", AddressingMode::ZeroPageX }, 0xD6 },
+    { Instruction::TAX, AddressingMode::Implied, 0xAA, 2 },
 
-    { { "DEI", AddressingMode::Implied }, 0x78 },
+    { Instruction::TAY, AddressingMode::Implied, 0xA8, 2 },
 
-    { { "DEX", AddressingMode::Implied }, 0xCA },
+    { Instruction::TSX, AddressingMode::Implied, 0xBA, 2 },
 
-    { { "DEY", AddressingMode::Implied }, 0x88 },
+    { Instruction::TXA, AddressingMode::Implied, 0x8A, 2 },
 
-    { { "EOR", AddressingMode::Absolute }, 0x4D },
-    { { "EOR", AddressingMode::AbsoluteX }, 0x5D },
-    { { "EOR", AddressingMode::AbsoluteY }, 0x59 },
-    { { "EOR", AddressingMode::Immediate }, 0x49 },
-    { { "EOR", AddressingMode::IndirectX }, 0x41 },
-    { { "EOR", AddressingMode::IndirectY }, 0x51 },
-    { { "EOR", AddressingMode::ZeroPage }, 0x45 },
-    { { "EOR", AddressingMode::ZeroPageX }, 0x55 },
+    { Instruction::TXS, AddressingMode::Implied, 0x9A, 2 },
 
-    { { "INC", AddressingMode::Absolute }, 0xEE },
-    { { "INC", AddressingMode::AbsoluteX }, 0xFE },
-    { { "INC", AddressingMode::ZeroPage }, 0xE6 },
-    { { "INC", AddressingMode::ZeroPageX }, 0xF6 },
+    { Instruction::TYA, AddressingMode::Implied, 0x98, 2 },
+};
+
+// stable undocumented opcodes of the NMOS part, the jams and the unstable stores and ANE/LXA stay invalid
+constexpr OpcodeEntry undocumentedEntries[] {
+    { Instruction::ALR, AddressingMode::Immediate, 0x4B, 2 },
+
+    { Instruction::ANC, AddressingMode::Immediate, 0x0B, 2 },
+    { Instruction::ANC, AddressingMode::Immediate, 0x2B, 2 },
+
+    { Instruction::ARR, AddressingMode::Immediate, 0x6B, 2 },
+
+    { Instruction::DCP, AddressingMode::Absolute, 0xCF, 6 },
+    { Instruction::DCP, AddressingMode::AbsoluteX, 0xDF, 7 },
+    { Instruction::DCP, AddressingMode::AbsoluteY, 0xDB, 7 },
+    { Instruction::DCP, AddressingMode::IndirectX, 0xC3, 8 },
+    { Instruction::DCP, AddressingMode::IndirectY, 0xD3, 8 },
+    { Instruction::DCP, AddressingMode::ZeroPage, 0xC7, 5 },
+    { Instruction::DCP, AddressingMode::ZeroPageX, 0xD7, 6 },
+
+    { Instruction::ISC, AddressingMode::Absolute, 0xEF, 6 },
+    { Instruction::ISC, AddressingMode::AbsoluteX, 0xFF, 7 },
+    { Instruction::ISC, AddressingMode::AbsoluteY, 0xFB, 7 },
+    { Instruction::ISC, AddressingMode::IndirectX, 0xE3, 8 },
+    { Instruction::ISC, AddressingMode::IndirectY, 0xF3, 8 },
+    { Instruction::ISC, AddressingMode::ZeroPage, 0xE7, 5 },
+    { Instruction::ISC, AddressingMode::ZeroPageX, 0xF7, 6 },
+
+    { Instruction::LAS, AddressingMode::AbsoluteY, 0xBB, 4 },
+
+    { Instruction::LAX, AddressingMode::Absolute, 0xAF, 4 },
+    { Instruction::LAX, AddressingMode::AbsoluteY, 0xBF, 4 },
+    { Instruction::LAX, AddressingMode::IndirectX, 0xA3, 6 },
+    { Instruction::LAX, AddressingMode::IndirectY, 0xB3, 5 },
+    { Instruction::LAX, AddressingMode::ZeroPage, 0xA7, 3 },
+    { Instruction::LAX, AddressingMode::ZeroPageY, 0xB7, 4 },
+
+    { Instruction::NOP, AddressingMode::Absolute, 0x0C, 4 },
+    { Instruction::NOP, AddressingMode::AbsoluteX, 0x1C, 4 },
+    { Instruction::NOP, AddressingMode::AbsoluteX, 0x3C, 4 },
+    { Instruction::NOP, AddressingMode::AbsoluteX, 0x5C, 4 },
+    { Instruction::NOP, AddressingMode::AbsoluteX, 0x7C, 4 },
+    { Instruction::NOP, AddressingMode::AbsoluteX, 0xDC, 4 },
+    { Instruction::NOP, AddressingMode::AbsoluteX, 0xFC, 4 },
+    { Instruction::NOP, AddressingMode::Immediate, 0x80, 2 },
+    { Instruction::NOP, AddressingMode::Immediate, 0x82, 2 },
+    { Instruction::NOP, AddressingMode::Immediate, 0x89, 2 },
+    { Instruction::NOP, AddressingMode::Immediate, 0xC2, 2 },
+    { Instruction::NOP, AddressingMode::Immediate, 0xE2, 2 },
+    { Instruction::NOP, AddressingMode::Implied, 0x1A, 2 },
+    { Instruction::NOP, AddressingMode::Implied, 0x3A, 2 },
+    { Instruction::NOP, AddressingMode::Implied, 0x5A, 2 },
+    { Instruction::NOP, AddressingMode::Implied, 0x7A, 2 },
+    { Instruction::NOP, AddressingMode::Implied, 0xDA, 2 },
+    { Instruction::NOP, AddressingMode::Implied, 0xFA, 2 },
+    { Instruction::NOP, AddressingMode::ZeroPage, 0x04, 3 },
+    { Instruction::NOP, AddressingMode::ZeroPage, 0x44, 3 },
+    { Instruction::NOP, AddressingMode::ZeroPage, 0x64, 3 },
+    { Instruction::NOP, AddressingMode::ZeroPageX, 0x14, 4 },
+    { Instruction::NOP, AddressingMode::ZeroPageX, 0x34, 4 },
+    { Instruction::NOP, AddressingMode::ZeroPageX, 0x54, 4 },
+    { Instruction::NOP, AddressingMode::ZeroPageX, 0x74, 4 },
+    { Instruction::NOP, AddressingMode::ZeroPageX, 0xD4, 4 },
+    { Instruction::NOP, AddressingMode::ZeroPageX, 0xF4, 4 },
+
+    { Instruction::RLA, AddressingMode::Absolute, 0x2F, 6 },
+    { Instruction::RLA, AddressingMode::AbsoluteX, 0x3F, 7 },
+    { Instruction::RLA, AddressingMode::AbsoluteY, 0x3B, 7 },
+    { Instruction::RLA, AddressingMode::IndirectX, 0x23, 8 },
+    { Instruction::RLA, AddressingMode::IndirectY, 0x33, 8 },
+    { Instruction::RLA, AddressingMode::ZeroPage, 0x27, 5 },
+    { Instruction::RLA, AddressingMode::ZeroPageX, 0x37, 6 },
+
+    { Instruction::RRA, AddressingMode::Absolute, 0x6F, 6 },
+    { Instruction::RRA, AddressingMode::AbsoluteX, 0x7F, 7 },
+    { Instruction::RRA, AddressingMode::AbsoluteY, 0x7B, 7 },
+    { Instruction::RRA, AddressingMode::IndirectX, 0x63, 8 },
+    { Instruction::RRA, AddressingMode::IndirectY, 0x73, 8 },
+    { Instruction::RRA, AddressingMode::ZeroPage, 0x67, 5 },
+    { Instruction::RRA, AddressingMode::ZeroPageX, 0x77, 6 },
+
+    { Instruction::SAX, AddressingMode::Absolute, 0x8F, 4 },
+    { Instruction::SAX, AddressingMode::IndirectX, 0x83, 6 },
+    { Instruction::SAX, AddressingMode::ZeroPage, 0x87, 3 },
+    { Instruction::SAX, AddressingMode::ZeroPageY, 0x97, 4 },
+
+    { Instruction::SBC, AddressingMode::Immediate, 0xEB, 2 },
+
+    { Instruction::SBX, AddressingMode::Immediate, 0xCB, 2 },
+
+    { Instruction::SLO, AddressingMode::Absolute, 0x0F, 6 },
+    { Instruction::SLO, AddressingMode::AbsoluteX, 0x1F, 7 },
+    { Instruction::SLO, AddressingMode::AbsoluteY, 0x1B, 7 },
+    { Instruction::SLO, AddressingMode::IndirectX, 0x03, 8 },
+    { Instruction::SLO, AddressingMode::IndirectY, 0x13, 8 },
+    { Instruction::SLO, AddressingMode::ZeroPage, 0x07, 5 },
+    { Instruction::SLO, AddressingMode::ZeroPageX, 0x17, 6 },
+
+    { Instruction::SRE, AddressingMode::Absolute, 0x4F, 6 },
+    { Instruction::SRE, AddressingMode::AbsoluteX, 0x5F, 7 },
+    { Instruction::SRE, AddressingMode::AbsoluteY, 0x5B, 7 },
+    { Instruction::SRE, AddressingMode::IndirectX, 0x43, 8 },
+    { Instruction::SRE, AddressingMode::IndirectY, 0x53, 8 },
+    { Instruction::SRE, AddressingMode::ZeroPage, 0x47, 5 },
+    { Instruction::SRE, AddressingMode::ZeroPageX, 0x57, 6 },
+};
+
+// what the 65C02 adds to or changes in the documented set, the opcodes it leaves open stay invalid
+constexpr OpcodeEntry cmosEntries[] {
+    { Instruction::ADC, AddressingMode::ZeroPageIndirect, 0x72, 5 },
+    { Instruction::AND, AddressingMode::ZeroPageIndirect, 0x32, 5 },
+    { Instruction::ASL, AddressingMode::AbsoluteX, 0x1E, 6 },
+
+    { Instruction::BIT, AddressingMode::AbsoluteX, 0x3C, 4 },
+    { Instruction::BIT, AddressingMode::Immediate, 0x89, 2 },
+    { Instruction::BIT, AddressingMode::ZeroPageX, 0x34, 4 },
+
+    { Instruction::BRA, AddressingMode::Relative, 0x80, 3 },
+
+    { Instruction::CMP, AddressingMode::ZeroPageIndirect, 0xD2, 5 },
+    { Instruction::DEC, AddressingMode::Accumulator, 0x3A, 2 },
+    { Instruction::EOR, AddressingMode::ZeroPageIndirect, 0x52, 5 },
+    { Instruction::INC, AddressingMode::Accumulator, 0x1A, 2 },
+
+    { Instruction::JMP, AddressingMode::AbsoluteIndirectX, 0x7C, 6 },
+    { Instruction::JMP, AddressingMode::Indirect, 0x6C, 6 },
+
+    { Instruction::LDA, AddressingMode::ZeroPageIndirect, 0xB2, 5 },
+    { Instruction::LSR, AddressingMode::AbsoluteX, 0x5E, 6 },
+    { Instruction::ORA, AddressingMode::ZeroPageIndirect, 0x12, 5 },
 
-    { { "INX", AddressingMode::Implied }, 0xE8 },
+    { Instruction::PHX, AddressingMode::Implied, 0xDA, 3 },
+    { Instruction::PHY, AddressingMode::Implied, 0x5A, 3 },
+    { Instruction::PLX, AddressingMode::Implied, 0xFA, 4 },
+    { Instruction::PLY, AddressingMode::Implied, 0x7A, 4 },
 
-    { { "INY", AddressingMode::Implied }, 0xC8 },
+    { Instruction::ROL, AddressingMode::AbsoluteX, 0x3E, 6 },
+    { Instruction::ROR, AddressingMode::AbsoluteX, 0x7E, 6 },
+    { Instruction::SBC, AddressingMode::ZeroPageIndirect, 0xF2, 5 },
+    { Instruction::STA, AddressingMode::ZeroPageIndirect, 0x92, 5 },
 
-    { { "JMP", AddressingMode::Absolute }, 0x4C },
-    { { "JMP", AddressingMode::Indirect }, 0x6C },
+    { Instruction::STZ, AddressingMode::Absolute, 0x9C, 4 },
+    { Instruction::STZ, AddressingMode::AbsoluteX, 0x9E, 5 },
+    { Instruction::STZ, AddressingMode::ZeroPage, 0x64, 3 },
+    { Instruction::STZ, AddressingMode::ZeroPageX, 0x74, 4 },
 
-    { { "JSR", AddressingMode::Absolute }, 0x20 },
+    { Instruction::TRB, AddressingMode::Absolute, 0x1C, 6 },
+    { Instruction::TRB, AddressingMode::ZeroPage, 0x14, 5 },
 
-    { { "LDA", AddressingMode::Absolute }, 0xAD },
-    { { "LDA", AddressingMode::AbsoluteX }, 0xBD },
-    { { "LDA", AddressingMode::AbsoluteY }, 0xBA },
-    { { "LDA", AddressingMode::Immediate }, 0xA9 },
-    { { "LDA", AddressingMode::IndirectX }, 0xA1 },
-    { { "LDA", AddressingMode::IndirectY }, 0xB1 },
-    { { "LDA", AddressingMode::ZeroPage }, 0xA5 },
-    { { "LDA", AddressingMode::ZeroPageX }, 0xB5 },
+    { Instruction::TSB, AddressingMode::Absolute, 0x0C, 6 },
+    { Instruction::TSB, AddressingMode::ZeroPage, 0x04, 5 },
+};
+
+constexpr size_t instructionCount = static_cast<size_t>(Instruction::TSB) + 1;
+constexpr size_t addressingModeCount = static_cast<size_t>(AddressingMode::ZeroPageY) + 1;
 
-    { { "LDX", AddressingMode::Absolute }, 0xAE },
-    { { "LDX", AddressingMode::AbsoluteY }, 0xBE },
-    { { "LDX", AddressingMode::Immediate }, 0xA2 },
-    { { "LDX", AddressingMode::ZeroPage }, 0xA6 },
-    { { "LDX", AddressingMode::ZeroPageY }, 0xB6 },
+constexpr uint16_t noOpcode = 0x100;
 
-    { { "LDY", AddressingMode::Absolute }, 0xAC },
-    { { "LDY", AddressingMode::AbsoluteX }, 0xBC },
-    { { "LDY", AddressingMode::Immediate }, 0xA0 },
-    { { "LDY", AddressingMode::ZeroPage }, 0xA4 },
-    { { "LDY", AddressingMode::ZeroPageX }, 0xB4 },
+typedef std::array<std::array<uint16_t, addressingModeCount>, instructionCount> OpcodeTable;
 
-    { { "LSR", AddressingMode::Absolute }, 0x4E },
-    { { "LSR", AddressingMode::AbsoluteX }, 0x5E },
-    { { "LSR", AddressingMode::Accumulator }, 0x4A },
-    { { "LSR", AddressingMode::ZeroPage }, 0x46 },
-    { { "LSR", AddressingMode::ZeroPageX }, 0x56 },
+// table[instruction][mode] is the opcode byte or noOpcode, the first entry wins where several opcodes do the same
+constexpr OpcodeTable makeOpcodeTable (std::initializer_list<std::span<const OpcodeEntry>> entryLists) {
+    OpcodeTable table {};
 
-    { { "NOP", AddressingMode::Implied }, 0xEA },
+    for (auto& modes : table) {
+        modes.fill(noOpcode);
+    }
+
+    for (const auto entries : entryLists) {
+        for (const auto& entry : entries) {
+            auto& opcode = table[static_cast<size_t>(entry.instruction)][static_cast<size_t>(entry.mode)];
+            opcode = opcode == noOpcode ? entry.opcode : opcode;
+        }
+    }
+
+    return table;
+}
+
+struct OpcodeInfo {
+    Instruction instruction;
+    AddressingMode mode;
+    uint8_t cycles;
+    bool valid;
+};
 
-    { { "ORA", AddressingMode::Absolute }, 0x0D },
-    { { "ORA", AddressingMode::AbsoluteX }, 0x1D },
-    { { "ORA", AddressingMode::AbsoluteY }, 0x19 },
-    { { "ORA", AddressingMode::Immediate }, 0x09 },
-    { { "ORA", AddressingMode::IndirectX }, 0x01 },
-    { { "ORA", AddressingMode::IndirectY }, 0x11 },
-    { { "ORA", AddressingMode::ZeroPage }, 0x05 },
-    { { "ORA", AddressingMode::ZeroPageX }, 0x15 },
+typedef std::array<OpcodeInfo, 256> OpcodeInfos;
 
-    { { "PHA", AddressingMode::Implied }, 0x48 },
+// the reverse of the opcode table, indexed by opcode byte, later lists override earlier ones
+constexpr OpcodeInfos makeOpcodeInfos (std::initializer_list<std::span<const OpcodeEntry>> entryLists) {
+    OpcodeInfos infos {};
 
-    { { "PHP", AddressingMode::Implied }, 0x08 },
+    // opcodes missing from the table take no operand
+    infos.fill({ Instruction::NOP, AddressingMode::Implied, 0, false });
 
-    { { "PLA", AddressingMode::Implied }, 0x68 },
+    for (const auto entries : entryLists) {
+        for (const auto& entry : entries) {
+            infos[entry.opcode] = { entry.instruction, entry.mode, entry.cycles, true };
+        }
+    }
 
-    { { "PLP", AddressingMode::Implied }, 0x28 },
+    return infos;
+}
 
-    { { "ROL", AddressingMode::Absolute }, 0x2E },
-    { { "ROL", AddressingMode::AbsoluteX }, 0x3E },
-    { { "ROL", AddressingMode::Accumulator }, 0x2A },
-    { { "ROL", AddressingMode::ZeroPage }, 0x26 },
-    { { "ROL", AddressingMode::ZeroPageX }, 0x36 },
+// cpu variants, each with its own compile-time tables, the core, assembler and disassembler are templates over them
+struct Nmos6502 {
+    static constexpr bool cmos = false;
+    static constexpr auto infos = makeOpcodeInfos({ opcodeEntries });
+    static constexpr auto table = makeOpcodeTable({ opcodeEntries });
+};
 
-    { { "ROR", AddressingMode::Absolute }, 0x6E },
-    { { "ROR", AddressingMode::AbsoluteX }, 0x7E },
-    { { "ROR", AddressingMode::Accumulator }, 0x6A },
-    { { "ROR", AddressingMode::ZeroPage }, 0x66 },
-    { { "ROR", AddressingMode::ZeroPageX }, 0x76 },
+struct Nmos6502Undocumented {
+    static constexpr bool cmos = false;
+    static constexpr auto infos = makeOpcodeInfos({ opcodeEntries, undocumentedEntries });
+    static constexpr auto table = makeOpcodeTable({ opcodeEntries, undocumentedEntries });
+};
 
-    { { "RTI", AddressingMode::Implied }, 0x40 },
+struct Cmos65C02 {
+    static constexpr bool cmos = true;
+    // the opcodes the 65C02 leaves open are NOPs on the real part, they stay invalid here so that programs can still halt
+    static constexpr auto infos = makeOpcodeInfos({ opcodeEntries, cmosEntries });
+    static constexpr auto table = makeOpcodeTable({ opcodeEntries, cmosEntries });
+};
 
-    { { "RTS", AddressingMode::Implied }, 0x60 },
+template <typename Variant>
+constexpr std::optional<uint8_t> findOpcode (Instruction instruction, AddressingMode mode) {
+    const auto opcode = Variant::table[static_cast<size_t>(instruction)][static_cast<size_t>(mode)];
 
-    { { "SBC", AddressingMode::Absolute }, 0xED },
-    { { "SBC", AddressingMode::AbsoluteX }, 0xFD },
-    { { "SBC", AddressingMode::AbsoluteY }, 0xF9 },
-    { { "SBC", AddressingMode::Immediate }, 0xE9 },
-    { { "SBC", AddressingMode::IndirectX }, 0xE1 },
-    { { "SBC", AddressingMode::IndirectY }, 0xF1 },
-    { { "SBC", AddressingMode::ZeroPage }, 0xE5 },
-    { { "SBC", AddressingMode::ZeroPageX }, 0xF5 },
+    if (opcode == noOpcode) {
+        return std::nullopt;
+    }
 
-    { { "SEC", AddressingMode::Implied }, 0x38 },
+    return static_cast<uint8_t>(opcode);
+}
 
-    { { "SED", AddressingMode::Implied }, 0xF8 },
+// whether the variant has the instruction at all, in any addressing mode
+template <typename Variant>
+constexpr bool hasInstruction (Instruction instruction) {
+    for (const auto opcode : Variant::table[static_cast<size_t>(instruction)]) {
+        if (opcode != noOpcode) {
+            return true;
+        }
+    }
 
-    { { "STA", AddressingMode::Absolute }, 0x8D },
-    { { "STA", AddressingMode::AbsoluteX }, 0x9D },
-    { { "STA", AddressingMode::AbsoluteY }, 0x99 },
-    { { "STA", AddressingMode::IndirectX }, 0x81 },
-    { { "STA", AddressingMode::IndirectY }, 0x91 },
-    { { "STA", AddressingMode::ZeroPage }, 0x85 },
-    { { "STA", AddressingMode::ZeroPageX }, 0x95 },
+    return false;
+}
 
-    { { "STX", AddressingMode::Absolute }, 0x8E },
-    { { "STX", AddressingMode::ZeroPage }, 0x86 },
-    { { "STX", AddressingMode::ZeroPageY }, 0x96 },
+// mnemonics are three upper case letters, 5 bits each
+constexpr uint16_t packMnemonic (std::string_view name) {
+    return ((name[0] - 'A') << 10) | ((name[1] - 'A') << 5) | (name[2] - 'A');
+}
 
-    { { "STY", AddressingMode::Absolute }, 0x8C },
-    { { "STY", AddressingMode::ZeroPage }, 0x84 },
-    { { "STY", AddressingMode::ZeroPageX }, 0x94 },
+constexpr size_t mnemonicSlotBits = 10;
 
-    { { "TAX", AddressingMode::Implied }, 0xAA },
+constexpr size_t mnemonicSlot (uint16_t packed, uint32_t seed) {
+    return static_cast<uint32_t>(packed * seed) >> (32 - mnemonicSlotBits);
+}
 
-    { { "TAY", AddressingMode::Implied }, 0xA8 },
+// the first multiplier in a fixed pseudo-random sequence that sends every mnemonic to its own slot
+constexpr uint32_t mnemonicSeed = [] {
+    for (uint32_t seed = 0x9E3779B1; ; seed = (seed * 1664525 + 1013904223) | 1) {
+        std::array<bool, 1 << mnemonicSlotBits> taken {};
+        auto collides = false;
 
-    { { "TSX", AddressingMode::Implied }, 0xB9 },
+        for (const auto name : instructionNames) {
+            auto& slot = taken[mnemonicSlot(packMnemonic(name), seed)];
+            collides = collides || slot;
+            slot = true;
+        }
 
-    { { "TXA", AddressingMode::Implied }, 0x89 },
+        if (!collides) {
+            return seed;
+        }
+    }
+}();
 
-    { { "TXS", AddressingMode::Implied }, 0x9A },
+constexpr uint16_t noMnemonic = 0xFFFF;
 
-    { { "TYA", AddressingMode::Implied }, 0x98 },
+struct MnemonicSlot {
+    uint16_t packed;
+    Instruction instruction;
 };
 
-static const std::unordered_set<std::string> insNames = [] {
-    std::unordered_set<std::string> names;
+constexpr auto mnemonicSlots = [] {
+    std::array<MnemonicSlot, 1 << mnemonicSlotBits> slots {};
+
+    for (auto& slot : slots) {
+        slot.packed = noMnemonic;
+    }
 
-    for (const auto& entry : opcodes) {
-        names.insert(entry.first.name);
+    for (size_t index = 0; index < instructionCount; index++) {
+        const auto packed = packMnemonic(instructionNames[index]);
+        slots[mnemonicSlot(packed, mnemonicSeed)] = { packed, static_cast<Instruction>(index) };
     }
 
-    return names;
+    return slots;
 }();
 
+constexpr std::optional<Instruction> findInstruction (std::string_view name) {
+    if (name.size() != 3) {
+        return std::nullopt;
+    }
+
+    for (const auto ch : name) {
+        if (ch < 'A' || ch > 'Z') {
+            return std::nullopt;
+        }
+    }
+
+    const auto packed = packMnemonic(name);
+    const auto& slot = mnemonicSlots[mnemonicSlot(packed, mnemonicSeed)];
+
+    if (slot.packed != packed) {
+        return std::nullopt;
+    }
+
+    return slot.instruction;
+}
+
+static_assert(findInstruction("LDA") == Instruction::LDA);
+static_assert(findInstruction("LDB") == std::nullopt);
+static_assert(findOpcode<Nmos6502>(Instruction::LDA, AddressingMode::Immediate) == 0xA9);
+static_assert(findOpcode<Nmos6502>(Instruction::STZ, AddressingMode::ZeroPage) == std::nullopt);
+static_assert(findOpcode<Cmos65C02>(Instruction::STZ, AddressingMode::ZeroPage) == 0x64);
+static_assert(findOpcode<Nmos6502Undocumented>(Instruction::SBC, AddressingMode::Immediate) == 0xE9);
+static_assert(Nmos6502::infos[0xA9].instruction == Instruction::LDA);
+static_assert(!Nmos6502::infos[0xA7].valid && Nmos6502Undocumented::infos[0xA7].instruction == Instruction::LAX);
+
 
 
 #endif //OPCODES_H
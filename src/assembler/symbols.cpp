@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#include "symbols.h"
+
+
+void sortSymbols (std::vector<Symbol>& symbols) {
+    std::sort(symbols.begin(), symbols.end(), [] (const Symbol& left, const Symbol& right) {
+        return left.address != right.address ? left.address < right.address : left.name < right.name;
+    });
+}
+
+std::vector<Symbol> makeSymbols (const Labels& labels, uint16_t origin) {
+    std::vector<Symbol> symbols;
+
+    for (const auto& [name, offset] : labels) {
+        symbols.push_back({ static_cast<uint16_t>(origin + offset), name });
+    }
+
+    sortSymbols(symbols);
+    return symbols;
+}
+
+std::string formatSymbols (const std::vector<Symbol>& symbols) {
+    std::string text;
+
+    for (const auto& symbol : symbols) {
+        char address[6];
+        snprintf(address, sizeof(address), "%04x ", symbol.address);
+        text += address + symbol.name + "\n";
+    }
+
+    return text;
+}
+
+bool readSymbols (const std::string& path, std::vector<Symbol>& symbols) {
+    std::ifstream file { path };
+
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string line;
+
+    while (std::getline(file, line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        char* end;
+        const auto address = strtoul(line.c_str(), &end, 16);
+
+        if (end == line.c_str() || *end != ' ' || end[1] == '\0' || address > 0xffff) {
+            return false;
+        }
+
+        symbols.push_back({ static_cast<uint16_t>(address), std::string { end + 1 } });
+    }
+
+    sortSymbols(symbols);
+    return true;
+}
+
+const Symbol* findSymbol (const std::vector<Symbol>& symbols, uint16_t address) {
+    const auto after = std::upper_bound(symbols.begin(), symbols.end(), address, [] (uint16_t address, const Symbol& symbol) {
+        return address < symbol.address;
+    });
+
+    return after == symbols.begin() ? nullptr : &*(after - 1);
+}
@@ -0,0 +1,31 @@
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "asm.h"
+
+
+
+struct Symbol {
+    uint16_t address;
+    std::string name;
+};
+
+// the labels of a program loaded at origin, in address order
+std::vector<Symbol> makeSymbols (const Labels&, uint16_t origin);
+
+// a symbol file has one "<hex address> <name>" line per label
+std::string formatSymbols (const std::vector<Symbol>&);
+
+// false when the file is missing or a line is malformed, the symbols come back in address order
+bool readSymbols (const std::string& path, std::vector<Symbol>& symbols);
+
+// the last symbol at or below the address, null when there is none
+const Symbol* findSymbol (const std::vector<Symbol>&, uint16_t address);
+
+
+
+#endif //SYMBOLS_H
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <fstream>
+#include <memory>
+
+#include "emulator/cpu.h"
+#include "emulator/savestate.h"
+#include "emulator/Timer.h"
+
+#include "batch.h"
+#include "lockstep.h"
+#include "parallel.h"
+
+
+bool loadFile (const std::string& binaryFile, Machine& machine) {
+    std::ifstream file { binaryFile, std::ios::binary };
+    const std::vector<uint8_t> bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+    if (!file.is_open() || !load(machine, bytes)) {
+        return false;
+    }
+
+    reset(machine);
+    return true;
+}
+
+BatchResult resultOf (const Machine& machine) {
+    return {
+        machine.halted ? BatchStatus::Halted : BatchStatus::BudgetExhausted,
+        machine.cpu,
+        machine.cycles,
+        machine.instructions,
+        memoryDigest(machine),
+        machine.bus.slowReads + machine.bus.slowWrites,
+        machine.idle.skippedCycles,
+    };
+}
+
+// the binary's path with its separators flattened, so that binaries of the same name in different directories keep apart
+std::string stateFileOf (const std::string& binaryFile, const BatchOptions& options) {
+    if (options.stateDirectory.empty()) {
+        return {};
+    }
+
+    auto name = binaryFile;
+    std::replace(name.begin(), name.end(), '/', '_');
+
+    return options.stateDirectory + "/" + name + ".state";
+}
+
+BatchResult runOne (const std::string& binaryFile, const BatchOptions& options) {
+    const auto machine = std::make_unique<Machine>();
+
+    if (!loadFile(binaryFile, *machine)) {
+        return { BatchStatus::LoadFailed };
+    }
+
+    machine->engine = options.engine;
+    machine->flags = options.flags;
+    machine->accuracy = options.accuracy;
+    machine->variant = options.variant;
+    machine->idle.skip = options.skipIdle;
+
+    Timer timer;
+
+    if (options.timer) {
+        attachTimer(*machine, timer);
+    }
+
+    const StateDevices devices { options.timer ? &timer : nullptr };
+    const auto statePath = stateFileOf(binaryFile, options);
+    std::vector<uint8_t> state;
+
+    // no state yet means a fresh start, one that does not load means something else wrote it
+    if (!statePath.empty() && readStateFile(statePath, state) && !loadState(*machine, devices, state)) {
+        fprintf(stderr, "%s is not a state of %s\n", statePath.c_str(), binaryFile.c_str());
+        return { BatchStatus::LoadFailed };
+    }
+
+    const auto& counter = options.unit == BudgetUnit::Cycles ? machine->cycles : machine->instructions;
+    const auto slice = options.checkpointInterval == 0 ? options.budget : options.checkpointInterval;
+
+    while (counter < options.budget && !machine->halted) {
+        const auto left = std::min(slice, options.budget - counter);
+
+        if (options.unit == BudgetUnit::Cycles) {
+            runCycles(*machine, left);
+        } else {
+            runInstructions(*machine, left);
+        }
+
+        if (!statePath.empty()) {
+            saveState(*machine, devices, state);
+
+            if (!writeStateFile(statePath, state)) {
+                fprintf(stderr, "cannot write %s\n", statePath.c_str());
+            }
+        }
+    }
+
+    return resultOf(*machine);
+}
+
+// binaries first..first+laneCount share one set of lanes
+void runGroup (const std::vector<std::string>& binaryFiles, size_t first, const BatchOptions& options, std::vector<BatchResult>& results) {
+    const auto lanes = std::make_unique<Lanes>();
+    const auto count = std::min(laneCount, binaryFiles.size() - first);
+
+    for (size_t lane = 0; lane < count; lane++) {
+        const auto machine = std::make_unique<Machine>();
+
+        if (loadFile(binaryFiles[first + lane], *machine)) {
+            loadLane(*lanes, lane, *machine);
+        }
+    }
+
+    const auto machine = std::make_unique<Machine>();
+
+    runLockstep(*lanes, options.budget, options.unit == BudgetUnit::Cycles);
+
+    for (size_t lane = 0; lane < count; lane++) {
+        if (lanes->used & (1u << lane)) {
+            storeLane(*lanes, lane, *machine);
+            results[first + lane] = resultOf(*machine);
+        } else {
+            results[first + lane] = { BatchStatus::LoadFailed };
+        }
+    }
+}
+
+std::vector<BatchResult> runBatch (const std::vector<std::string>& binaryFiles, const BatchOptions& options) {
+    std::vector<BatchResult> results(binaryFiles.size());
+
+    if (options.lockstep) {
+        const auto groupCount = (binaryFiles.size() + laneCount - 1) / laneCount;
+
+        parallelFor(groupCount, options.threadCount, [&] (size_t group) {
+            runGroup(binaryFiles, group * laneCount, options, results);
+        });
+
+        return results;
+    }
+
+    parallelFor(binaryFiles.size(), options.threadCount, [&] (size_t index) {
+        results[index] = runOne(binaryFiles[index], options);
+    });
+
+    return results;
+}
+
+std::string formatReport (const std::vector<std::string>& binaryFiles, const std::vector<BatchResult>& results) {
+    std::string report = "# status  pc   a  x  y  sp p  cycles instructions memory-digest file\n";
+
+    for (size_t index = 0; index < results.size(); index++) {
+        const auto& result = results[index];
+        char line[256];
+
+        if (result.status == BatchStatus::LoadFailed) {
+            snprintf(line, sizeof(line), "error   -    -  -  -  -  -  - - - %s\n", binaryFiles[index].c_str());
+            report += line;
+            continue;
+        }
+
+        snprintf(
+            line, sizeof(line), "%s %04x %02x %02x %02x %02x %02x %llu %llu %016llx ",
+            result.status == BatchStatus::Halted ? "halted " : "budget ",
+            result.cpu.pc, result.cpu.a, result.cpu.x, result.cpu.y, result.cpu.sp, result.cpu.p,
+            static_cast<unsigned long long>(result.cycles),
+            static_cast<unsigned long long>(result.instructions),
+            static_cast<unsigned long long>(result.memoryDigest)
+        );
+
+        report += line + binaryFiles[index] + '\n';
+    }
+
+    return report;
+}
@@ -0,0 +1,68 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "emulator/Machine.h"
+
+
+
+enum class BatchStatus : uint8_t {
+    Halted,
+    BudgetExhausted,
+    LoadFailed,
+};
+
+enum class BudgetUnit : uint8_t {
+    Instructions,
+    Cycles,
+};
+
+struct BatchOptions {
+    uint64_t budget;
+    BudgetUnit unit;
+    size_t threadCount;
+    Engine engine;
+    FlagEvaluation flags;
+    Accuracy accuracy;
+    CpuVariant variant;
+
+    // runs groups of laneCount binaries in vector lanes instead of one machine per binary
+    bool lockstep;
+
+    // maps a Timer at timerPage on every machine
+    bool timer;
+
+    // off to run idle loops trip by trip, as when comparing engine speeds
+    bool skipIdle;
+
+    // when set, each binary resumes from its state there and saves it again every checkpointInterval
+    // of the budget's unit and at the end, the budget counts from reset either way
+    std::string stateDirectory;
+    uint64_t checkpointInterval;
+};
+
+struct BatchResult {
+    BatchStatus status = BatchStatus::LoadFailed;
+    Cpu cpu {};
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t memoryDigest = 0;
+
+    // loads and stores that left the page table's fast path
+    uint64_t slowAccesses = 0;
+
+    // spent in idle loops without running them, included in cycles
+    uint64_t skippedCycles = 0;
+};
+
+// every binary runs on its own headless machine until it halts or its budget runs out
+std::vector<BatchResult> runBatch (const std::vector<std::string>& binaryFiles, const BatchOptions&);
+
+std::string formatReport (const std::vector<std::string>& binaryFiles, const std::vector<BatchResult>&);
+
+
+
+#endif //BATCH_H
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+#include "emulator/cpu.h"
+
+#include "bench.h"
+
+
+BenchResult benchOne (const std::string& program, const std::vector<uint8_t>& bytes, const BenchOptions& options, Engine engine) {
+    BenchResult result { program, engine, false, false, 0, 0, 0, 0, 0, 0 };
+    std::vector<double> seconds;
+
+    for (uint32_t repetition = 0; repetition < options.repetitions; repetition++) {
+        const auto machine = std::make_unique<Machine>();
+
+        if (!load(*machine, bytes)) {
+            return result;
+        }
+
+        reset(*machine);
+        machine->engine = engine;
+
+        // the speeds compare instructions that were actually run, idle loops included
+        machine->idle.skip = false;
+
+        runCycles(*machine, options.warmupCycles);
+
+        const auto cycles = machine->cycles;
+        const auto instructions = machine->instructions;
+        const auto start = std::chrono::steady_clock::now();
+        runCycles(*machine, options.cycleBudget);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        seconds.push_back(elapsed.count());
+        result.loaded = true;
+        result.halted = machine->halted;
+        result.cycles = machine->cycles - cycles;
+        result.instructions = machine->instructions - instructions;
+        result.memoryDigest = memoryDigest(*machine);
+    }
+
+    std::sort(seconds.begin(), seconds.end());
+
+    if (!seconds.empty()) {
+        result.seconds = seconds.size() % 2 == 1 ? seconds[seconds.size() / 2] : (seconds[seconds.size() / 2 - 1] + seconds[seconds.size() / 2]) / 2;
+        result.fastest = seconds.front();
+        result.slowest = seconds.back();
+    }
+
+    return result;
+}
+
+std::vector<BenchResult> runBench (const std::string& program, const std::vector<uint8_t>& bytes, const BenchOptions& options) {
+    std::vector<BenchResult> results;
+
+    for (const auto& [engine, name] : engineNames) {
+        if (options.engines.empty() || std::find(options.engines.begin(), options.engines.end(), engine) != options.engines.end()) {
+            results.push_back(benchOne(program, bytes, options, engine));
+        }
+    }
+
+    return results;
+}
+
+std::string formatBench (const BenchOptions& options, const std::vector<BenchResult>& results) {
+    char line[512];
+
+    snprintf(
+        line, sizeof(line), "# cycles %llu warmup %llu repetitions %u\n",
+        static_cast<unsigned long long>(options.cycleBudget), static_cast<unsigned long long>(options.warmupCycles), options.repetitions
+    );
+
+    std::string report = line;
+    report += "# program engine status cycles instructions seconds fastest slowest ips cps ns-per-instruction relative memory-digest\n";
+
+    // relative speed is against the first engine run on the same program, the plain interpreter unless left out
+    const BenchResult* baseline = nullptr;
+
+    for (const auto& result : results) {
+        const auto name = getName(result.engine);
+
+        if (baseline == nullptr || baseline->program != result.program) {
+            baseline = &result;
+        }
+
+        if (!result.loaded) {
+            snprintf(line, sizeof(line), "%s %.*s error\n", result.program.c_str(), static_cast<int>(name.size()), name.data());
+            report += line;
+            continue;
+        }
+
+        const auto ips = result.instructions / result.seconds;
+        const auto baselineIps = baseline->loaded ? baseline->instructions / baseline->seconds : ips;
+
+        snprintf(
+            line, sizeof(line), "%s %.*s %s %llu %llu %.6f %.6f %.6f %.0f %.0f %.3f %.2f %016llx\n",
+            result.program.c_str(), static_cast<int>(name.size()), name.data(), result.halted ? "halted" : "ok",
+            static_cast<unsigned long long>(result.cycles), static_cast<unsigned long long>(result.instructions),
+            result.seconds, result.fastest, result.slowest,
+            ips, result.cycles / result.seconds, 1e9 * result.seconds / result.instructions, ips / baselineIps,
+            static_cast<unsigned long long>(result.memoryDigest)
+        );
+
+        report += line;
+    }
+
+    return report;
+}
@@ -0,0 +1,55 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "emulator/Machine.h"
+
+
+
+// what bench runs when given no programs, paths from the top of the repository
+constexpr const char* benchSamples[] {
+    "samples/bench/alu.htr",
+    "samples/bench/memcopy.htr",
+    "samples/bench/branches.htr",
+    "samples/bench/functional.htr",
+};
+
+struct BenchOptions {
+    uint64_t cycleBudget;
+    uint64_t warmupCycles;
+    uint32_t repetitions;
+
+    // every engine in this build when empty
+    std::vector<Engine> engines;
+};
+
+struct BenchResult {
+    std::string program;
+    Engine engine;
+    bool loaded;
+    bool halted;
+
+    // those of one timed run, which are the same for every repetition
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t memoryDigest;
+
+    // the median of the repetitions, and the fastest and slowest of them
+    double seconds;
+    double fastest;
+    double slowest;
+};
+
+// each repetition runs the program on a fresh machine for the warmup cycles, which fill the block cache and the jit,
+// and then for the cycle budget, which is timed, on every engine one after another
+std::vector<BenchResult> runBench (const std::string& program, const std::vector<uint8_t>& bytes, const BenchOptions&);
+
+// a header of the options and the columns, then a line per program and engine, all separated by single spaces
+std::string formatBench (const BenchOptions&, const std::vector<BenchResult>&);
+
+
+
+#endif //BENCH_H
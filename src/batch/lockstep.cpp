@@ -0,0 +1,664 @@
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include "assembler/opcodes.h"
+#include "emulator/cpu.h"
+#include "emulator/instructions.h"
+
+#include "lockstep.h"
+
+
+typedef int8_t LaneFlags __attribute__((vector_size(laneCount)));
+typedef int16_t LaneWideFlags __attribute__((vector_size(laneCount * 2)));
+
+const LaneWords laneBits { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768 };
+
+LaneBytes splat (uint8_t value) {
+    return LaneBytes {} + value;
+}
+
+LaneWords splatWord (uint16_t value) {
+    return LaneWords {} + value;
+}
+
+LaneWords widen (LaneBytes value) {
+    return __builtin_convertvector(value, LaneWords);
+}
+
+LaneBytes narrow (LaneWords value) {
+    return __builtin_convertvector(value, LaneBytes);
+}
+
+// comparison results are all ones or all zeros per lane
+LaneBytes bits (LaneFlags flags) {
+    return std::bit_cast<LaneBytes>(flags);
+}
+
+LaneBytes maskOf (LaneSet set) {
+    const LaneWideFlags wide = (splatWord(set) & laneBits) != 0;
+    return bits(__builtin_convertvector(wide, LaneFlags));
+}
+
+LaneWords widenMask (LaneBytes mask) {
+    return std::bit_cast<LaneWords>(__builtin_convertvector(std::bit_cast<LaneFlags>(mask), LaneWideFlags));
+}
+
+LaneBytes blend (LaneBytes mask, LaneBytes value, LaneBytes old) {
+    return (value & mask) | (old & ~mask);
+}
+
+LaneWords blend (LaneWords mask, LaneWords value, LaneWords old) {
+    return (value & mask) | (old & ~mask);
+}
+
+LaneSet setOf (LaneBytes mask) {
+    uint64_t halves[2];
+    memcpy(halves, &mask, sizeof(halves));
+
+    // moves the top bit of each byte into one byte, lane order preserved
+    const auto pack = [] (uint64_t half) {
+        return static_cast<LaneSet>(((half & 0x8080808080808080) * 0x0002040810204081) >> 56);
+    };
+
+    return pack(halves[0]) | pack(halves[1]) << 8;
+}
+
+LaneBytes narrowMask (LaneWideFlags mask) {
+    return bits(__builtin_convertvector(mask, LaneFlags));
+}
+
+// all lanes' copies of one address are contiguous, so shared addresses need a single vector access
+LaneBytes loadAt (const Lanes& lanes, uint16_t address) {
+    LaneBytes value;
+    memcpy(&value, &lanes.memory[address * laneCount], sizeof(value));
+    return value;
+}
+
+void storeAt (Lanes& lanes, uint16_t address, LaneBytes value, LaneBytes mask) {
+    const auto merged = blend(mask, value, loadAt(lanes, address));
+    memcpy(&lanes.memory[address * laneCount], &merged, sizeof(merged));
+}
+
+LaneBytes gather (const Lanes& lanes, LaneWords addresses) {
+    LaneBytes value;
+
+    for (size_t lane = 0; lane < laneCount; lane++) {
+        value[lane] = lanes.memory[addresses[lane] * laneCount + lane];
+    }
+
+    return value;
+}
+
+void scatter (Lanes& lanes, LaneWords addresses, LaneBytes value, LaneSet set) {
+    for (size_t lane = 0; lane < laneCount; lane++) {
+        if (set & (1u << lane)) {
+            lanes.memory[addresses[lane] * laneCount + lane] = value[lane];
+        }
+    }
+}
+
+// an effective address that is either the same in every lane or different per lane
+struct Target {
+    bool shared;
+    uint16_t address;
+    LaneWords addresses;
+};
+
+Target resolve (const Lanes& lanes, AddressingMode mode, uint16_t operand) {
+    switch (mode) {
+        case AddressingMode::Absolute: [[fallthrough]];
+        case AddressingMode::ZeroPage:
+            return { true, operand, LaneWords {} };
+
+        case AddressingMode::AbsoluteX:
+            return { false, 0, widen(lanes.x) + operand };
+
+        case AddressingMode::AbsoluteY:
+            return { false, 0, widen(lanes.y) + operand };
+
+        case AddressingMode::ZeroPageX:
+            return { false, 0, widen(lanes.x + static_cast<uint8_t>(operand)) };
+
+        case AddressingMode::ZeroPageY:
+            return { false, 0, widen(lanes.y + static_cast<uint8_t>(operand)) };
+
+        case AddressingMode::Indirect: {
+            const uint16_t high = (operand & 0xff00) | ((operand + 1) & 0x00ff);
+            return { false, 0, widen(loadAt(lanes, operand)) | widen(loadAt(lanes, high)) << 8 };
+        }
+
+        case AddressingMode::IndirectX: {
+            const auto pointer = lanes.x + static_cast<uint8_t>(operand);
+            return { false, 0, widen(gather(lanes, widen(pointer))) | widen(gather(lanes, widen(pointer + 1))) << 8 };
+        }
+
+        case AddressingMode::IndirectY: {
+            const auto base = widen(loadAt(lanes, operand)) | widen(loadAt(lanes, (operand + 1) & 0xff)) << 8;
+            return { false, 0, base + widen(lanes.y) };
+        }
+
+        default:
+            return { true, 0, LaneWords {} };
+    }
+}
+
+LaneBytes read (const Lanes& lanes, const Target& target) {
+    return target.shared ? loadAt(lanes, target.address) : gather(lanes, target.addresses);
+}
+
+// the lanes taking part in one step, as a bit set for per-lane loops and as a vector mask
+struct Group {
+    LaneSet set;
+    LaneBytes mask;
+};
+
+void write (Lanes& lanes, const Target& target, LaneBytes value, const Group& group) {
+    if (target.shared) {
+        storeAt(lanes, target.address, value, group.mask);
+    } else {
+        scatter(lanes, target.addresses, value, group.set);
+    }
+}
+
+LaneBytes fetch (const Lanes& lanes, AddressingMode mode, uint16_t operand) {
+    if (mode == AddressingMode::Immediate) {
+        return splat(operand);
+    }
+
+    if (mode == AddressingMode::Accumulator) {
+        return lanes.a;
+    }
+
+    return read(lanes, resolve(lanes, mode, operand));
+}
+
+void setFlags (Lanes& lanes, LaneBytes mask, uint8_t flags, LaneBytes values) {
+    lanes.p = blend(mask, (lanes.p & splat(~flags)) | (values & splat(flags)), lanes.p);
+}
+
+LaneBytes nz (LaneBytes value) {
+    return (value & splat(FlagN)) | (bits(value == 0) & splat(FlagZ));
+}
+
+void setNZ (Lanes& lanes, LaneBytes mask, LaneBytes value) {
+    setFlags(lanes, mask, FlagN | FlagZ, nz(value));
+}
+
+void push (Lanes& lanes, LaneBytes value, const Group& group) {
+    scatter(lanes, widen(lanes.sp) + 0x0100, value, group.set);
+    lanes.sp = blend(group.mask, lanes.sp - 1, lanes.sp);
+}
+
+LaneBytes pull (Lanes& lanes, const Group& group) {
+    lanes.sp = blend(group.mask, lanes.sp + 1, lanes.sp);
+    return gather(lanes, widen(lanes.sp) + 0x0100);
+}
+
+void jump (Lanes& lanes, LaneBytes mask, LaneWords target) {
+    lanes.pc = blend(widenMask(mask), target, lanes.pc);
+}
+
+// decimal mode runs lane by lane through the scalar core's arithmetic
+template <void (*Arithmetic) (Cpu&, uint8_t)>
+void decimal (Lanes& lanes, LaneSet set, LaneBytes value) {
+    if (set == 0) {
+        return;
+    }
+
+    for (size_t lane = 0; lane < laneCount; lane++) {
+        if (set & (1u << lane)) {
+            Cpu cpu { lanes.a[lane], lanes.x[lane], lanes.y[lane], lanes.sp[lane], lanes.p[lane] };
+            Arithmetic(cpu, value[lane]);
+            lanes.a[lane] = cpu.a;
+            lanes.p[lane] = cpu.p;
+        }
+    }
+}
+
+void adcLanes (Lanes& lanes, const Group& group, LaneBytes value) {
+    const auto decimalSet = group.set & setOf(bits((lanes.p & splat(FlagD)) != 0));
+    const auto mask = decimalSet == 0 ? group.mask : maskOf(group.set & ~decimalSet);
+
+    const auto sum = widen(lanes.a) + widen(value) + widen(lanes.p & splat(FlagC));
+    const auto result = narrow(sum);
+    const auto overflow = (~(lanes.a ^ value) & (lanes.a ^ result) & splat(0x80)) >> 1;
+
+    setFlags(lanes, mask, FlagC | FlagV | FlagN | FlagZ, narrow(sum >> 8) | overflow | nz(result));
+    lanes.a = blend(mask, result, lanes.a);
+
+    decimal<adc<EagerFlags>>(lanes, decimalSet, value);
+}
+
+void sbcLanes (Lanes& lanes, const Group& group, LaneBytes value) {
+    const auto decimalSet = group.set & setOf(bits((lanes.p & splat(FlagD)) != 0));
+    const auto mask = decimalSet == 0 ? group.mask : maskOf(group.set & ~decimalSet);
+
+    const auto borrow = widen(~lanes.p & splat(FlagC));
+    const auto difference = widen(lanes.a) - widen(value) - borrow;
+    const auto result = narrow(difference);
+    const auto carry = bits(narrow(difference >> 8) == 0) & splat(FlagC);
+    const auto overflow = ((lanes.a ^ value) & (lanes.a ^ result) & splat(0x80)) >> 1;
+
+    setFlags(lanes, mask, FlagC | FlagV | FlagN | FlagZ, carry | overflow | nz(result));
+    lanes.a = blend(mask, result, lanes.a);
+
+    decimal<sbc<EagerFlags>>(lanes, decimalSet, value);
+}
+
+// the lanes of one step, as the state the scalar core's flag formulas work on
+struct LaneState {
+    Lanes& lanes;
+    LaneBytes mask;
+};
+
+// eager flags for the lanes of one step, only those lanes' P is written
+struct LaneStepFlags {
+    static void setN (LaneState& state, LaneBytes source) { setFlags(state.lanes, state.mask, FlagN, source); }
+    static void setZ (LaneState& state, LaneBytes source) { setFlags(state.lanes, state.mask, FlagZ, bits(source == 0)); }
+    static void setNZ (LaneState& state, LaneBytes value) { ::setNZ(state.lanes, state.mask, value); }
+
+    // from a comparison, or any bits set in a lane
+    static void setCarry (LaneState& state, LaneFlags carry) { setFlags(state.lanes, state.mask, FlagC, bits(carry)); }
+    static void setCarry (LaneState& state, LaneBytes carry) { setFlags(state.lanes, state.mask, FlagC, bits(carry != 0)); }
+
+    // V is bit 7 of the source
+    static void setOverflow (LaneState& state, LaneBytes source) { setFlags(state.lanes, state.mask, FlagV, source >> 1); }
+
+    static LaneBytes carry (const LaneState& state) { return state.lanes.p & splat(FlagC); }
+};
+
+void branchLanes (Lanes& lanes, LaneBytes mask, uint8_t flag, bool whenSet, uint16_t operand) {
+    const auto isSet = bits((lanes.p & splat(flag)) != 0);
+    const auto taken = mask & (whenSet ? isSet : ~isSet);
+
+    jump(lanes, taken, lanes.pc + static_cast<uint16_t>(static_cast<int8_t>(operand)));
+}
+
+// read-modify-write on A or memory, op returns the result and sets the flags
+template <typename Op>
+void modify (Lanes& lanes, const Group& group, AddressingMode mode, uint16_t operand, Op op) {
+    if (mode == AddressingMode::Accumulator) {
+        lanes.a = blend(group.mask, op(lanes.a), lanes.a);
+        return;
+    }
+
+    const auto target = resolve(lanes, mode, operand);
+    write(lanes, target, op(read(lanes, target)), group);
+}
+
+void execute (Lanes& lanes, const Group& group, const OpcodeInfo& info, uint16_t operand) {
+    const auto mode = info.mode;
+    const auto mask = group.mask;
+
+    LaneState state { lanes, mask };
+
+    const auto step = [&lanes, mask] (LaneBytes result) {
+        setNZ(lanes, mask, result);
+        return result;
+    };
+
+    switch (info.instruction) {
+        case Instruction::ADC: adcLanes(lanes, group, fetch(lanes, mode, operand)); break;
+        case Instruction::SBC: sbcLanes(lanes, group, fetch(lanes, mode, operand)); break;
+
+        case Instruction::AND:
+            lanes.a = blend(mask, lanes.a & fetch(lanes, mode, operand), lanes.a);
+            setNZ(lanes, mask, lanes.a);
+            break;
+
+        case Instruction::EOR:
+            lanes.a = blend(mask, lanes.a ^ fetch(lanes, mode, operand), lanes.a);
+            setNZ(lanes, mask, lanes.a);
+            break;
+
+        case Instruction::ORA:
+            lanes.a = blend(mask, lanes.a | fetch(lanes, mode, operand), lanes.a);
+            setNZ(lanes, mask, lanes.a);
+            break;
+
+        case Instruction::ASL:
+            modify(lanes, group, mode, operand, [&] (LaneBytes value) { return asl<LaneStepFlags>(state, value); });
+            break;
+
+        case Instruction::LSR:
+            modify(lanes, group, mode, operand, [&] (LaneBytes value) { return lsr<LaneStepFlags>(state, value); });
+            break;
+
+        case Instruction::ROL:
+            modify(lanes, group, mode, operand, [&] (LaneBytes value) { return rol<LaneStepFlags>(state, value); });
+            break;
+
+        case Instruction::ROR:
+            modify(lanes, group, mode, operand, [&] (LaneBytes value) { return ror<LaneStepFlags>(state, value); });
+            break;
+
+        case Instruction::INC:
+            modify(lanes, group, mode, operand, [&] (LaneBytes value) { return step(value + 1); });
+            break;
+
+        case Instruction::DEC:
+            modify(lanes, group, mode, operand, [&] (LaneBytes value) { return step(value - 1); });
+            break;
+
+        case Instruction::BIT: bit<LaneStepFlags>(state, lanes.a, fetch(lanes, mode, operand)); break;
+
+        case Instruction::CMP: compare<LaneStepFlags>(state, lanes.a, fetch(lanes, mode, operand)); break;
+        case Instruction::CPX: compare<LaneStepFlags>(state, lanes.x, fetch(lanes, mode, operand)); break;
+        case Instruction::CPY: compare<LaneStepFlags>(state, lanes.y, fetch(lanes, mode, operand)); break;
+
+        case Instruction::BCC: branchLanes(lanes, mask, FlagC, false, operand); break;
+        case Instruction::BCS: branchLanes(lanes, mask, FlagC, true, operand); break;
+        case Instruction::BEQ: branchLanes(lanes, mask, FlagZ, true, operand); break;
+        case Instruction::BMI: branchLanes(lanes, mask, FlagN, true, operand); break;
+        case Instruction::BNE: branchLanes(lanes, mask, FlagZ, false, operand); break;
+        case Instruction::BPL: branchLanes(lanes, mask, FlagN, false, operand); break;
+        case Instruction::BVC: branchLanes(lanes, mask, FlagV, false, operand); break;
+        case Instruction::BVS: branchLanes(lanes, mask, FlagV, true, operand); break;
+
+        case Instruction::BRK: {
+            const auto pc = lanes.pc + 1;
+            push(lanes, narrow(pc >> 8), group);
+            push(lanes, narrow(pc), group);
+            push(lanes, lanes.p | splat(FlagB | FlagU), group);
+            lanes.p = blend(mask, lanes.p | splat(FlagI), lanes.p);
+            jump(lanes, mask, widen(loadAt(lanes, irqVector)) | widen(loadAt(lanes, irqVector + 1)) << 8);
+            break;
+        }
+
+        case Instruction::CLC: lanes.p = blend(mask, lanes.p & splat(~FlagC), lanes.p); break;
+        case Instruction::CLD: lanes.p = blend(mask, lanes.p & splat(~FlagD), lanes.p); break;
+        case Instruction::CLI: lanes.p = blend(mask, lanes.p & splat(~FlagI), lanes.p); break;
+        case Instruction::CLV: lanes.p = blend(mask, lanes.p & splat(~FlagV), lanes.p); break;
+        case Instruction::SEC: lanes.p = blend(mask, lanes.p | splat(FlagC), lanes.p); break;
+        case Instruction::SED: lanes.p = blend(mask, lanes.p | splat(FlagD), lanes.p); break;
+        case Instruction::SEI: lanes.p = blend(mask, lanes.p | splat(FlagI), lanes.p); break;
+
+        case Instruction::DEX: lanes.x = blend(mask, lanes.x - 1, lanes.x); setNZ(lanes, mask, lanes.x); break;
+        case Instruction::DEY: lanes.y = blend(mask, lanes.y - 1, lanes.y); setNZ(lanes, mask, lanes.y); break;
+        case Instruction::INX: lanes.x = blend(mask, lanes.x + 1, lanes.x); setNZ(lanes, mask, lanes.x); break;
+        case Instruction::INY: lanes.y = blend(mask, lanes.y + 1, lanes.y); setNZ(lanes, mask, lanes.y); break;
+
+        case Instruction::JMP: {
+            const auto target = resolve(lanes, mode, operand);
+            jump(lanes, mask, target.shared ? splatWord(target.address) : target.addresses);
+            break;
+        }
+
+        case Instruction::JSR: {
+            const auto pc = lanes.pc - 1;
+            push(lanes, narrow(pc >> 8), group);
+            push(lanes, narrow(pc), group);
+            jump(lanes, mask, splatWord(operand));
+            break;
+        }
+
+        case Instruction::LDA: lanes.a = blend(mask, fetch(lanes, mode, operand), lanes.a); setNZ(lanes, mask, lanes.a); break;
+        case Instruction::LDX: lanes.x = blend(mask, fetch(lanes, mode, operand), lanes.x); setNZ(lanes, mask, lanes.x); break;
+        case Instruction::LDY: lanes.y = blend(mask, fetch(lanes, mode, operand), lanes.y); setNZ(lanes, mask, lanes.y); break;
+
+        case Instruction::NOP: break;
+
+        // lanes only ever run the documented NMOS set, anything else is an invalid opcode there
+        default: break;
+
+        case Instruction::PHA: push(lanes, lanes.a, group); break;
+        case Instruction::PHP: push(lanes, lanes.p | splat(FlagB | FlagU), group); break;
+
+        case Instruction::PLA:
+            lanes.a = blend(mask, pull(lanes, group), lanes.a);
+            setNZ(lanes, mask, lanes.a);
+            break;
+
+        case Instruction::PLP:
+            lanes.p = blend(mask, (pull(lanes, group) & splat(~FlagB)) | splat(FlagU), lanes.p);
+            break;
+
+        case Instruction::RTI: {
+            lanes.p = blend(mask, (pull(lanes, group) & splat(~FlagB)) | splat(FlagU), lanes.p);
+            const auto low = widen(pull(lanes, group));
+            jump(lanes, mask, low | widen(pull(lanes, group)) << 8);
+            break;
+        }
+
+        case Instruction::RTS: {
+            const auto low = widen(pull(lanes, group));
+            jump(lanes, mask, (low | widen(pull(lanes, group)) << 8) + 1);
+            break;
+        }
+
+        case Instruction::STA: write(lanes, resolve(lanes, mode, operand), lanes.a, group); break;
+        case Instruction::STX: write(lanes, resolve(lanes, mode, operand), lanes.x, group); break;
+        case Instruction::STY: write(lanes, resolve(lanes, mode, operand), lanes.y, group); break;
+
+        case Instruction::TAX: lanes.x = blend(mask, lanes.a, lanes.x); setNZ(lanes, mask, lanes.x); break;
+        case Instruction::TAY: lanes.y = blend(mask, lanes.a, lanes.y); setNZ(lanes, mask, lanes.y); break;
+        case Instruction::TSX: lanes.x = blend(mask, lanes.sp, lanes.x); setNZ(lanes, mask, lanes.x); break;
+        case Instruction::TXA: lanes.a = blend(mask, lanes.x, lanes.a); setNZ(lanes, mask, lanes.a); break;
+        case Instruction::TXS: lanes.sp = blend(mask, lanes.x, lanes.sp); break;
+        case Instruction::TYA: lanes.a = blend(mask, lanes.y, lanes.a); setNZ(lanes, mask, lanes.a); break;
+    }
+}
+
+void loadLane (Lanes& lanes, size_t lane, const Machine& machine) {
+    const auto& cpu = machine.cpu;
+
+    lanes.a[lane] = cpu.a;
+    lanes.x[lane] = cpu.x;
+    lanes.y[lane] = cpu.y;
+    lanes.sp[lane] = cpu.sp;
+    lanes.p[lane] = cpu.p;
+    lanes.pc[lane] = cpu.pc;
+    lanes.cycles[lane] = machine.cycles;
+    lanes.instructions[lane] = machine.instructions;
+
+    lanes.used |= 1u << lane;
+    lanes.halted = machine.halted ? lanes.halted | 1u << lane : lanes.halted & ~(1u << lane);
+
+    for (size_t address = 0; address < machine.memory.size(); address++) {
+        lanes.memory[address * laneCount + lane] = machine.memory[address];
+    }
+}
+
+void storeLane (const Lanes& lanes, size_t lane, Machine& machine) {
+    machine.cpu = { lanes.a[lane], lanes.x[lane], lanes.y[lane], lanes.sp[lane], lanes.p[lane], lanes.pc[lane] };
+    machine.cycles = lanes.cycles[lane];
+    machine.instructions = lanes.instructions[lane];
+    machine.halted = lanes.halted & (1u << lane);
+
+    for (size_t address = 0; address < machine.memory.size(); address++) {
+        machine.memory[address] = lanes.memory[address * laneCount + lane];
+    }
+}
+
+// the most cycles any single instruction can take
+constexpr uint64_t maxCycles = [] {
+    uint64_t cycles = 0;
+
+    for (const auto& info : Nmos6502::infos) {
+        cycles = std::max<uint64_t>(cycles, info.cycles);
+    }
+
+    return cycles;
+}();
+
+// cycles and instructions since the last flush into the lanes' 64-bit counters
+struct Pending {
+    LaneWords cycles {};
+    LaneWords instructions {};
+};
+
+// keeps the pending counts well clear of 16-bit overflow
+constexpr uint64_t maxStepsBetweenFlushes = 4096;
+
+void flush (Lanes& lanes, Pending& pending) {
+    lanes.cycles += __builtin_convertvector(pending.cycles, LaneCounts);
+    lanes.instructions += __builtin_convertvector(pending.instructions, LaneCounts);
+    pending = {};
+}
+
+// runs the lanes at the lowest pc that hold the same instruction there, false once any of them jams
+bool step (Lanes& lanes, Pending& pending, LaneSet running, LaneBytes runningMask, LaneWords runningWideMask) {
+    auto pc = lanes.pc[std::countr_zero(running)];
+    auto atPcMask = runningMask & narrowMask(lanes.pc == pc);
+    auto atPc = setOf(atPcMask);
+
+    // the lanes furthest behind go first, lanes that took a longer path get the chance to catch up
+    if (atPc != running) {
+        const auto pcs = blend(runningWideMask, lanes.pc, splatWord(0xffff));
+
+        for (size_t lane = 0; lane < laneCount; lane++) {
+            pc = std::min(pc, pcs[lane]);
+        }
+
+        atPcMask = runningMask & narrowMask(lanes.pc == pc);
+        atPc = setOf(atPcMask);
+    }
+
+    const auto leader = std::countr_zero(atPc);
+
+    const auto opcodes = loadAt(lanes, pc);
+    const auto low = loadAt(lanes, pc + 1);
+    const auto high = loadAt(lanes, pc + 2);
+
+    const auto& info = Nmos6502::infos[opcodes[leader]];
+    const auto size = operandSize(info.mode);
+
+    // lanes at the same pc can still hold different code, those wait for a later step
+    auto same = opcodes == opcodes[leader];
+
+    if (size > 0) {
+        same &= low == low[leader];
+    }
+    if (size > 1) {
+        same &= high == high[leader];
+    }
+
+    const auto mask = atPcMask & bits(same);
+    const Group group { setOf(mask), mask };
+    const auto wideMask = widenMask(group.mask);
+
+    pending.cycles += wideMask & info.cycles;
+    pending.instructions -= wideMask;
+
+    if (!info.valid) {
+        // jammed lanes keep pc on the opcode, like the scalar core
+        lanes.halted |= group.set;
+        return false;
+    }
+
+    const uint16_t operand = size == 0 ? 0 : size == 1 ? low[leader] : low[leader] | high[leader] << 8;
+
+    lanes.pc = blend(wideMask, lanes.pc + static_cast<uint16_t>(1 + size), lanes.pc);
+    execute(lanes, group, info, operand);
+    return true;
+}
+
+void runLockstep (Lanes& lanes, uint64_t budget, bool budgetInCycles) {
+    const auto maxCost = budgetInCycles ? maxCycles : 1;
+    Pending pending;
+
+    while (true) {
+        flush(lanes, pending);
+
+        const auto& counters = budgetInCycles ? lanes.cycles : lanes.instructions;
+        LaneSet running = 0;
+        uint64_t slack = UINT64_MAX;
+
+        for (size_t lane = 0; lane < laneCount; lane++) {
+            if ((lanes.used & ~lanes.halted & (1u << lane)) && counters[lane] < budget) {
+                running |= 1u << lane;
+                slack = std::min(slack, budget - counters[lane]);
+            }
+        }
+
+        if (running == 0) {
+            return;
+        }
+
+        // no running lane can reach its budget within this many steps, so the set only changes when one jams
+        const auto runningMask = maskOf(running);
+        const auto runningWideMask = widenMask(runningMask);
+        auto steps = std::min((slack - 1) / maxCost + 1, maxStepsBetweenFlushes);
+
+        while (steps > 0 && step(lanes, pending, running, runningMask, runningWideMask)) {
+            steps--;
+        }
+    }
+}
+
+std::string describeLane (const char* name, const Machine& machine) {
+    const auto& cpu = machine.cpu;
+    char line[120];
+
+    snprintf(
+        line, sizeof(line), " %-7s pc=%04x a=%02x x=%02x y=%02x sp=%02x p=%02x cycles=%llu\n",
+        name, cpu.pc, cpu.a, cpu.x, cpu.y, cpu.sp, cpu.p, static_cast<unsigned long long>(machine.cycles)
+    );
+
+    return line;
+}
+
+// lane 0 against the scalar machine, memory is left for the end
+bool sameState (const Machine& scalar, const Lanes& lanes) {
+    const auto& cpu = scalar.cpu;
+
+    return cpu.a == lanes.a[0] && cpu.x == lanes.x[0] && cpu.y == lanes.y[0] && cpu.sp == lanes.sp[0] && cpu.p == lanes.p[0]
+        && cpu.pc == lanes.pc[0] && scalar.cycles == lanes.cycles[0] && scalar.instructions == lanes.instructions[0]
+        && scalar.halted == ((lanes.halted & 1) != 0);
+}
+
+std::string diffLockstep (const std::vector<uint8_t>& program, uint64_t instructionBudget) {
+    const auto scalar = std::make_unique<Machine>();
+    const auto lane = std::make_unique<Machine>();
+    const auto lanes = std::make_unique<Lanes>();
+
+    if (!load(*scalar, program)) {
+        return "program does not fit in memory\n";
+    }
+
+    reset(*scalar);
+    scalar->engine = Engine::Interpreter;
+    scalar->idle.skip = false;
+    loadLane(*lanes, 0, *scalar);
+
+    while (scalar->instructions < instructionBudget && !scalar->halted) {
+        const auto pc = scalar->cpu.pc;
+
+        runInstructions(*scalar, 1);
+        runLockstep(*lanes, scalar->instructions, false);
+
+        if (!sameState(*scalar, *lanes)) {
+            storeLane(*lanes, 0, *lane);
+
+            char line[80];
+            snprintf(
+                line, sizeof(line), "diverged after instruction %llu at $%04x\n",
+                static_cast<unsigned long long>(scalar->instructions), pc
+            );
+
+            return line + describeLane("scalar", *scalar) + describeLane("lanes", *lane);
+        }
+    }
+
+    storeLane(*lanes, 0, *lane);
+
+    for (size_t address = 0; address < scalar->memory.size(); address++) {
+        if (scalar->memory[address] != lane->memory[address]) {
+            char line[80];
+            snprintf(
+                line, sizeof(line), "memory at $%04zx differs: scalar %02x, lanes %02x\n",
+                address, scalar->memory[address], lane->memory[address]
+            );
+
+            return line;
+        }
+    }
+
+    char line[80];
+    snprintf(line, sizeof(line), "lanes match in %llu instructions\n", static_cast<unsigned long long>(scalar->instructions));
+
+    return line;
+}
@@ -0,0 +1,67 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "emulator/Machine.h"
+
+
+
+constexpr size_t laneCount = 16;
+
+// the programs lockstep-diff runs when given none, from the top of the repository
+constexpr const char* lockstepSamples[] {
+    "samples/bench/alu.htr",
+    "samples/bench/memcopy.htr",
+    "samples/bench/branches.htr",
+    "samples/bench/functional.htr",
+    "samples/emulator/bit.htr",
+    "samples/emulator/flags.htr",
+    "samples/emulator/framebuffer.htr",
+    "samples/emulator/input.htr",
+    "samples/emulator/timer.htr",
+};
+
+typedef uint8_t LaneBytes __attribute__((vector_size(laneCount)));
+typedef uint16_t LaneWords __attribute__((vector_size(laneCount * 2)));
+typedef uint64_t LaneCounts __attribute__((vector_size(laneCount * 8)));
+
+// lane sets are bit masks, bit n for lane n
+typedef uint32_t LaneSet;
+
+// up to laneCount machines whose registers sit side by side in vector lanes
+struct Lanes {
+    LaneBytes a {};
+    LaneBytes x {};
+    LaneBytes y {};
+    LaneBytes sp {};
+    LaneBytes p {};
+    LaneWords pc {};
+
+    LaneCounts cycles {};
+    LaneCounts instructions {};
+
+    LaneSet used = 0;
+    LaneSet halted = 0;
+
+    // interleaved by address, byte n of the lanes at one address is lane n's copy
+    std::vector<uint8_t> memory = std::vector<uint8_t>(0x10000 * laneCount);
+};
+
+void loadLane (Lanes&, size_t lane, const Machine&);
+
+// copies registers, counters and memory back into a scalar machine
+void storeLane (const Lanes&, size_t lane, Machine&);
+
+// steps the lanes at the lowest pc together, until every lane halts or uses up its budget
+void runLockstep (Lanes&, uint64_t budget, bool budgetInCycles);
+
+// steps the program on the interpreter and in a lane side by side,
+// and reports the first instruction after which a register, P or the counters differ
+std::string diffLockstep (const std::vector<uint8_t>& program, uint64_t instructionBudget);
+
+
+
+#endif //LOCKSTEP_H
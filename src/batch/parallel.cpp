@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "parallel.h"
+
+
+struct WorkQueue {
+    std::mutex mutex;
+    std::deque<size_t> indices;
+};
+
+// the owner works from the back, thieves take from the front so they rarely contend
+std::optional<size_t> popBack (WorkQueue& queue) {
+    const std::lock_guard lock { queue.mutex };
+
+    if (queue.indices.empty()) {
+        return std::nullopt;
+    }
+
+    const auto index = queue.indices.back();
+    queue.indices.pop_back();
+    return index;
+}
+
+std::optional<size_t> popFront (WorkQueue& queue) {
+    const std::lock_guard lock { queue.mutex };
+
+    if (queue.indices.empty()) {
+        return std::nullopt;
+    }
+
+    const auto index = queue.indices.front();
+    queue.indices.pop_front();
+    return index;
+}
+
+void parallelFor (size_t count, size_t threadCount, const std::function<void (size_t)>& task) {
+    threadCount = std::max<size_t>(1, std::min(threadCount, count));
+
+    std::vector<WorkQueue> queues(threadCount);
+
+    // contiguous shares keep the front of every queue far from its owner's end
+    for (size_t index = 0; index < count; index++) {
+        queues[index * threadCount / count].indices.push_back(index);
+    }
+
+    const auto work = [&queues, &task, threadCount] (size_t self) {
+        while (true) {
+            auto index = popBack(queues[self]);
+
+            for (size_t offset = 1; !index && offset < threadCount; offset++) {
+                index = popFront(queues[(self + offset) % threadCount]);
+            }
+
+            // nothing is ever pushed after startup, so empty everywhere means done
+            if (!index) {
+                return;
+            }
+
+            task(*index);
+        }
+    };
+
+    std::vector<std::thread> workers;
+
+    for (size_t self = 1; self < threadCount; self++) {
+        workers.emplace_back(work, self);
+    }
+
+    work(0);
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
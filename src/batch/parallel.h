@@ -0,0 +1,15 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+
+
+// runs task(index) for every index in [0, count) on threadCount workers
+// each worker drains its own share first and then steals from the others
+void parallelFor (size_t count, size_t threadCount, const std::function<void (size_t)>& task);
+
+
+
+#endif //PARALLEL_H
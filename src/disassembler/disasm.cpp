@@ -1,21 +1,9 @@
-#include <unordered_map>
-
 #include "assembler/opcodes.h"
 
 #include "disasm.h"
 
 
 
-static const auto opcodesInv = [] {
-    std::unordered_map<uint8_t, InsAndMode> opcodesInv;
-
-    for (const auto& entry : opcodes) {
-        opcodesInv[entry.second] = entry.first;
-    }
-
-    return opcodesInv;
-}();
-
 std::string dec8 (int8_t value) {
     char s[5];
     sprintf(s, "%-4d", value);
@@ -34,6 +22,110 @@ std::string hex16 (uint16_t value) {
     return std::string { s };
 }
 
+template <typename Variant>
+std::string disassembleInstruction (uint8_t opcode, uint8_t low, uint8_t high, uint16_t address) {
+    const auto& info = Variant::infos[opcode];
+
+    if (!info.valid) {
+        return "BYTE $" + hex8(opcode) + "          ; " + hex8(opcode) + "          ; " + hex16(address);
+    }
+
+    auto source = std::string { getName(info.instruction) };
+
+    switch (info.mode) {
+        case AddressingMode::Absolute:
+            source += " $" + hex16((high << 8) | low) +
+                "         ; " + hex8(opcode) + " " + hex8(low) + " " + hex8(high) +
+                "    ; " + hex16(address);
+            break;
+
+        case AddressingMode::AbsoluteIndirectX:
+            source += " ($" + hex16((high << 8) | low) + ", X)" +
+                "    ; " + hex8(opcode) + " " + hex8(low) + " " + hex8(high) +
+                "    ; " + hex16(address);
+            break;
+
+        case AddressingMode::AbsoluteX:
+            source += " $" + hex16((high << 8) | low) + ", X" +
+                "      ; " + hex8(opcode) + " " + hex8(low) + " " + hex8(high) +
+                "    ; " + hex16(address);
+            break;
+
+        case AddressingMode::AbsoluteY:
+            source += " $" + hex16((high << 8) | low) + ", Y" +
+                "      ; " + hex8(opcode) + " " + hex8(low) + " " + hex8(high) +
+                "    ; " + hex16(address);
+            break;
+
+        case AddressingMode::Accumulator:
+            source += " A             ; " + hex8(opcode) +
+                "          ; " + hex16(address);
+            break;
+
+        case AddressingMode::Immediate:
+            source += " #$" + hex8(low) +
+                "          ; " + hex8(opcode) + " " + hex8(low) +
+                "       ; " + hex16(address);
+            break;
+
+        case AddressingMode::Implied:
+            source += "               ; " + hex8(opcode) +
+                "          ; " + hex16(address);
+            break;
+
+        case AddressingMode::Indirect:
+            source += " ($" + hex16((high << 8) | low) + ")" +
+                "       ; " + hex8(opcode) + " " + hex8(low) + " " + hex8(high) +
+                "    ; " + hex16(address);
+            break;
+
+        case AddressingMode::IndirectX:
+            source += " ($" + hex8(low) + ", X)" +
+                "      ; " + hex8(opcode) + " " + hex8(low) +
+                "       ; " + hex16(address);
+            break;
+
+        case AddressingMode::IndirectY:
+            source += " ($" + hex8(low) + "), Y" +
+                "      ; " + hex8(opcode) + " " + hex8(low) +
+                "       ; " + hex16(address);
+            break;
+
+        case AddressingMode::Relative:
+            source += " *" + dec8(static_cast<int8_t>(low)) +
+                "         ; " + hex8(opcode) + " " + hex8(low) +
+                "       ; " + hex16(address);
+            break;
+
+        case AddressingMode::ZeroPage:
+            source += " $" + hex8(low) +
+                "           ; " + hex8(opcode) + " " + hex8(low) +
+                "       ; " + hex16(address);
+            break;
+
+        case AddressingMode::ZeroPageIndirect:
+            source += " ($" + hex8(low) + ")" +
+                "         ; " + hex8(opcode) + " " + hex8(low) +
+                "       ; " + hex16(address);
+            break;
+
+        case AddressingMode::ZeroPageX:
+            source += " $" + hex8(low) + ", X" +
+                "        ; " + hex8(opcode) + " " + hex8(low) +
+                "       ; " + hex16(address);
+            break;
+
+        case AddressingMode::ZeroPageY:
+            source += " $" + hex8(low) + ", Y" +
+                "        ; " + hex8(opcode) + " " + hex8(low) +
+                "       ; " + hex16(address);
+            break;
+    }
+
+    return source;
+}
+
+template <typename Variant>
 std::string disassemble (const std::vector<uint8_t>& bytes) {
     std::string source;
 
@@ -46,31 +138,8 @@ std::string disassemble (const std::vector<uint8_t>& bytes) {
         const auto opcode = bytes[index];
         index++;
 
-        if (!opcodesInv.contains(opcode)) {
-            source += "BYTE $" + hex8(opcode) + "          ; " + hex8(opcode) + "          ; " + hex16(index - 1) + "\n";
-            continue;
-        }
-
-        const auto& [name, mode] = opcodesInv.find(opcode)->second;
-
-        const auto requiredBytes = [mode] {
-            switch (mode) {
-                case AddressingMode::Absolute: [[fallthrough]];
-                case AddressingMode::AbsoluteX: [[fallthrough]];
-                case AddressingMode::AbsoluteY: return 2;
-                case AddressingMode::Accumulator: return 0;
-                case AddressingMode::Immediate: return 1;
-                case AddressingMode::Implied: return 0;
-                case AddressingMode::Indirect: return 2;
-                case AddressingMode::IndirectX: [[fallthrough]];
-                case AddressingMode::IndirectY: return 1;
-                case AddressingMode::Relative: return 1;
-                case AddressingMode::ZeroPage: [[fallthrough]];
-                case AddressingMode::ZeroPageX: [[fallthrough]];
-                case AddressingMode::ZeroPageY: return 1;
-                default: return 0;
-            }
-        }();
+        const auto& info = Variant::infos[opcode];
+        const auto requiredBytes = info.valid ? operandSize(info.mode) : 0;
 
         if (index + requiredBytes > bytes.size()) {
             source += "BYTE $" + hex8(opcode) + "          ; " + hex8(opcode) + "          ; " + hex16(index - 1) + "\n";
@@ -81,85 +150,10 @@ std::string disassemble (const std::vector<uint8_t>& bytes) {
             break;
         }
 
-        source += name;
-
-        switch (mode) {
-            case AddressingMode::Absolute:
-                source += " $" + hex16((bytes[index + 1] << 8) | bytes[index]) +
-                    "         ; " + hex8(opcode) + " " + hex8(bytes[index]) + " " + hex8(bytes[index + 1]) +
-                    "    ; " + hex16(index - 1);
-                break;
-
-            case AddressingMode::AbsoluteX:
-                source += " $" + hex16((bytes[index + 1] << 8) | bytes[index]) + ", X" +
-                    "      ; " + hex8(opcode) + " " + hex8(bytes[index]) + " " + hex8(bytes[index + 1]) +
-                    "    ; " + hex16(index - 1);
-                break;
-
-            case AddressingMode::AbsoluteY:
-                source += " $" + hex16((bytes[index + 1] << 8) | bytes[index]) + ", Y" +
-                    "      ; " + hex8(opcode) + " " + hex8(bytes[index]) + " " + hex8(bytes[index + 1]) +
-                    "    ; " + hex16(index - 1);
-                break;
-
-            case AddressingMode::Accumulator:
-                source += " A             ; " + hex8(opcode) +
-                    "          ; " + hex16(index - 1);
-                break;
-
-            case AddressingMode::Immediate:
-                source += " #$" + hex8(bytes[index]) +
-                    "          ; " + hex8(opcode) + " " + hex8(bytes[index]) +
-                    "       ; " + hex16(index - 1);
-                break;
-
-            case AddressingMode::Implied:
-                source += "               ; " + hex8(opcode) +
-                    "          ; " + hex16(index - 1);
-                break;
-
-            case AddressingMode::Indirect:
-                source += " ($" + hex16((bytes[index + 1] << 8) | bytes[index]) + ")" +
-                    "       ; " + hex8(opcode) + " " + hex8(bytes[index]) + " " + hex8(bytes[index + 1]) +
-                    "    ; " + hex16(index - 1);
-                break;
-
-            case AddressingMode::IndirectX:
-                source += " ($" + hex8(bytes[index]) + ", X)" +
-                    "      ; " + hex8(opcode) + " " + hex8(bytes[index]) +
-                    "       ; " + hex16(index - 1);
-                break;
-
-            case AddressingMode::IndirectY:
-                source += " ($" + hex8(bytes[index]) + "), Y" +
-                    "      ; " + hex8(opcode) + " " + hex8(bytes[index]) +
-                    "       ; " + hex16(index - 1);
-                break;
-
-            case AddressingMode::Relative:
-                source += " *" + dec8(static_cast<int8_t>(bytes[index])) +
-                    "         ; " + hex8(opcode) + " " + hex8(bytes[index]) +
-                    "       ; " + hex16(index - 1);
-                break;
-
-            case AddressingMode::ZeroPage:
-                source += " $" + hex8(bytes[index]) +
-                    "           ; " + hex8(opcode) + " " + hex8(bytes[index]) +
-                    "       ; " + hex16(index - 1);
-                break;
-
-            case AddressingMode::ZeroPageX:
-                source += " $" + hex8(bytes[index]) + ", X" +
-                    "        ; " + hex8(opcode) + " " + hex8(bytes[index]) +
-                    "       ; " + hex16(index - 1);
-                break;
-
-            case AddressingMode::ZeroPageY:
-                source += " $" + hex8(bytes[index]) + ", Y" +
-                    "        ; " + hex8(opcode) + " " + hex8(bytes[index]) +
-                    "       ; " + hex16(index - 1);
-                break;
-        }
+        const auto low = index < bytes.size() ? bytes[index] : 0;
+        const auto high = index + 1 < bytes.size() ? bytes[index + 1] : 0;
+
+        source += disassembleInstruction<Variant>(opcode, low, high, index - 1);
 
         index += requiredBytes;
 
@@ -167,4 +161,12 @@ std::string disassemble (const std::vector<uint8_t>& bytes) {
     }
 
     return source;
-}
\ No newline at end of file
+}
+
+template std::string disassemble<Nmos6502> (const std::vector<uint8_t>&);
+template std::string disassemble<Nmos6502Undocumented> (const std::vector<uint8_t>&);
+template std::string disassemble<Cmos65C02> (const std::vector<uint8_t>&);
+
+template std::string disassembleInstruction<Nmos6502> (uint8_t, uint8_t, uint8_t, uint16_t);
+template std::string disassembleInstruction<Nmos6502Undocumented> (uint8_t, uint8_t, uint8_t, uint16_t);
+template std::string disassembleInstruction<Cmos65C02> (uint8_t, uint8_t, uint8_t, uint16_t);
\ No newline at end of file
@@ -7,8 +7,14 @@
 
 
 
+// instantiated for the cpu variants in opcodes.h
+template <typename Variant>
 std::string disassemble (const std::vector<uint8_t>& bytes);
 
+// one line of disassemble's output without the newline, the operand bytes are ignored where the mode has none
+template <typename Variant>
+std::string disassembleInstruction (uint8_t opcode, uint8_t low, uint8_t high, uint16_t address);
+
 
 
 #endif //DISASM_H
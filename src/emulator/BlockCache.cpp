@@ -0,0 +1,143 @@
+#include <algorithm>
+
+#include "assembler/opcodes.h"
+
+#include "BlockCache.h"
+#include "instructions.h"
+#include "Machine.h"
+
+
+bool endsBlock (Instruction instruction) {
+    switch (instruction) {
+        case Instruction::BCC: [[fallthrough]];
+        case Instruction::BCS: [[fallthrough]];
+        case Instruction::BEQ: [[fallthrough]];
+        case Instruction::BMI: [[fallthrough]];
+        case Instruction::BNE: [[fallthrough]];
+        case Instruction::BPL: [[fallthrough]];
+        case Instruction::BRA: [[fallthrough]];
+        case Instruction::BRK: [[fallthrough]];
+        case Instruction::BVC: [[fallthrough]];
+        case Instruction::BVS: [[fallthrough]];
+        case Instruction::JMP: [[fallthrough]];
+        case Instruction::JSR: [[fallthrough]];
+        case Instruction::RTI: [[fallthrough]];
+        case Instruction::RTS: return true;
+        default: return false;
+    }
+}
+
+template <typename Variant>
+std::unique_ptr<Block> decodeBlock (const Machine& machine, uint16_t start) {
+    auto block = std::make_unique<Block>(start, start, 0);
+    uint32_t pc = start;
+
+    const auto& table = usesLazyFlags(machine) ? executors<Variant, LazyFlags, FastTiming> : executors<Variant, EagerFlags, FastTiming>;
+
+    while (block->instructions.size() < maxBlockInstructions) {
+        const auto opcode = peekByte(machine, pc);
+        const auto& info = Variant::infos[opcode];
+
+        // same operand lengths as the disassembler's requiredBytes
+        const uint32_t nextPc = pc + 1 + operandSize(info.mode);
+
+        if (nextPc > 0x10000) {
+            break;
+        }
+
+        // code fetched from a device is read afresh every time
+        if (machine.bus.readPages[pc >> 8] == nullptr || machine.bus.readPages[(nextPc - 1) >> 8] == nullptr) {
+            break;
+        }
+
+        uint16_t operand = 0;
+
+        if (operandSize(info.mode) == 1) {
+            operand = peekByte(machine, pc + 1);
+        } else if (operandSize(info.mode) == 2) {
+            operand = peekWord(machine, pc + 1);
+        }
+
+        block->instructions.emplace_back(table[opcode], operand, nextPc, info.cycles);
+        block->cycles += info.cycles;
+        pc = nextPc;
+
+        if (!info.valid || endsBlock(info.instruction)) {
+            break;
+        }
+    }
+
+    // an instruction straddling the top of memory or on a device page is left to the interpreter
+    if (block->instructions.empty()) {
+        return nullptr;
+    }
+
+    block->end = pc - 1;
+
+    return block;
+}
+
+std::unique_ptr<Block> decodeBlock (const Machine& machine, uint16_t start) {
+    switch (machine.variant) {
+        case CpuVariant::Nmos: return decodeBlock<Nmos6502>(machine, start);
+        case CpuVariant::NmosUndocumented: return decodeBlock<Nmos6502Undocumented>(machine, start);
+        case CpuVariant::Cmos: return decodeBlock<Cmos65C02>(machine, start);
+    }
+
+    return nullptr;
+}
+
+// pages go off the store fast path with their first block and back on with their last
+void retain (Machine& machine, const Block& block, int delta) {
+    auto& cache = machine.blockCache;
+
+    for (uint32_t address = block.start; address <= block.end; address++) {
+        cache.byteRefs[address] += delta;
+    }
+
+    for (uint32_t page = block.start >> 8; page <= block.end >> 8u; page++) {
+        cache.pageRefs[page] += delta;
+
+        if (cache.pageRefs[page] == (delta > 0 ? 1 : 0)) {
+            updateWritePage(machine, page);
+        }
+    }
+}
+
+Block* findBlock (Machine& machine, uint16_t pc) {
+    auto& cache = machine.blockCache;
+    cache.retired.clear();
+
+    auto& block = cache.blocks[pc];
+
+    if (!block) [[unlikely]] {
+        block = decodeBlock(machine, pc);
+
+        if (block) {
+            retain(machine, *block, 1);
+        }
+    }
+
+    return block.get();
+}
+
+void invalidateCode (Machine& machine, uint16_t address) {
+    auto& cache = machine.blockCache;
+
+    if (cache.byteRefs[address] == 0) {
+        return;
+    }
+
+    // blocks are at most maxBlockInstructions * 3 bytes long, so only starts close below can cover it
+    const auto lowest = std::max(0, address - static_cast<int>(maxBlockInstructions * 3) + 1);
+
+    for (int start = address; start >= lowest; start--) {
+        auto& block = cache.blocks[start];
+
+        if (block && block->end >= address) {
+            retain(machine, *block, -1);
+            cache.retired.push_back(std::move(block));
+            cache.leave = true;
+        }
+    }
+}
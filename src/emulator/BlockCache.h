@@ -0,0 +1,61 @@
+#ifndef BLOCKCACHE_H
+#define BLOCKCACHE_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "jit/CodeBuffer.h"
+
+struct Machine;
+
+typedef void (*Executor) (Machine&, uint16_t operand);
+typedef void (*NativeBlock) (Machine*);
+
+struct DecodedInstruction {
+    Executor executor;
+    uint16_t operand;
+    uint16_t nextPc;
+    uint8_t cycles;
+};
+
+// straight-line code from an entry pc up to and including the first control transfer
+struct Block {
+    uint16_t start;
+    uint16_t end;
+    uint32_t cycles;
+    std::vector<DecodedInstruction> instructions;
+
+    uint32_t executions = 0;
+    NativeBlock native = nullptr;
+};
+
+constexpr size_t maxBlockInstructions = 64;
+
+struct BlockCache {
+    std::array<std::unique_ptr<Block>, 0x10000> blocks;
+
+    // how many cached blocks cover each byte and each page, writes check the page first
+    std::array<uint16_t, 0x10000> byteRefs {};
+    std::array<uint16_t, 0x100> pageRefs {};
+
+    // invalidated blocks may still be executing, they are freed on the next lookup
+    std::vector<std::unique_ptr<Block>> retired;
+
+    // set by a store that dropped cached code or made a device move the deadline in, the running block stops right after it
+    bool leave = false;
+
+    CodeBuffer code;
+    uint64_t compiledBlocks = 0;
+};
+
+// null when the instruction at pc runs past the top of memory
+Block* findBlock (Machine&, uint16_t pc);
+
+// drops every block that covers the address
+void invalidateCode (Machine&, uint16_t address);
+
+
+
+#endif //BLOCKCACHE_H
@@ -0,0 +1,124 @@
+#include <cstdio>
+
+#include "Bus.h"
+#include "Machine.h"
+
+
+void mapMemory (Machine& machine) {
+    auto& bus = machine.bus;
+
+    for (size_t page = 0; page < 0x100; page++) {
+        bus.readPages[page] = &machine.memory[page << 8];
+        bus.writePages[page] = &machine.memory[page << 8];
+        bus.mappings[page] = {};
+    }
+
+    bus.hasDevices = false;
+    bus.hasDeviceReads = false;
+}
+
+bool mapDevice (Machine& machine, uint8_t firstPage, uint8_t lastPage, const Mapping& mapping) {
+    auto& bus = machine.bus;
+
+    if (firstPage < firstDevicePage || lastPage < firstPage) {
+        return false;
+    }
+
+    for (size_t page = firstPage; page <= lastPage; page++) {
+        if (bus.mappings[page].read != nullptr || bus.mappings[page].write != nullptr) {
+            return false;
+        }
+    }
+
+    for (size_t page = firstPage; page <= lastPage; page++) {
+        bus.mappings[page] = mapping;
+        bus.readPages[page] = mapping.read == nullptr ? &machine.memory[page << 8] : nullptr;
+        updateWritePage(machine, page);
+    }
+
+    bus.hasDevices = true;
+    bus.hasDeviceReads = bus.hasDeviceReads || mapping.read != nullptr;
+
+    return true;
+}
+
+uint8_t readSlow (Machine& machine, uint16_t address) {
+    const auto& mapping = machine.bus.mappings[address >> 8];
+    machine.bus.slowReads++;
+
+    return mapping.read(machine, mapping.device, address);
+}
+
+void writeSlow (Machine& machine, uint16_t address, uint8_t value) {
+    machine.memory[address] = value;
+    wroteSlow(machine, address);
+}
+
+void wroteSlow (Machine& machine, uint16_t address) {
+    const auto& mapping = machine.bus.mappings[address >> 8];
+    machine.bus.slowWrites++;
+    markDirtyPage(machine, address >> 8);
+
+    // the running block only stops when the device brought the deadline closer, a framebuffer store lets it go on
+    if (mapping.write != nullptr) {
+        const auto deadline = machine.scheduler.deadline;
+        mapping.write(machine, mapping.device, address, machine.memory[address]);
+
+        if (machine.scheduler.deadline < deadline) {
+            machine.blockCache.leave = true;
+        }
+    }
+
+    if (machine.blockCache.pageRefs[address >> 8] != 0) {
+        invalidateCode(machine, address);
+    }
+}
+
+void updateWritePage (Machine& machine, uint8_t page) {
+    const auto& bus = machine.bus;
+    const auto clean = bus.trackingDirty && !hasPage(bus.dirtyPages, page);
+    const auto slow = bus.mappings[page].write != nullptr || machine.blockCache.pageRefs[page] != 0 || clean;
+    machine.bus.writePages[page] = slow ? nullptr : &machine.memory[page << 8];
+}
+
+void trackDirtyPages (Machine& machine) {
+    machine.bus.dirtyPages = {};
+    machine.bus.trackingDirty = true;
+
+    for (size_t page = 0; page < 0x100; page++) {
+        updateWritePage(machine, page);
+    }
+}
+
+void markDirtyPage (Machine& machine, uint8_t page) {
+    auto& bus = machine.bus;
+
+    if (!bus.trackingDirty || hasPage(bus.dirtyPages, page)) {
+        return;
+    }
+
+    bus.dirtyPages[page >> 6] |= uint64_t { 1 } << (page & 63);
+    updateWritePage(machine, page);
+}
+
+std::string formatBusStats (const Machine& machine) {
+    const auto& bus = machine.bus;
+    const auto slow = bus.slowReads + bus.slowWrites;
+    char line[160];
+
+    if (bus.accesses != 0) {
+        snprintf(
+            line, sizeof(line), "%llu slow reads, %llu slow writes, %.3f%% of %llu accesses\n",
+            static_cast<unsigned long long>(bus.slowReads), static_cast<unsigned long long>(bus.slowWrites),
+            100.0 * slow / bus.accesses, static_cast<unsigned long long>(bus.accesses)
+        );
+    } else {
+        snprintf(
+            line, sizeof(line), "%llu slow reads, %llu slow writes, %.3f per 1000 instructions\n",
+            static_cast<unsigned long long>(bus.slowReads), static_cast<unsigned long long>(bus.slowWrites),
+            machine.instructions == 0 ? 0.0 : 1000.0 * slow / machine.instructions
+        );
+    }
+
+    return line;
+}
@@ -0,0 +1,78 @@
+#ifndef BUS_H
+#define BUS_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+struct Machine;
+
+// bit n % 64 of word n / 64 for page n
+typedef std::array<uint64_t, 4> PageSet;
+
+inline bool hasPage (const PageSet& set, uint8_t page) {
+    return (set[page >> 6] >> (page & 63)) & 1;
+}
+
+// device handlers get the full address and the device they were mapped with
+typedef uint8_t (*DeviceRead) (Machine&, void* device, uint16_t address);
+typedef void (*DeviceWrite) (Machine&, void* device, uint16_t address, uint8_t value);
+
+// either handler may be null, loads then come from the page's memory and stores go unnoticed
+struct Mapping {
+    void* device = nullptr;
+    DeviceRead read = nullptr;
+    DeviceWrite write = nullptr;
+};
+
+// the address space as 256 pages, plain RAM pages are loaded from and stored to straight through their host pointer
+struct Bus {
+    // null sends the access down the slow path, for loads when a device reads the page
+    // and for stores when a device watches it, the block cache holds code from it or it is not yet dirty
+    std::array<uint8_t*, 0x100> readPages {};
+    std::array<uint8_t*, 0x100> writePages {};
+
+    // the pages stored to since tracking began, a page only takes the slow path for its first store
+    PageSet dirtyPages {};
+    bool trackingDirty = false;
+
+    std::array<Mapping, 0x100> mappings {};
+    bool hasDevices = false;
+    bool hasDeviceReads = false;
+
+    // every access is only counted in cycle-accurate runs, fast ones count the slow path alone
+    uint64_t accesses = 0;
+    uint64_t slowReads = 0;
+    uint64_t slowWrites = 0;
+};
+
+constexpr uint8_t firstDevicePage = 0x02;
+
+// points every page at the machine's own memory
+void mapMemory (Machine&);
+
+// false when the pages overlap zero page, the stack or an earlier device,
+// devices are mapped while the machine is set up, before any code has run
+bool mapDevice (Machine&, uint8_t firstPage, uint8_t lastPage, const Mapping&);
+
+[[gnu::cold]] uint8_t readSlow (Machine&, uint16_t address);
+
+// stores always land in memory, the page's device and the block cache see them afterwards
+[[gnu::cold]] void writeSlow (Machine&, uint16_t address, uint8_t value);
+void wroteSlow (Machine&, uint16_t address);
+
+// takes the page off the store fast path while cached code or a device needs to see its stores
+void updateWritePage (Machine&, uint8_t page);
+
+// clears the dirty pages and starts noting them, every page goes off the store fast path until it is stored to
+void trackDirtyPages (Machine&);
+
+// for stores that go around the bus, nothing while pages are not tracked
+void markDirtyPage (Machine&, uint8_t page);
+
+// the slow path's share of all accesses where they were counted, per instruction otherwise
+std::string formatBusStats (const Machine&);
+
+
+
+#endif //BUS_H
@@ -0,0 +1,87 @@
+#include <cstdio>
+
+#include "Debugger.h"
+
+
+void updateDebugging (Machine& machine) {
+    const auto& debugger = *machine.debugger;
+    machine.debugging = debugger.breakpointCount != 0 || debugger.watchCount != 0;
+}
+
+void setBreakpoint (Machine& machine, uint16_t pc, bool set) {
+    auto& debugger = *machine.debugger;
+
+    if (debugger.breakpoints.test(pc) != set) {
+        debugger.breakpoints.set(pc, set);
+        debugger.breakpointCount += set ? 1 : -1;
+    }
+
+    updateDebugging(machine);
+}
+
+void setWatch (Machine& machine, const Watch& watch) {
+    auto& debugger = *machine.debugger;
+
+    for (uint32_t address = watch.first; address <= watch.last; address++) {
+        debugger.watchCount += (watch.kinds != 0) - (debugger.watches[address] != 0);
+        debugger.watches[address] = watch.kinds;
+    }
+
+    for (uint32_t page = watch.first >> 8; page <= watch.last >> 8; page++) {
+        uint8_t kinds = 0;
+
+        for (uint32_t address = page << 8; address < (page + 1) << 8; address++) {
+            kinds |= debugger.watches[address];
+        }
+
+        debugger.watchPages[page] = kinds;
+    }
+
+    updateDebugging(machine);
+}
+
+void clearDebugger (Machine& machine) {
+    auto& debugger = *machine.debugger;
+
+    debugger.breakpoints.reset();
+    debugger.breakpointCount = 0;
+    debugger.watches.fill(0);
+    debugger.watchPages.fill(0);
+    debugger.watchCount = 0;
+    debugger.stopped = false;
+    debugger.skipBreakpoint = noBreakpoint;
+
+    updateDebugging(machine);
+}
+
+void watched (Machine& machine, uint16_t address, uint8_t value, WatchKind kind) {
+    auto& debugger = *machine.debugger;
+
+    if (debugger.stopped || (debugger.watches[address] & kind) == 0) {
+        return;
+    }
+
+    // the loop fills in the pc once the instruction is done
+    debugger.stopped = true;
+    debugger.stop = { kind == WatchRead ? StopReason::Read : StopReason::Write, 0, address, value };
+}
+
+std::string formatStop (const DebugStop& stop) {
+    char line[96];
+
+    switch (stop.reason) {
+        case StopReason::Breakpoint:
+            snprintf(line, sizeof(line), "stopped at the breakpoint at $%04x", stop.pc);
+            break;
+
+        case StopReason::Read:
+            snprintf(line, sizeof(line), "stopped after $%04x read $%02x from $%04x", stop.pc, stop.value, stop.address);
+            break;
+
+        case StopReason::Write:
+            snprintf(line, sizeof(line), "stopped after $%04x wrote $%02x to $%04x", stop.pc, stop.value, stop.address);
+            break;
+    }
+
+    return line;
+}
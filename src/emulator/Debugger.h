@@ -0,0 +1,98 @@
+#ifndef DEBUGGER_H
+#define DEBUGGER_H
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <string>
+
+#include "Machine.h"
+
+
+
+enum WatchKind : uint8_t {
+    WatchRead = 0x01,
+    WatchWrite = 0x02,
+};
+
+enum class StopReason : uint8_t {
+    Breakpoint,
+    Read,
+    Write,
+};
+
+// a breakpoint stops before the instruction at pc runs, a watch after the instruction at pc accessed the address
+struct DebugStop {
+    StopReason reason = StopReason::Breakpoint;
+    uint16_t pc = 0;
+    uint16_t address = 0;
+    uint8_t value = 0;
+};
+
+struct Watch {
+    uint16_t first;
+    uint16_t last;
+    uint8_t kinds;
+};
+
+constexpr uint32_t noBreakpoint = 0x10000;
+
+// the run loops only look at this while the machine is debugging, which it is for as long as anything is set
+struct Debugger {
+    std::bitset<0x10000> breakpoints;
+    size_t breakpointCount = 0;
+
+    // the kinds watched at each address, and every kind watched somewhere in each page
+    std::array<uint8_t, 0x10000> watches {};
+    std::array<uint8_t, 0x100> watchPages {};
+    size_t watchCount = 0;
+
+    // the run returned early, the next one goes on from there without stopping at the same breakpoint again
+    bool stopped = false;
+    DebugStop stop;
+    uint32_t skipBreakpoint = noBreakpoint;
+};
+
+// these need the machine's debugger set, and switch its run loops over when the first is set or the last cleared
+void setBreakpoint (Machine&, uint16_t pc, bool set);
+
+// kinds of 0 stops watching the addresses
+void setWatch (Machine&, const Watch&);
+
+void clearDebugger (Machine&);
+
+// from the debug loops' accesses, the first watched one of an instruction stops the run
+[[gnu::cold]] void watched (Machine&, uint16_t address, uint8_t value, WatchKind);
+
+std::string formatStop (const DebugStop&);
+
+// the timing the debug loops run with, which also reports accesses to watched pages
+template <typename Timing>
+struct WatchedTiming : Timing {
+    static uint8_t read (Machine& machine, uint16_t address) {
+        const auto value = Timing::read(machine, address);
+        noteAccess(machine, address, value, WatchRead);
+        return value;
+    }
+
+    static uint8_t readRam (Machine& machine, uint16_t address) {
+        const auto value = Timing::readRam(machine, address);
+        noteAccess(machine, address, value, WatchRead);
+        return value;
+    }
+
+    static void write (Machine& machine, uint16_t address, uint8_t value) {
+        Timing::write(machine, address, value);
+        noteAccess(machine, address, value, WatchWrite);
+    }
+
+    static void noteAccess (Machine& machine, uint16_t address, uint8_t value, WatchKind kind) {
+        if (machine.debugger->watchPages[address >> 8] & kind) [[unlikely]] {
+            watched(machine, address, value, kind);
+        }
+    }
+};
+
+
+
+#endif //DEBUGGER_H
@@ -0,0 +1,69 @@
+#ifndef FLAGS_H
+#define FLAGS_H
+
+#include <cstdint>
+
+#include "Machine.h"
+
+
+
+// N, Z, C and V written into P by every instruction that affects them
+struct EagerFlags {
+    static void setN (Cpu& cpu, uint8_t source) { cpu.p = (cpu.p & ~FlagN) | (source & FlagN); }
+    static void setZ (Cpu& cpu, uint8_t source) { cpu.p = source == 0 ? cpu.p | FlagZ : cpu.p & ~FlagZ; }
+    static void setNZ (Cpu& cpu, uint8_t value) { cpu.p = (cpu.p & ~(FlagN | FlagZ)) | (value & FlagN) | (value == 0 ? FlagZ : 0); }
+    static void setCarry (Cpu& cpu, bool carry) { cpu.p = (cpu.p & ~FlagC) | carry; }
+
+    // V is bit 7 of the source
+    static void setOverflow (Cpu& cpu, uint8_t source) { cpu.p = (cpu.p & ~FlagV) | ((source & 0x80) >> 1); }
+
+    static bool negative (const Cpu& cpu) { return cpu.p & FlagN; }
+    static bool zero (const Cpu& cpu) { return cpu.p & FlagZ; }
+    static uint8_t carry (const Cpu& cpu) { return cpu.p & FlagC; }
+    static bool overflow (const Cpu& cpu) { return cpu.p & FlagV; }
+
+    static uint8_t status (const Cpu& cpu) { return cpu.p; }
+    static void setStatus (Cpu& cpu, uint8_t p) { cpu.p = p; }
+
+    static void enter (Cpu&) {}
+    static void leave (Cpu&) {}
+};
+
+// N, Z, C and V kept as the values they are derived from, most are overwritten before anything reads them
+struct LazyFlags {
+    static void setN (Cpu& cpu, uint8_t source) { cpu.n = source; }
+    static void setZ (Cpu& cpu, uint8_t source) { cpu.z = source; }
+    static void setNZ (Cpu& cpu, uint8_t value) { cpu.n = cpu.z = value; }
+    static void setCarry (Cpu& cpu, bool carry) { cpu.c = carry; }
+    static void setOverflow (Cpu& cpu, uint8_t source) { cpu.v = source; }
+
+    static bool negative (const Cpu& cpu) { return cpu.n & 0x80; }
+    static bool zero (const Cpu& cpu) { return cpu.z == 0; }
+    static uint8_t carry (const Cpu& cpu) { return cpu.c; }
+    static bool overflow (const Cpu& cpu) { return cpu.v & 0x80; }
+
+    static uint8_t status (const Cpu& cpu) {
+        return (cpu.p & ~(FlagN | FlagZ | FlagC | FlagV)) | (cpu.n & FlagN) | (cpu.z == 0 ? FlagZ : 0) | cpu.c | ((cpu.v & 0x80) >> 1);
+    }
+
+    static void setStatus (Cpu& cpu, uint8_t p) {
+        cpu.p = p;
+        cpu.n = p;
+        cpu.z = ~p & FlagZ;
+        cpu.c = p & FlagC;
+        cpu.v = p << 1;
+    }
+
+    // outside of a run P holds every flag, the sources are only trusted while the core runs
+    static void enter (Cpu& cpu) { setStatus(cpu, cpu.p); }
+    static void leave (Cpu& cpu) { cpu.p = status(cpu); }
+};
+
+// recompiled blocks keep N, Z, C and V in P, so a jit machine evaluates them eagerly throughout
+inline bool usesLazyFlags (const Machine& machine) {
+    return machine.flags == FlagEvaluation::Lazy && machine.engine != Engine::Jit;
+}
+
+
+
+#endif //FLAGS_H
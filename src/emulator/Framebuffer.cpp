@@ -0,0 +1,69 @@
+#include "Framebuffer.h"
+#include "Machine.h"
+
+
+constexpr uint16_t framebufferEnd = framebufferAddress + framebufferWidth * framebufferHeight;
+
+// the top bits of each field are repeated into the low ones, so that full intensity is 255
+constexpr std::array<Rgba, 0x100> makePalette () {
+    std::array<Rgba, 0x100> palette {};
+
+    for (int value = 0; value < 0x100; value++) {
+        const auto red = (value >> 5) & 0x07;
+        const auto green = (value >> 2) & 0x07;
+        const auto blue = value & 0x03;
+
+        palette[value] = {
+            static_cast<uint8_t>((red << 5) | (red << 2) | (red >> 1)),
+            static_cast<uint8_t>((green << 5) | (green << 2) | (green >> 1)),
+            static_cast<uint8_t>(blue * 0x55),
+            0xff,
+        };
+    }
+
+    return palette;
+}
+
+constexpr auto palette = makePalette();
+
+void writeFramebuffer (Machine&, void* device, uint16_t address, uint8_t) {
+    auto& framebuffer = *static_cast<Framebuffer*>(device);
+
+    // the last page runs on past the final row
+    if (address < framebufferEnd) {
+        framebuffer.dirtyRows[(address - framebufferAddress) / framebufferWidth] = true;
+        framebuffer.dirty = true;
+    }
+}
+
+bool attachFramebuffer (Machine& machine, Framebuffer& framebuffer) {
+    framebuffer.dirtyRows.fill(true);
+    framebuffer.dirty = true;
+
+    return mapDevice(machine, framebufferAddress >> 8, (framebufferEnd - 1) >> 8, { &framebuffer, nullptr, writeFramebuffer });
+}
+
+bool convertFramebuffer (const Machine& machine, Framebuffer& framebuffer) {
+    if (!framebuffer.dirty) {
+        return false;
+    }
+
+    for (int row = 0; row < framebufferHeight; row++) {
+        if (!framebuffer.dirtyRows[row]) {
+            continue;
+        }
+
+        const auto* source = &machine.memory[framebufferAddress + row * framebufferWidth];
+        auto* target = &framebuffer.pixels[row * framebufferWidth];
+
+        for (int column = 0; column < framebufferWidth; column++) {
+            target[column] = palette[source[column]];
+        }
+
+        framebuffer.dirtyRows[row] = false;
+    }
+
+    framebuffer.dirty = false;
+
+    return true;
+}
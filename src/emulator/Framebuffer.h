@@ -0,0 +1,37 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <array>
+#include <cstdint>
+
+struct Machine;
+
+
+
+constexpr int framebufferWidth = 160;
+constexpr int framebufferHeight = 100;
+constexpr uint16_t framebufferAddress = 0x8000;
+
+struct Rgba {
+    uint8_t r, g, b, a;
+};
+
+// one byte per pixel, row after row, as RRRGGGBB
+// stores land in memory as usual, the device only notes which rows have to be converted again
+struct Framebuffer {
+    std::array<bool, framebufferHeight> dirtyRows {};
+    bool dirty = false;
+
+    // what the host uploads, kept between frames so that clean rows cost nothing
+    std::array<Rgba, framebufferWidth * framebufferHeight> pixels {};
+};
+
+// false when the pages are already taken, see mapDevice, every row starts out dirty
+bool attachFramebuffer (Machine&, Framebuffer&);
+
+// converts the dirty rows into pixels, false when there were none
+bool convertFramebuffer (const Machine&, Framebuffer&);
+
+
+
+#endif //FRAMEBUFFER_H
@@ -0,0 +1,26 @@
+#include <algorithm>
+#include <bit>
+
+#include "Heatmap.h"
+
+
+void decayHeatmap (Heatmap& heatmap, uint64_t frames) {
+    const auto shift = std::min<uint64_t>(frames, 31);
+
+    for (size_t address = 0; address < 0x10000; address++) {
+        heatmap.reads[address] >>= shift;
+        heatmap.writes[address] >>= shift;
+        heatmap.executions[address] >>= shift;
+    }
+}
+
+// a single access already shows, a million a frame is as bright as it gets
+uint8_t heat (uint32_t count) {
+    return count == 0 ? 0 : std::min<uint32_t>(255, 48 + 12 * std::bit_width(count));
+}
+
+void paintHeatmap (const Heatmap& heatmap, Rgba* pixels) {
+    for (size_t address = 0; address < 0x10000; address++) {
+        pixels[address] = { heat(heatmap.writes[address]), heat(heatmap.reads[address]), heat(heatmap.executions[address]), 255 };
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include <array>
+#include <cstdint>
+
+#include "Framebuffer.h"
+#include "Machine.h"
+
+
+
+// a pixel per byte, a row per page, the zero page at the top
+constexpr int heatmapSide = 256;
+
+// the accesses to each byte, halved every frame so that they show what the program is doing now,
+// reads take in the fetches of opcodes and operands, executions count the first byte of each instruction
+struct Heatmap {
+    std::array<uint32_t, 0x10000> reads {};
+    std::array<uint32_t, 0x10000> writes {};
+    std::array<uint32_t, 0x10000> executions {};
+};
+
+// halves every count once per frame
+void decayHeatmap (Heatmap&, uint64_t frames);
+
+// writes in red, reads in green and executions in blue, each brighter by the bit length of its count
+void paintHeatmap (const Heatmap&, Rgba* pixels);
+
+// the timing the observed loop runs with while a heatmap is set, which also counts every access
+template <typename Timing>
+struct HeatTiming : Timing {
+    static uint8_t read (Machine& machine, uint16_t address) {
+        machine.heatmap->reads[address]++;
+        return Timing::read(machine, address);
+    }
+
+    static uint8_t readRam (Machine& machine, uint16_t address) {
+        machine.heatmap->reads[address]++;
+        return Timing::readRam(machine, address);
+    }
+
+    static void write (Machine& machine, uint16_t address, uint8_t value) {
+        machine.heatmap->writes[address]++;
+        Timing::write(machine, address, value);
+    }
+};
+
+
+
+#endif //HEATMAP_H
@@ -0,0 +1,40 @@
+#include "Input.h"
+#include "Machine.h"
+
+
+uint8_t readInput (Machine&, void* device, uint16_t address) {
+    const auto& input = *static_cast<const Input*>(device);
+
+    switch (address & 0x01) {
+        case 0: return input.buttons;
+        default: return input.character;
+    }
+}
+
+void writeInput (Machine&, void* device, uint16_t address, uint8_t) {
+    auto& input = *static_cast<Input*>(device);
+
+    if ((address & 0x01) != 0) {
+        input.character = 0;
+    }
+}
+
+bool attachInput (Machine& machine, Input& input, uint8_t page) {
+    return mapDevice(machine, page, page, { &input, readInput, writeInput });
+}
+
+void applyInput (Input& input, const InputEvent& event) {
+    switch (event.kind) {
+        case InputKind::Press:
+            input.buttons |= event.value;
+            break;
+
+        case InputKind::Release:
+            input.buttons &= ~event.value;
+            break;
+
+        case InputKind::Character:
+            input.character = event.value;
+            break;
+    }
+}
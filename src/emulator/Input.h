@@ -0,0 +1,50 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <cstdint>
+
+struct Machine;
+
+
+
+enum Button : uint8_t {
+    ButtonUp = 0x01,
+    ButtonDown = 0x02,
+    ButtonLeft = 0x04,
+    ButtonRight = 0x08,
+    ButtonA = 0x10,
+    ButtonB = 0x20,
+    ButtonSelect = 0x40,
+    ButtonStart = 0x80,
+};
+
+// registers, mirrored across the page:
+// +0 the buttons held down, one bit each
+// +1 the last character typed, 0 once any store acknowledged it
+struct Input {
+    uint8_t buttons = 0;
+    uint8_t character = 0;
+};
+
+enum class InputKind : uint8_t {
+    Press,
+    Release,
+    Character,
+};
+
+// a button for Press and Release, the character code otherwise
+struct InputEvent {
+    InputKind kind;
+    uint8_t value;
+};
+
+constexpr uint8_t inputPage = 0xFD;
+
+// false when the page is already taken, see mapDevice
+bool attachInput (Machine&, Input&, uint8_t page = inputPage);
+
+void applyInput (Input&, const InputEvent&);
+
+
+
+#endif //INPUT_H
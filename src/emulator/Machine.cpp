@@ -0,0 +1,43 @@
+#include "Machine.h"
+
+
+bool load (Machine& machine, const std::vector<uint8_t>& program) {
+    if (program.size() > resetVector - programStart) {
+        return false;
+    }
+
+    // through writeByte so that nothing stale stays in the block cache
+    for (size_t index = 0; index < program.size(); index++) {
+        writeByte(machine, programStart + index, program[index]);
+    }
+
+    writeByte(machine, resetVector, programStart & 0xff);
+    writeByte(machine, resetVector + 1, programStart >> 8);
+
+    return true;
+}
+
+void reset (Machine& machine) {
+    machine.cpu = Cpu {};
+    machine.cpu.pc = readWord(machine, resetVector);
+    machine.cycles = 0;
+    machine.instructions = 0;
+    machine.halted = false;
+    machine.bus.accesses = 0;
+    machine.bus.slowReads = 0;
+    machine.bus.slowWrites = 0;
+    clearEvents(machine);
+    machine.idle.nextProbe = minIdleProbeInterval;
+    machine.idle.interval = minIdleProbeInterval;
+    machine.idle.skippedCycles = 0;
+}
+
+uint64_t memoryDigest (const Machine& machine) {
+    uint64_t hash = 0xcbf29ce484222325;
+
+    for (const auto byte : machine.memory) {
+        hash = (hash ^ byte) * 0x100000001b3;
+    }
+
+    return hash;
+}
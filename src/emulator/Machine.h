@@ -0,0 +1,206 @@
+#ifndef MACHINE_H
+#define MACHINE_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "BlockCache.h"
+#include "Bus.h"
+#include "Scheduler.h"
+
+
+enum Flag : uint8_t {
+    FlagC = 0x01,
+    FlagZ = 0x02,
+    FlagI = 0x04,
+    FlagD = 0x08,
+    FlagB = 0x10,
+    FlagU = 0x20,
+    FlagV = 0x40,
+    FlagN = 0x80,
+};
+
+struct Cpu {
+    uint8_t a = 0;
+    uint8_t x = 0;
+    uint8_t y = 0;
+    uint8_t sp = 0xFD;
+    uint8_t p = FlagI | FlagU;
+    uint16_t pc = 0;
+
+    // where LazyFlags keeps N, Z, C and V while the core runs
+    uint8_t n = 0;
+    uint8_t z = 1;
+    uint8_t c = 0;
+    uint8_t v = 0;
+};
+
+enum class FlagEvaluation : uint8_t {
+    Lazy,
+    Eager,
+};
+
+enum class CpuVariant : uint8_t {
+    Nmos,
+    NmosUndocumented,
+    Cmos,
+};
+
+enum class Accuracy : uint8_t {
+    Fast,
+    Cycle,
+};
+
+enum class Engine : uint8_t {
+    Interpreter,
+    Threaded,
+    BlockCache,
+    Jit,
+};
+
+struct EngineName {
+    Engine engine;
+    std::string_view name;
+};
+
+// the engines compiled into this build, as spelled on the command line
+constexpr EngineName engineNames[] {
+    { Engine::Interpreter, "interpreter" },
+#if HAUSTIER_THREADED
+    { Engine::Threaded, "threaded" },
+#endif
+    { Engine::BlockCache, "cached" },
+#if HAUSTIER_JIT
+    { Engine::Jit, "jit" },
+#endif
+};
+
+constexpr std::string_view getName (Engine engine) {
+    for (const auto& [named, name] : engineNames) {
+        if (named == engine) {
+            return name;
+        }
+    }
+
+    return "unavailable";
+}
+
+struct Machine;
+
+struct BusEvent {
+    uint64_t cycle;
+    uint16_t address;
+    uint8_t value;
+    bool write;
+};
+
+typedef void (*BusListener) (const Machine&, const BusEvent&);
+
+struct Debugger;
+struct Heatmap;
+struct Profile;
+struct Trace;
+
+constexpr uint64_t minIdleProbeInterval = 128;
+constexpr uint64_t maxIdleProbeInterval = 0x10000;
+constexpr size_t maxIdleLoopInstructions = 32;
+
+// the run loop looks for a loop that goes round without changing anything now and then,
+// waiting twice as long after each look that finds none
+struct IdleLoops {
+    bool skip = true;
+    uint64_t nextProbe = minIdleProbeInterval;
+    uint64_t interval = minIdleProbeInterval;
+    uint64_t skippedCycles = 0;
+};
+
+struct Machine {
+    // the bus points into memory, so a machine stays where it was made
+    Machine () { mapMemory(*this); }
+    Machine (const Machine&) = delete;
+    Machine& operator= (const Machine&) = delete;
+
+    Cpu cpu;
+    std::array<uint8_t, 0x10000> memory {};
+    Bus bus;
+    Scheduler scheduler;
+    IdleLoops idle;
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    bool halted = false;
+
+    CpuVariant variant = CpuVariant::Nmos;
+    Engine engine = Engine::BlockCache;
+    FlagEvaluation flags = FlagEvaluation::Lazy;
+    BlockCache blockCache;
+
+    // cycle-accurate runs count the bus cycles of the current instruction and report each access
+    Accuracy accuracy = Accuracy::Fast;
+    uint32_t busCycle = 0;
+    BusListener busListener = nullptr;
+
+    // record or count every instruction before it runs, on the interpreter whichever engine was picked
+    Trace* trace = nullptr;
+#if HAUSTIER_PROFILER
+    Profile* profile = nullptr;
+#endif
+
+    // counts every access and instruction, on the interpreter as well
+    Heatmap* heatmap = nullptr;
+
+    // the run loops switch to ones that look for breakpoints and watched accesses while debugging is set,
+    // which the debugger's functions do for as long as it has any
+    Debugger* debugger = nullptr;
+    bool debugging = false;
+};
+
+constexpr uint16_t programStart = 0x0200;
+constexpr uint16_t nmiVector = 0xFFFA;
+constexpr uint16_t resetVector = 0xFFFC;
+constexpr uint16_t irqVector = 0xFFFE;
+
+constexpr uint32_t clockRate = 1'000'000;
+
+inline uint8_t readByte (Machine& machine, uint16_t address) {
+    if (const auto* page = machine.bus.readPages[address >> 8]) [[likely]] {
+        return page[address & 0xff];
+    }
+
+    return readSlow(machine, address);
+}
+
+inline void writeByte (Machine& machine, uint16_t address, uint8_t value) {
+    if (auto* page = machine.bus.writePages[address >> 8]) [[likely]] {
+        page[address & 0xff] = value;
+    } else {
+        writeSlow(machine, address, value);
+    }
+}
+
+inline uint16_t readWord (Machine& machine, uint16_t address) {
+    return readByte(machine, address) | (readByte(machine, address + 1) << 8);
+}
+
+// memory as it stands, without going through a device
+inline uint8_t peekByte (const Machine& machine, uint16_t address) {
+    return machine.memory[address];
+}
+
+inline uint16_t peekWord (const Machine& machine, uint16_t address) {
+    return peekByte(machine, address) | (peekByte(machine, address + 1) << 8);
+}
+
+// copies the program to programStart and points the reset vector at it
+bool load (Machine&, const std::vector<uint8_t>& program);
+
+// also drops every pending event, devices are attached afterwards
+void reset (Machine&);
+
+// FNV-1a over the whole address space
+uint64_t memoryDigest (const Machine&);
+
+
+
+#endif //MACHINE_H
@@ -0,0 +1,287 @@
+#include <cstdio>
+#include <cstring>
+
+#include "cpu.h"
+#include "Movie.h"
+
+
+uint64_t stateHash (const Machine& machine, const StateDevices& devices, std::vector<uint8_t>& state) {
+    saveState(machine, devices, state);
+
+    uint64_t hash = 0xcbf29ce484222325;
+
+    for (const auto byte : state) {
+        hash = (hash ^ byte) * 0x100000001b3;
+    }
+
+    return hash;
+}
+
+size_t encodeVarint (uint8_t* bytes, uint64_t value) {
+    size_t size = 0;
+
+    for (; value >= 0x80; value >>= 7) {
+        bytes[size++] = 0x80 | (value & 0x7f);
+    }
+
+    bytes[size++] = value;
+    return size;
+}
+
+// tag, frames and cycles since the last record, payload
+void writeMovieRecord (Movie& movie, MovieTag tag, uint64_t frame, uint64_t cycle, const uint8_t* payload, size_t payloadSize) {
+    uint8_t bytes[32];
+    size_t size = 0;
+
+    bytes[size++] = static_cast<uint8_t>(tag);
+    size += encodeVarint(bytes + size, frame - movie.frame);
+    size += encodeVarint(bytes + size, cycle - movie.cycle);
+    memcpy(bytes + size, payload, payloadSize);
+    size += payloadSize;
+
+    movie.file.write(reinterpret_cast<const char*>(bytes), size);
+    movie.frame = frame;
+    movie.cycle = cycle;
+}
+
+void writeMovieHash (Movie& movie, MovieTag tag, uint64_t frame, const Machine& machine, const StateDevices& devices) {
+    const auto hash = stateHash(machine, devices, movie.state);
+    uint8_t bytes[8];
+
+    for (auto index = 0; index < 8; index++) {
+        bytes[index] = hash >> (8 * index);
+    }
+
+    writeMovieRecord(movie, tag, frame, machine.cycles, bytes, sizeof(bytes));
+}
+
+bool openMovie (Movie& movie, const char* path, const Machine& machine, const StateDevices& devices, const uint8_t* base) {
+    movie.file = std::ofstream { path, std::ios::binary | std::ios::trunc };
+    movie.frame = 0;
+    movie.cycle = machine.cycles;
+    movie.open = movie.file.is_open();
+
+    if (!movie.open) {
+        return false;
+    }
+
+    saveState(machine, devices, movie.state, base);
+
+    const auto size = static_cast<uint32_t>(movie.state.size());
+    const uint8_t header[] {
+        movieMagic[0], movieMagic[1], movieMagic[2], movieMagic[3],
+        movieVersion & 0xff, movieVersion >> 8,
+        static_cast<uint8_t>(machine.variant), static_cast<uint8_t>(machine.accuracy),
+        static_cast<uint8_t>(size), static_cast<uint8_t>(size >> 8), static_cast<uint8_t>(size >> 16), static_cast<uint8_t>(size >> 24),
+    };
+
+    movie.file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    movie.file.write(reinterpret_cast<const char*>(movie.state.data()), movie.state.size());
+
+    return movie.file.good();
+}
+
+void recordMovieInput (Movie& movie, uint64_t frame, uint64_t cycle, const InputEvent& input) {
+    const uint8_t bytes[] { static_cast<uint8_t>(input.kind), input.value };
+    writeMovieRecord(movie, MovieTag::Input, frame, cycle, bytes, sizeof(bytes));
+}
+
+void recordMovieCheckpoint (Movie& movie, uint64_t frame, const Machine& machine, const StateDevices& devices) {
+    writeMovieHash(movie, MovieTag::Checkpoint, frame, machine, devices);
+}
+
+bool closeMovie (Movie& movie, uint64_t frame, const Machine& machine, const StateDevices& devices) {
+    writeMovieHash(movie, MovieTag::End, frame, machine, devices);
+
+    movie.file.close();
+    movie.open = false;
+
+    return !movie.file.fail();
+}
+
+bool openMovieReader (MovieReader& reader, const char* path) {
+    std::ifstream file { path, std::ios::binary };
+
+    if (!file.is_open()) {
+        return false;
+    }
+
+    reader.bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    const auto& bytes = reader.bytes;
+    constexpr size_t headerSize = 12;
+
+    if (bytes.size() < headerSize || memcmp(bytes.data(), movieMagic, sizeof(movieMagic)) != 0) {
+        return false;
+    }
+
+    const auto version = bytes[4] | (bytes[5] << 8);
+    const size_t size = bytes[8] | (bytes[9] << 8) | (bytes[10] << 16) | (static_cast<uint32_t>(bytes[11]) << 24);
+
+    const auto known = bytes[6] <= static_cast<uint8_t>(CpuVariant::Cmos) && bytes[7] <= static_cast<uint8_t>(Accuracy::Cycle);
+
+    if (version > movieVersion || !known || bytes.size() - headerSize < size) {
+        return false;
+    }
+
+    reader.variant = static_cast<CpuVariant>(bytes[6]);
+    reader.accuracy = static_cast<Accuracy>(bytes[7]);
+    reader.start.assign(bytes.begin() + headerSize, bytes.begin() + headerSize + size);
+    reader.next = headerSize + size;
+    reader.frame = 0;
+    reader.cycle = 0;
+
+    return true;
+}
+
+bool readVarint (MovieReader& reader, uint64_t& value) {
+    value = 0;
+
+    for (auto shift = 0; shift < 64; shift += 7) {
+        if (reader.next == reader.bytes.size()) {
+            return false;
+        }
+
+        const auto byte = reader.bytes[reader.next++];
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool readMovie (MovieReader& reader, MovieRecord& record) {
+    uint64_t frames;
+    uint64_t cycles;
+
+    if (reader.next == reader.bytes.size()) {
+        return false;
+    }
+
+    record.tag = static_cast<MovieTag>(reader.bytes[reader.next++]);
+
+    if (!readVarint(reader, frames) || !readVarint(reader, cycles)) {
+        return false;
+    }
+
+    reader.frame += frames;
+    reader.cycle += cycles;
+    record.frame = reader.frame;
+    record.cycle = reader.cycle;
+
+    const auto left = reader.bytes.size() - reader.next;
+    const auto* payload = reader.bytes.data() + reader.next;
+
+    switch (record.tag) {
+        case MovieTag::Input:
+            if (left < 2 || payload[0] > static_cast<uint8_t>(InputKind::Character)) {
+                return false;
+            }
+
+            record.input = { static_cast<InputKind>(payload[0]), payload[1] };
+            reader.next += 2;
+            return true;
+
+        case MovieTag::Checkpoint: [[fallthrough]];
+        case MovieTag::End:
+            if (left < 8) {
+                return false;
+            }
+
+            record.hash = 0;
+
+            for (auto index = 0; index < 8; index++) {
+                record.hash |= static_cast<uint64_t>(payload[index]) << (8 * index);
+            }
+
+            reader.next += 8;
+            return true;
+    }
+
+    return false;
+}
+
+bool replayMovie (Machine& machine, const StateDevices& devices, MovieReader& reader, Replay& replay) {
+    const auto base = machine.memory;
+    machine.variant = reader.variant;
+
+    if (!loadState(machine, devices, reader.start, base.data())) {
+        return false;
+    }
+
+    machine.accuracy = reader.accuracy;
+    reader.cycle = machine.cycles;
+
+    std::vector<uint8_t> state;
+    MovieRecord record;
+
+    while (readMovie(reader, record)) {
+        if (machine.cycles < record.cycle) {
+            runCycles(machine, record.cycle - machine.cycles);
+        }
+
+        replay.frames = record.frame;
+        replay.cycles = machine.cycles;
+
+        // every record was written between instructions, a machine that still runs the same lands right on it
+        if (machine.cycles != record.cycle) {
+            replay.diverged = true;
+            replay.cycleMissed = true;
+            replay.divergedFrame = record.frame;
+            replay.expected = record.cycle;
+            replay.actual = machine.cycles;
+            return true;
+        }
+
+        if (record.tag == MovieTag::Input) {
+            applyInput(*devices.input, record.input);
+            continue;
+        }
+
+        const auto hash = stateHash(machine, devices, state);
+
+        if (hash != record.hash) {
+            replay.diverged = true;
+            replay.divergedFrame = record.frame;
+            replay.expected = record.hash;
+            replay.actual = hash;
+            return true;
+        }
+
+        if (record.tag == MovieTag::End) {
+            replay.complete = true;
+            return true;
+        }
+    }
+
+    return true;
+}
+
+std::string formatReplay (const Replay& replay) {
+    char line[160];
+
+    if (replay.diverged && replay.cycleMissed) {
+        snprintf(
+            line, sizeof(line), "diverged at frame %llu, which the recording reached at cycle %llu and the replay at %llu\n",
+            static_cast<unsigned long long>(replay.divergedFrame), static_cast<unsigned long long>(replay.expected),
+            static_cast<unsigned long long>(replay.actual)
+        );
+    } else if (replay.diverged) {
+        snprintf(
+            line, sizeof(line), "diverged at frame %llu, where the recorded state hashes to %016llx and the replayed one to %016llx\n",
+            static_cast<unsigned long long>(replay.divergedFrame), static_cast<unsigned long long>(replay.expected),
+            static_cast<unsigned long long>(replay.actual)
+        );
+    } else {
+        snprintf(
+            line, sizeof(line), "%s %llu frames, %llu cycles, matching every checkpoint%s\n",
+            replay.complete ? "replayed" : "replayed the first", static_cast<unsigned long long>(replay.frames),
+            static_cast<unsigned long long>(replay.cycles), replay.complete ? " and the final state" : ", the rest is cut off"
+        );
+    }
+
+    return line;
+}
@@ -0,0 +1,102 @@
+#ifndef MOVIE_H
+#define MOVIE_H
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Input.h"
+#include "Machine.h"
+#include "savestate.h"
+
+
+
+// "HMOV", the little-endian version, the cpu variant and the accuracy, the 32-bit length of the start state and the state,
+// saved against the memory the binary loads into, then records up to the end of the file
+constexpr uint8_t movieMagic[4] { 'H', 'M', 'O', 'V' };
+constexpr uint16_t movieVersion = 1;
+
+// every record starts with its tag, then the frames and cycles since the previous record as LEB128 varints,
+// an input is followed by its kind and value, a checkpoint and the end by the 64-bit hash of the state
+enum class MovieTag : uint8_t {
+    Input = 1,
+    Checkpoint,
+    End,
+};
+
+// a checkpoint goes after every this many frames
+constexpr uint64_t movieCheckpointFrames = 60;
+
+struct MovieRecord {
+    MovieTag tag;
+    uint64_t frame;
+    uint64_t cycle;
+    InputEvent input;
+    uint64_t hash;
+};
+
+// input goes in with the cycle it was applied at, so a replay needs no frame timing and lands on it whatever engine it runs,
+// rewinding or loading a state takes the machine where no cycle count leads and has to end the recording first
+struct Movie {
+    std::ofstream file;
+    bool open = false;
+    uint64_t frame = 0;
+    uint64_t cycle = 0;
+
+    std::vector<uint8_t> state;
+};
+
+// FNV-1a of the saved state, which leaves out what the engines keep for themselves
+uint64_t stateHash (const Machine&, const StateDevices&, std::vector<uint8_t>& state);
+
+// false when the file cannot be created, base is the memory the binary loaded into
+bool openMovie (Movie&, const char* path, const Machine&, const StateDevices&, const uint8_t* base);
+
+void recordMovieInput (Movie&, uint64_t frame, uint64_t cycle, const InputEvent&);
+void recordMovieCheckpoint (Movie&, uint64_t frame, const Machine&, const StateDevices&);
+
+// ends the movie with the state reached, false when any of it could not be written
+bool closeMovie (Movie&, uint64_t frame, const Machine&, const StateDevices&);
+
+// the whole of a movie, which takes a few bytes a frame at most
+struct MovieReader {
+    std::vector<uint8_t> bytes;
+    size_t next = 0;
+    CpuVariant variant = CpuVariant::Nmos;
+    Accuracy accuracy = Accuracy::Fast;
+    std::vector<uint8_t> start;
+    uint64_t frame = 0;
+    uint64_t cycle = 0;
+};
+
+// false when the file is missing, is no movie or is of a newer version
+bool openMovieReader (MovieReader&, const char* path);
+
+// false at the end, and when the rest is cut off or malformed
+bool readMovie (MovieReader&, MovieRecord&);
+
+struct Replay {
+    // the last frame reached, and whether that was the end of a complete movie
+    uint64_t frames = 0;
+    uint64_t cycles = 0;
+    bool complete = false;
+
+    // where the replay first missed a record's cycle or hash
+    bool diverged = false;
+    uint64_t divergedFrame = 0;
+    uint64_t expected = 0;
+    uint64_t actual = 0;
+    bool cycleMissed = false;
+};
+
+// runs the machine, set up with the movie's devices and the binary it was recorded with, from the movie's start
+// to its end, applying its input and checking its hashes, false when the start state does not load
+bool replayMovie (Machine&, const StateDevices&, MovieReader&, Replay&);
+
+std::string formatReplay (const Replay&);
+
+
+
+#endif //MOVIE_H
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "assembler/opcodes.h"
+#include "disassembler/disasm.h"
+
+#include "Profile.h"
+
+
+// size is how far on the next instruction starts
+template <typename Variant>
+std::string disassembleAt (const Machine& machine, uint16_t pc, uint8_t& size) {
+    const auto opcode = peekByte(machine, pc);
+    const auto& info = Variant::infos[opcode];
+
+    size = 1 + (info.valid ? operandSize(info.mode) : 0);
+
+    return disassembleInstruction<Variant>(opcode, peekByte(machine, pc + 1), peekByte(machine, pc + 2), pc);
+}
+
+std::string disassembleAt (const Machine& machine, uint16_t pc, uint8_t& size) {
+    switch (machine.variant) {
+        case CpuVariant::Nmos: return disassembleAt<Nmos6502>(machine, pc, size);
+        case CpuVariant::NmosUndocumented: return disassembleAt<Nmos6502Undocumented>(machine, pc, size);
+        case CpuVariant::Cmos: return disassembleAt<Cmos65C02>(machine, pc, size);
+    }
+
+    return {};
+}
+
+std::string formatWhere (const std::vector<Symbol>& symbols, uint16_t pc) {
+    char where[128];
+    const auto* symbol = findSymbol(symbols, pc);
+
+    if (symbol == nullptr) {
+        snprintf(where, sizeof(where), "%04x", pc);
+    } else {
+        snprintf(where, sizeof(where), "%04x %.100s+%u", pc, symbol->name.c_str(), pc - symbol->address);
+    }
+
+    return where;
+}
+
+std::string formatProfile (const Machine& machine, const Profile& profile, const std::vector<Symbol>& symbols) {
+    uint64_t instructions = 0;
+    uint64_t cycles = 0;
+
+    for (size_t pc = 0; pc < 0x10000; pc++) {
+        instructions += profile.instructions[pc];
+        cycles += profile.cycles[pc];
+    }
+
+    const auto share = [cycles] (uint64_t part) {
+        return cycles == 0 ? 0.0 : 100.0 * part / cycles;
+    };
+
+    char line[256];
+    snprintf(
+        line, sizeof(line), "# %llu instructions in %llu cycles\n",
+        static_cast<unsigned long long>(instructions), static_cast<unsigned long long>(cycles)
+    );
+
+    std::string report = line;
+
+    // a gap between two pcs that ran starts a new block, the labels go where the assembler put them
+    auto next = -1;
+    auto symbol = symbols.begin();
+
+    for (size_t pc = 0; pc < 0x10000; pc++) {
+        if (profile.instructions[pc] == 0) {
+            continue;
+        }
+
+        if (next != -1 && next != static_cast<int>(pc)) {
+            report += '\n';
+        }
+
+        for (; symbol != symbols.end() && symbol->address <= pc; symbol++) {
+            if (symbol->address == pc) {
+                report += symbol->name + ":\n";
+            }
+        }
+
+        snprintf(
+            line, sizeof(line), " ; %6.2f%% %llu %llu\n", share(profile.cycles[pc]),
+            static_cast<unsigned long long>(profile.instructions[pc]), static_cast<unsigned long long>(profile.cycles[pc])
+        );
+
+        uint8_t size = 1;
+        report += disassembleAt(machine, pc, size) + line;
+        next = pc + size;
+    }
+
+    std::vector<uint16_t> hottest;
+
+    for (size_t pc = 0; pc < 0x10000; pc++) {
+        if (profile.instructions[pc] != 0) {
+            hottest.push_back(pc);
+        }
+    }
+
+    const auto count = std::min(hottest.size(), profileHotSpots);
+
+    std::partial_sort(hottest.begin(), hottest.begin() + count, hottest.end(), [&profile] (uint16_t left, uint16_t right) {
+        return profile.cycles[left] != profile.cycles[right] ? profile.cycles[left] > profile.cycles[right] : left < right;
+    });
+
+    report += "\n# hot spots: share, cycles, executions, pc\n";
+
+    for (size_t index = 0; index < count; index++) {
+        const auto pc = hottest[index];
+
+        snprintf(
+            line, sizeof(line), "%6.2f%% %-12llu %-12llu %s\n", share(profile.cycles[pc]),
+            static_cast<unsigned long long>(profile.cycles[pc]), static_cast<unsigned long long>(profile.instructions[pc]),
+            formatWhere(symbols, pc).c_str()
+        );
+
+        report += line;
+    }
+
+    if (symbols.empty()) {
+        return report;
+    }
+
+    // each label owns the pcs up to the next one, those before the first label are left out
+    struct Region {
+        const Symbol* symbol;
+        uint64_t instructions;
+        uint64_t cycles;
+    };
+
+    std::vector<Region> regions;
+
+    for (size_t index = 0; index < symbols.size(); index++) {
+        const auto first = symbols[index].address;
+        const size_t last = index + 1 < symbols.size() ? symbols[index + 1].address : 0x10000;
+        Region region { &symbols[index], 0, 0 };
+
+        for (auto pc = static_cast<size_t>(first); pc < last; pc++) {
+            region.instructions += profile.instructions[pc];
+            region.cycles += profile.cycles[pc];
+        }
+
+        if (region.instructions != 0) {
+            regions.push_back(region);
+        }
+    }
+
+    std::stable_sort(regions.begin(), regions.end(), [] (const Region& left, const Region& right) {
+        return left.cycles > right.cycles;
+    });
+
+    report += "\n# labels: share, cycles, executions, label\n";
+
+    for (const auto& region : regions) {
+        snprintf(
+            line, sizeof(line), "%6.2f%% %-12llu %-12llu %04x %.100s\n", share(region.cycles),
+            static_cast<unsigned long long>(region.cycles), static_cast<unsigned long long>(region.instructions),
+            region.symbol->address, region.symbol->name.c_str()
+        );
+
+        report += line;
+    }
+
+    return report;
+}
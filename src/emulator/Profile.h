@@ -0,0 +1,30 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "assembler/symbols.h"
+
+#include "Machine.h"
+
+
+
+// what ran at each pc, counted before the instruction and so at its first byte,
+// interrupt entries belong to no instruction and are not counted
+struct Profile {
+    std::array<uint64_t, 0x10000> instructions {};
+    std::array<uint64_t, 0x10000> cycles {};
+};
+
+constexpr size_t profileHotSpots = 20;
+
+// every pc that ran in decompile's format with its share of the cycles, executions and cycles after it,
+// then the hottest pcs and, given symbols, the cycles spent from each label up to the next
+std::string formatProfile (const Machine&, const Profile&, const std::vector<Symbol>&);
+
+
+
+#endif //PROFILE_H
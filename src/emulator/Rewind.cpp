@@ -0,0 +1,104 @@
+#include <cstring>
+
+#include "Rewind.h"
+
+
+void dropOldest (Rewind& rewind) {
+    do {
+        rewind.used -= rewind.entries.front().size;
+        rewind.entries.pop_front();
+    } while (!rewind.entries.empty() && rewind.entries.front().sequence != rewind.entries.front().keyframe);
+}
+
+// where size bytes go next, making room by dropping the oldest frames
+size_t reserve (Rewind& rewind, size_t size) {
+    // the entries past the head are older than those before it, wrapping around drops them all
+    if (rewind.head + size > rewind.ring.size()) {
+        while (!rewind.entries.empty() && rewind.entries.front().offset >= rewind.head) {
+            dropOldest(rewind);
+        }
+
+        rewind.head = 0;
+    }
+
+    while (!rewind.entries.empty() && rewind.entries.front().offset >= rewind.head && rewind.entries.front().offset < rewind.head + size) {
+        dropOldest(rewind);
+    }
+
+    const auto offset = rewind.head;
+    rewind.head += size;
+
+    return offset;
+}
+
+void recordFrame (Rewind& rewind, Machine& machine, const StateDevices& devices) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto sequence = rewind.nextSequence++;
+
+    // also after the keyframe was dropped, or stepped back past
+    const auto needsKeyframe = !rewind.hasKeyframe || sequence - rewind.keyframe >= rewindKeyframeInterval ||
+        rewind.entries.empty() || rewind.entries.front().sequence > rewind.keyframe;
+
+    if (needsKeyframe) {
+        // sequence numbers are taken again after stepping back
+        rewind.hasLoadedKeyframe = rewind.hasLoadedKeyframe && rewind.loadedKeyframe != sequence;
+        rewind.keyframe = sequence;
+        rewind.hasKeyframe = true;
+        rewind.keyframeMemory = machine.memory;
+        trackDirtyPages(machine);
+        saveState(machine, devices, rewind.state);
+    } else {
+        saveState(machine, devices, rewind.state, rewind.keyframeMemory.data(), &machine.bus.dirtyPages);
+    }
+
+    // a state larger than the whole ring is not kept
+    if (rewind.state.size() <= rewind.ring.size()) {
+        const auto offset = reserve(rewind, rewind.state.size());
+        memcpy(&rewind.ring[offset], rewind.state.data(), rewind.state.size());
+        rewind.entries.push_back({ offset, rewind.state.size(), sequence, rewind.keyframe });
+        rewind.used += rewind.state.size();
+    } else {
+        rewind.hasKeyframe = false;
+    }
+
+    rewind.spent += std::chrono::steady_clock::now() - start;
+}
+
+bool loadEntry (Rewind& rewind, Machine& machine, const StateDevices& devices, const RewindEntry& entry, const uint8_t* base) {
+    rewind.state.assign(&rewind.ring[entry.offset], &rewind.ring[entry.offset] + entry.size);
+    return loadState(machine, devices, rewind.state, base);
+}
+
+bool stepBack (Rewind& rewind, Machine& machine, const StateDevices& devices) {
+    if (rewind.entries.size() < 2) {
+        return false;
+    }
+
+    rewind.used -= rewind.entries.back().size;
+    rewind.head = rewind.entries.back().offset;
+    rewind.entries.pop_back();
+    rewind.nextSequence = rewind.entries.back().sequence + 1;
+
+    const auto entry = rewind.entries.back();
+    auto loaded = true;
+
+    if (entry.sequence == entry.keyframe) {
+        loaded = loadEntry(rewind, machine, devices, entry, nullptr);
+    } else {
+        // the keyframe's memory is what the frames after it were saved against
+        if (!rewind.hasLoadedKeyframe || rewind.loadedKeyframe != entry.keyframe) {
+            const auto& keyframe = rewind.entries[entry.keyframe - rewind.entries.front().sequence];
+            loaded = loadEntry(rewind, machine, devices, keyframe, nullptr);
+            rewind.loadedMemory = machine.memory;
+            rewind.loadedKeyframe = entry.keyframe;
+            rewind.hasLoadedKeyframe = true;
+        }
+
+        loaded = loaded && loadEntry(rewind, machine, devices, entry, rewind.loadedMemory.data());
+    }
+
+    // frames recorded from here on need a keyframe that is still there
+    rewind.hasKeyframe = rewind.hasKeyframe && rewind.keyframe <= entry.sequence;
+
+    return loaded;
+}
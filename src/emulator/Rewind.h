@@ -0,0 +1,61 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "savestate.h"
+
+
+
+constexpr size_t rewindCapacity = 32 << 20;
+
+// every this many frames a whole state, the ones between hold only the pages that differ from it
+constexpr uint32_t rewindKeyframeInterval = 120;
+
+struct RewindEntry {
+    size_t offset;
+    size_t size;
+    uint64_t sequence;
+    uint64_t keyframe;
+};
+
+// one state per frame in a ring of fixed size, the oldest keyframe goes together with the frames that depend on it
+struct Rewind {
+    std::vector<uint8_t> ring = std::vector<uint8_t>(rewindCapacity);
+    std::deque<RewindEntry> entries;
+    size_t head = 0;
+    size_t used = 0;
+    uint64_t nextSequence = 0;
+
+    // the keyframe new frames are saved against, and the one frames were last loaded against
+    uint64_t keyframe = 0;
+    bool hasKeyframe = false;
+    std::array<uint8_t, 0x10000> keyframeMemory {};
+    uint64_t loadedKeyframe = 0;
+    bool hasLoadedKeyframe = false;
+    std::array<uint8_t, 0x10000> loadedMemory {};
+
+    std::vector<uint8_t> state;
+
+    // spent recording, for the overlay to set against the time spent running the frames
+    std::chrono::steady_clock::duration spent {};
+};
+
+// a keyframe starts tracking the machine's dirty pages, the frames after it compare only those with it
+void recordFrame (Rewind&, Machine&, const StateDevices&);
+
+// drops the newest frame and loads the one before it, false once there is none
+bool stepBack (Rewind&, Machine&, const StateDevices&);
+
+// frames held, at one per frame
+inline size_t rewindFrames (const Rewind& rewind) {
+    return rewind.entries.size();
+}
+
+
+
+#endif //REWIND_H
@@ -0,0 +1,138 @@
+#include <algorithm>
+
+#include "Machine.h"
+#include "Scheduler.h"
+
+
+void place (std::vector<Event*>& heap, size_t slot, Event* event) {
+    heap[slot] = event;
+    event->slot = slot;
+}
+
+void siftUp (std::vector<Event*>& heap, size_t slot) {
+    auto* event = heap[slot];
+
+    while (slot > 0) {
+        const auto parent = (slot - 1) / 2;
+
+        if (heap[parent]->cycle <= event->cycle) {
+            break;
+        }
+
+        place(heap, slot, heap[parent]);
+        slot = parent;
+    }
+
+    place(heap, slot, event);
+}
+
+void siftDown (std::vector<Event*>& heap, size_t slot) {
+    auto* event = heap[slot];
+
+    while (true) {
+        auto child = slot * 2 + 1;
+
+        if (child >= heap.size()) {
+            break;
+        }
+
+        if (child + 1 < heap.size() && heap[child + 1]->cycle < heap[child]->cycle) {
+            child++;
+        }
+
+        if (event->cycle <= heap[child]->cycle) {
+            break;
+        }
+
+        place(heap, slot, heap[child]);
+        slot = child;
+    }
+
+    place(heap, slot, event);
+}
+
+void schedule (Machine& machine, Event& event, uint64_t cycle) {
+    auto& scheduler = machine.scheduler;
+    auto& heap = scheduler.heap;
+
+    event.cycle = cycle;
+
+    if (event.slot == unscheduled) {
+        heap.push_back(&event);
+        siftUp(heap, heap.size() - 1);
+    } else {
+        siftUp(heap, event.slot);
+        siftDown(heap, event.slot);
+    }
+
+    scheduler.deadline = std::min(scheduler.deadline, cycle);
+}
+
+void cancel (Machine& machine, Event& event) {
+    auto& heap = machine.scheduler.heap;
+
+    if (event.slot == unscheduled) {
+        return;
+    }
+
+    const auto slot = event.slot;
+    auto* last = heap.back();
+    heap.pop_back();
+    event.slot = unscheduled;
+
+    if (last != &event) {
+        place(heap, slot, last);
+        siftUp(heap, slot);
+        siftDown(heap, last->slot);
+    }
+
+    // a deadline left behind by the event only makes the run loop look once too often
+}
+
+void assertIrq (Machine& machine, uint32_t line) {
+    machine.scheduler.irqLines |= line;
+    machine.scheduler.deadline = std::min(machine.scheduler.deadline, machine.cycles);
+}
+
+void releaseIrq (Machine& machine, uint32_t line) {
+    machine.scheduler.irqLines &= ~line;
+}
+
+void triggerNmi (Machine& machine) {
+    machine.scheduler.nmiPending = true;
+    machine.scheduler.deadline = std::min(machine.scheduler.deadline, machine.cycles);
+}
+
+void dispatchEvents (Machine& machine) {
+    auto& heap = machine.scheduler.heap;
+
+    while (!heap.empty() && heap.front()->cycle <= machine.cycles) {
+        auto& event = *heap.front();
+        cancel(machine, event);
+        event.handler(machine, event.device);
+    }
+}
+
+void updateDeadline (Machine& machine) {
+    auto& scheduler = machine.scheduler;
+
+    scheduler.deadline = scheduler.heap.empty() ? noDeadline : scheduler.heap.front()->cycle;
+
+    // a masked IRQ is looked at again after every instruction, until the cpu lets it in or the device lets go
+    if (scheduler.irqLines != 0 && (machine.cpu.p & FlagI) != 0) {
+        scheduler.deadline = std::min(scheduler.deadline, machine.cycles + 1);
+    }
+}
+
+void clearEvents (Machine& machine) {
+    auto& scheduler = machine.scheduler;
+
+    for (auto* event : scheduler.heap) {
+        event->slot = unscheduled;
+    }
+
+    scheduler.heap.clear();
+    scheduler.deadline = noDeadline;
+    scheduler.irqLines = 0;
+    scheduler.nmiPending = false;
+}
@@ -0,0 +1,55 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+struct Machine;
+
+typedef void (*EventHandler) (Machine&, void* device);
+
+constexpr size_t unscheduled = std::numeric_limits<size_t>::max();
+constexpr uint64_t noDeadline = std::numeric_limits<uint64_t>::max();
+
+// owned by its device, which has to outlive it being scheduled
+struct Event {
+    EventHandler handler = nullptr;
+    void* device = nullptr;
+
+    uint64_t cycle = 0;
+    size_t slot = unscheduled;
+};
+
+// pending device events in a min-heap on their absolute cycle, and the interrupt lines they drive
+struct Scheduler {
+    std::vector<Event*> heap;
+
+    // the run loops only compare the cycle count against this, everything else happens once it is reached
+    uint64_t deadline = noDeadline;
+
+    // level-triggered, one bit per device holding the line, NMI is an edge and is taken once
+    uint32_t irqLines = 0;
+    bool nmiPending = false;
+};
+
+// moves the event if it is already scheduled, a device may do so from its own handler
+void schedule (Machine&, Event&, uint64_t cycle);
+void cancel (Machine&, Event&);
+
+void assertIrq (Machine&, uint32_t line);
+void releaseIrq (Machine&, uint32_t line);
+void triggerNmi (Machine&);
+
+// runs the handler of every event that is due by the current cycle, earliest first
+void dispatchEvents (Machine&);
+
+// the next event's cycle, unless an interrupt is waiting to be taken sooner
+void updateDeadline (Machine&);
+
+// drops every event and releases every line
+void clearEvents (Machine&);
+
+
+
+#endif //SCHEDULER_H
@@ -0,0 +1,82 @@
+#include <algorithm>
+
+#include "Machine.h"
+#include "Timer.h"
+
+
+uint32_t cyclesPerPeriod (const Timer& timer) {
+    return timer.period == 0 ? 0x10000 : timer.period;
+}
+
+// the next period is counted from when this one was due, not from when the handler ran
+void expireTimer (Machine& machine, void* device) {
+    auto& timer = *static_cast<Timer*>(device);
+
+    timer.expired = true;
+
+    if (timer.control & TimerNmi) {
+        triggerNmi(machine);
+    } else {
+        assertIrq(machine, timerIrqLine);
+    }
+
+    if (timer.control & TimerRepeat) {
+        schedule(machine, timer.expiry, timer.expiry.cycle + cyclesPerPeriod(timer));
+    } else {
+        timer.control &= ~TimerEnable;
+    }
+}
+
+uint8_t readTimer (Machine& machine, void* device, uint16_t address) {
+    const auto& timer = *static_cast<const Timer*>(device);
+    const auto left = timer.expiry.slot == unscheduled ? 0 : std::min<uint64_t>(timer.expiry.cycle - machine.cycles, 0xffff);
+
+    switch (address & 0x07) {
+        case 0: return timer.period & 0xff;
+        case 1: return timer.period >> 8;
+        case 2: return timer.control;
+        case 3: return timer.expired ? 0x80 : 0x00;
+        case 4: return left & 0xff;
+        case 5: return left >> 8;
+        default: return 0x00;
+    }
+}
+
+void writeTimer (Machine& machine, void* device, uint16_t address, uint8_t value) {
+    auto& timer = *static_cast<Timer*>(device);
+
+    switch (address & 0x07) {
+        case 0:
+            timer.period = (timer.period & 0xff00) | value;
+            break;
+
+        case 1:
+            timer.period = (timer.period & 0x00ff) | (value << 8);
+            break;
+
+        case 2:
+            timer.control = value;
+
+            if (value & TimerEnable) {
+                schedule(machine, timer.expiry, machine.cycles + cyclesPerPeriod(timer));
+            } else {
+                cancel(machine, timer.expiry);
+            }
+            break;
+
+        case 3:
+            timer.expired = false;
+            releaseIrq(machine, timerIrqLine);
+            break;
+
+        default:
+            break;
+    }
+}
+
+bool attachTimer (Machine& machine, Timer& timer, uint8_t page) {
+    timer.expiry.handler = expireTimer;
+    timer.expiry.device = &timer;
+
+    return mapDevice(machine, page, page, { &timer, readTimer, writeTimer });
+}
@@ -0,0 +1,36 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <cstdint>
+
+#include "Scheduler.h"
+
+
+
+enum TimerControl : uint8_t {
+    TimerEnable = 0x01,
+    TimerRepeat = 0x02,
+    TimerNmi = 0x04,
+};
+
+// registers, mirrored across the page:
+// +0/+1 period in cycles, 0 meaning 65536, taken when the timer is started
+// +2 control, storing it with TimerEnable set starts a new period and without stops the timer
+// +3 bit 7 set once a period ran out, any store acknowledges it and releases the IRQ
+// +4/+5 cycles left in the current period, read only
+struct Timer {
+    Event expiry;
+    uint16_t period = 0;
+    uint8_t control = 0;
+    bool expired = false;
+};
+
+constexpr uint8_t timerPage = 0xFE;
+constexpr uint32_t timerIrqLine = 0x01;
+
+// false when the page is already taken, see mapDevice
+bool attachTimer (Machine&, Timer&, uint8_t page = timerPage);
+
+
+
+#endif //TIMER_H
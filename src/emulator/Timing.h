@@ -0,0 +1,88 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <algorithm>
+#include <cstdint>
+
+#include "Machine.h"
+
+
+
+// every instruction takes the cycles in its opcode table entry, nothing is tracked within it
+struct FastTiming {
+    static constexpr bool perCycle = false;
+
+    static uint8_t read (Machine& machine, uint16_t address) { return readByte(machine, address); }
+    // zero page and stack loads, those pages never hold a device
+    static uint8_t readRam (Machine& machine, uint16_t address) { return peekByte(machine, address); }
+    static void write (Machine& machine, uint16_t address, uint8_t value) { writeByte(machine, address, value); }
+
+    static void indexed (Machine&, uint16_t, uint16_t) {}
+    static void branched (Machine&, uint16_t, uint16_t) {}
+    static void idle (Machine&) {}
+    static void dummyRead (Machine&, uint16_t) {}
+    static void dummyWrite (Machine&, uint16_t, uint8_t) {}
+
+    static void finish (Machine& machine, uint8_t cycles) { machine.cycles += cycles; }
+};
+
+// every bus access takes a cycle of its own and is reported to the machine's bus listener,
+// indexed reads across a page and taken branches cost the extra cycles the NMOS part spends on them
+struct CycleTiming {
+    static constexpr bool perCycle = true;
+
+    static uint8_t read (Machine& machine, uint16_t address) {
+        const auto value = readByte(machine, address);
+        access(machine, address, value, false);
+        return value;
+    }
+
+    static void write (Machine& machine, uint16_t address, uint8_t value) {
+        writeByte(machine, address, value);
+        access(machine, address, value, true);
+    }
+
+    static uint8_t readRam (Machine& machine, uint16_t address) {
+        return read(machine, address);
+    }
+
+    // the carry into the high byte takes one more cycle
+    static void indexed (Machine& machine, uint16_t base, uint16_t address) {
+        machine.busCycle += (base ^ address) >> 8 != 0;
+    }
+
+    static void branched (Machine& machine, uint16_t from, uint16_t to) {
+        machine.busCycle += (from ^ to) >> 8 != 0 ? 2 : 1;
+    }
+
+    static void idle (Machine& machine) {
+        machine.busCycle++;
+    }
+
+    static void dummyRead (Machine& machine, uint16_t address) {
+        read(machine, address);
+    }
+
+    static void dummyWrite (Machine& machine, uint16_t address, uint8_t value) {
+        write(machine, address, value);
+    }
+
+    // internal cycles without a bus access of their own are counted at the end of the instruction
+    static void finish (Machine& machine, uint8_t cycles) {
+        machine.cycles += std::max<uint32_t>(machine.busCycle, cycles);
+        machine.busCycle = 0;
+    }
+
+    static void access (Machine& machine, uint16_t address, uint8_t value, bool write) {
+        if (machine.busListener != nullptr) {
+            machine.busListener(machine, { machine.cycles + machine.busCycle, address, value, write });
+        }
+
+        machine.busCycle++;
+        machine.bus.accesses++;
+    }
+};
+
+
+
+#endif //TIMING_H
@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "Trace.h"
+
+
+Trace::~Trace () {
+    closeTrace(*this);
+}
+
+bool openTrace (Trace& trace, const char* path, CpuVariant variant) {
+#ifndef _WIN32
+    closeTrace(trace);
+
+    trace.file = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    trace.failed = false;
+    trace.windowOffset = 0;
+    trace.records = 0;
+
+    if (trace.file < 0 || !nextTraceWindow(trace)) {
+        closeTrace(trace);
+        return false;
+    }
+
+    // the header takes the place of the first record
+    auto* header = trace.window;
+    memcpy(header, traceMagic, sizeof(traceMagic));
+    header[4] = traceVersion & 0xff;
+    header[5] = traceVersion >> 8;
+    header[6] = static_cast<uint8_t>(variant);
+    trace.next++;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool closeTrace (Trace& trace) {
+    const auto complete = !trace.failed;
+
+#ifndef _WIN32
+    if (trace.window != nullptr) {
+        munmap(trace.window, traceWindowSize);
+    }
+
+    if (trace.file >= 0) {
+        // the last window was only partly filled
+        if (ftruncate(trace.file, traceHeaderSize + trace.records * sizeof(TraceRecord)) != 0) {
+            trace.failed = true;
+        }
+
+        close(trace.file);
+    }
+#endif
+
+    trace.file = -1;
+    trace.window = nullptr;
+    trace.next = nullptr;
+    trace.end = nullptr;
+
+    return complete && !trace.failed;
+}
+
+// extends the file by a window and maps that, with the space allocated up front where the system can,
+// so that a full disk fails here rather than faulting on a store into the mapping
+bool nextTraceWindow (Trace& trace) {
+#ifndef _WIN32
+    if (trace.failed || trace.file < 0) {
+        return false;
+    }
+
+    if (trace.window != nullptr) {
+        munmap(trace.window, traceWindowSize);
+        trace.window = nullptr;
+        trace.windowOffset += traceWindowSize;
+    }
+
+    trace.next = nullptr;
+    trace.end = nullptr;
+
+#ifdef __linux__
+    const auto extended = posix_fallocate(trace.file, trace.windowOffset, traceWindowSize) == 0;
+#else
+    const auto extended = ftruncate(trace.file, trace.windowOffset + traceWindowSize) == 0;
+#endif
+
+    void* window = extended ? mmap(nullptr, traceWindowSize, PROT_READ | PROT_WRITE, MAP_SHARED, trace.file, trace.windowOffset) : MAP_FAILED;
+
+    if (window == MAP_FAILED) {
+        trace.failed = true;
+        return false;
+    }
+
+    trace.window = static_cast<uint8_t*>(window);
+    trace.next = reinterpret_cast<TraceRecord*>(trace.window);
+    trace.end = trace.next + traceWindowSize / sizeof(TraceRecord);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool openTraceReader (TraceReader& reader, const char* path) {
+    reader.file = std::ifstream { path, std::ios::binary };
+
+    uint8_t header[traceHeaderSize];
+
+    if (!reader.file.read(reinterpret_cast<char*>(header), sizeof(header))) {
+        return false;
+    }
+
+    const auto version = header[4] | (header[5] << 8);
+
+    if (memcmp(header, traceMagic, sizeof(traceMagic)) != 0 || version > traceVersion || header[6] > static_cast<uint8_t>(CpuVariant::Cmos)) {
+        return false;
+    }
+
+    reader.file.seekg(0, std::ios::end);
+    reader.variant = static_cast<CpuVariant>(header[6]);
+    reader.records = (static_cast<uint64_t>(reader.file.tellg()) - traceHeaderSize) / sizeof(TraceRecord);
+
+    return true;
+}
+
+size_t readTrace (TraceReader& reader, uint64_t first, TraceRecord* records, size_t count) {
+    if (first >= reader.records) {
+        return 0;
+    }
+
+    count = std::min<uint64_t>(count, reader.records - first);
+
+    reader.file.clear();
+    reader.file.seekg(traceHeaderSize + first * sizeof(TraceRecord));
+    reader.file.read(reinterpret_cast<char*>(records), count * sizeof(TraceRecord));
+
+    return reader.file.gcount() / sizeof(TraceRecord);
+}
+
+// a binary search reading one record per probe, a window into a trace of billions takes a few dozen reads
+uint64_t findTraceCycle (TraceReader& reader, uint64_t cycle) {
+    uint64_t low = 0;
+    uint64_t high = reader.records;
+
+    while (low < high) {
+        const auto middle = low + (high - low) / 2;
+        TraceRecord record;
+
+        if (readTrace(reader, middle, &record, 1) != 1 || traceCycle(record) >= cycle) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+
+    return low;
+}
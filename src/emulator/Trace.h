@@ -0,0 +1,97 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <fstream>
+
+#include "Machine.h"
+
+
+
+// one instruction as it was about to run, the cycle is 48 bits and wraps after almost nine years at 1 MHz
+struct TraceRecord {
+    uint32_t cycleLow;
+    uint16_t cycleHigh;
+    uint16_t pc;
+    uint8_t opcode;
+    uint8_t operandLow;
+    uint8_t operandHigh;
+    uint8_t a;
+    uint8_t x;
+    uint8_t y;
+    uint8_t p;
+    uint8_t sp;
+};
+
+static_assert(sizeof(TraceRecord) == 16);
+
+constexpr uint64_t traceCycle (const TraceRecord& record) {
+    return record.cycleLow | (static_cast<uint64_t>(record.cycleHigh) << 32);
+}
+
+// "HTRC", the little-endian version and the cpu variant, padded to the size of a record,
+// then records as they are laid out in memory up to the end of the file
+constexpr uint8_t traceMagic[4] { 'H', 'T', 'R', 'C' };
+constexpr uint16_t traceVersion = 1;
+constexpr size_t traceHeaderSize = sizeof(TraceRecord);
+
+// the file is mapped this much at a time
+constexpr size_t traceWindowSize = 64 << 20;
+
+// records go straight into a shared mapping of the file, the kernel writes them back when it likes
+// and nothing but the current window is ever held
+struct Trace {
+    Trace () = default;
+    Trace (const Trace&) = delete;
+    Trace& operator= (const Trace&) = delete;
+    ~Trace ();
+
+    int file = -1;
+    uint8_t* window = nullptr;
+    uint64_t windowOffset = 0;
+    TraceRecord* next = nullptr;
+    TraceRecord* end = nullptr;
+    uint64_t records = 0;
+
+    // the disk filled up or the mapping failed, what was recorded before stays readable
+    bool failed = false;
+};
+
+// false when the file cannot be created, an existing one is overwritten
+bool openTrace (Trace&, const char* path, CpuVariant);
+
+// cuts the file to the records written, false when any of them did not make it
+bool closeTrace (Trace&);
+
+[[gnu::cold]] bool nextTraceWindow (Trace&);
+
+inline void recordTrace (Trace& trace, const TraceRecord& record) {
+    if (trace.next == trace.end) [[unlikely]] {
+        if (!nextTraceWindow(trace)) {
+            return;
+        }
+    }
+
+    *trace.next++ = record;
+    trace.records++;
+}
+
+// reads a trace without mapping or loading all of it
+struct TraceReader {
+    std::ifstream file;
+    CpuVariant variant = CpuVariant::Nmos;
+    uint64_t records = 0;
+};
+
+// false when the file is missing, is no trace or is of a newer version
+bool openTraceReader (TraceReader&, const char* path);
+
+// up to count records from the index on, fewer at the end of the trace
+size_t readTrace (TraceReader&, uint64_t first, TraceRecord* records, size_t count);
+
+// the index of the first record at or after the cycle, records being in cycle order
+uint64_t findTraceCycle (TraceReader&, uint64_t cycle);
+
+
+
+#endif //TRACE_H
@@ -0,0 +1,483 @@
+#include <algorithm>
+#include <array>
+#include <utility>
+
+#include "assembler/opcodes.h"
+#include "jit/jit.h"
+
+#include "BlockCache.h"
+#include "cpu.h"
+#include "Debugger.h"
+#include "Heatmap.h"
+#include "instructions.h"
+#include "Profile.h"
+#include "Trace.h"
+
+
+typedef void (*Handler) (Machine&);
+
+// forced inline, the threaded interpreter only pays off with a copy of the handler in each of its slots
+template <uint8_t Opcode, typename Variant, typename Flags, typename Timing>
+[[gnu::always_inline]] inline void handle (Machine& machine) {
+    constexpr auto info = Variant::infos[Opcode];
+
+    auto& pc = machine.cpu.pc;
+    uint16_t operand = 0;
+
+    if constexpr (operandSize(info.mode) == 1) {
+        operand = Timing::read(machine, pc);
+    } else if constexpr (operandSize(info.mode) == 2) {
+        operand = readPointer<Timing>(machine, pc, pc + 1);
+    }
+
+    pc += operandSize(info.mode);
+
+    executeOpcode<Opcode, Variant, Flags, Timing>(machine, operand);
+    Timing::finish(machine, info.cycles);
+}
+
+// one handler per opcode byte, instantiated from the variant's opcode infos at compile time
+template <typename Variant, typename Flags, typename Timing>
+constexpr auto handlers = [] <size_t ...Opcodes> (std::index_sequence<Opcodes...>) {
+    return std::array<Handler, 256> { &handle<Opcodes, Variant, Flags, Timing>... };
+}(std::make_index_sequence<256> {});
+
+// P holds every flag outside of these calls, lazy sources are only live while the core runs
+template <typename Variant, typename Timing, typename Body>
+void withFlags (Machine& machine, Body body) {
+    if (!usesLazyFlags(machine)) {
+        body(Variant {}, EagerFlags {}, Timing {});
+        return;
+    }
+
+    LazyFlags::enter(machine.cpu);
+    body(Variant {}, LazyFlags {}, Timing {});
+    LazyFlags::leave(machine.cpu);
+}
+
+template <typename Variant, typename Body>
+void withTiming (Machine& machine, Body body) {
+    if (machine.accuracy == Accuracy::Cycle) {
+        withFlags<Variant, CycleTiming>(machine, body);
+    } else {
+        withFlags<Variant, FastTiming>(machine, body);
+    }
+}
+
+// picks the instantiation once per call, nothing inside the run checks the policies again
+template <typename Body>
+void withPolicies (Machine& machine, Body body) {
+    switch (machine.variant) {
+        case CpuVariant::Nmos: withTiming<Nmos6502>(machine, body); break;
+        case CpuVariant::NmosUndocumented: withTiming<Nmos6502Undocumented>(machine, body); break;
+        case CpuVariant::Cmos: withTiming<Cmos65C02>(machine, body); break;
+    }
+}
+
+template <typename Variant, typename Flags, typename Timing>
+void step (Machine& machine) {
+    const auto opcode = Timing::read(machine, machine.cpu.pc);
+    machine.cpu.pc++;
+
+    handlers<Variant, Flags, Timing>[opcode](machine);
+    machine.instructions++;
+}
+
+// operands are peeked, a trace does not touch the bus
+template <typename Flags>
+[[gnu::always_inline]] inline void traceInstruction (Machine& machine) {
+    const auto& cpu = machine.cpu;
+
+    recordTrace(*machine.trace, {
+        static_cast<uint32_t>(machine.cycles), static_cast<uint16_t>(machine.cycles >> 32), cpu.pc,
+        peekByte(machine, cpu.pc), peekByte(machine, cpu.pc + 1), peekByte(machine, cpu.pc + 2),
+        cpu.a, cpu.x, cpu.y, Flags::status(cpu), cpu.sp
+    });
+}
+
+// the budget has not run out and no event or interrupt is due yet,
+// run has folded a cycle budget into the deadline and halting clears it
+template <uint64_t Machine::* Counter>
+bool running (const Machine& machine, uint64_t end) {
+    if constexpr (Counter == &Machine::cycles) {
+        return machine.cycles < machine.scheduler.deadline;
+    } else {
+        return machine.instructions < end && machine.cycles < machine.scheduler.deadline;
+    }
+}
+
+// due events first, they may raise the lines that are looked at next
+template <typename Variant, typename Flags, typename Timing>
+void service (Machine& machine) {
+    auto& scheduler = machine.scheduler;
+
+    dispatchEvents(machine);
+
+    if (scheduler.nmiPending) {
+        scheduler.nmiPending = false;
+        interrupt<Variant, Flags, Timing>(machine, nmiVector);
+    } else if (scheduler.irqLines != 0 && (machine.cpu.p & FlagI) == 0) {
+        interrupt<Variant, Flags, Timing>(machine, irqVector);
+    }
+
+    updateDeadline(machine);
+}
+
+void step (Machine& machine) {
+    withPolicies(machine, [&machine] <typename Variant, typename Flags, typename Timing> (Variant, Flags, Timing) {
+        step<Variant, Flags, Timing>(machine);
+    });
+}
+
+#if HAUSTIER_THREADED
+#define THREADED_ROW(row, OPCODE) \
+    OPCODE(row##0) OPCODE(row##1) OPCODE(row##2) OPCODE(row##3) OPCODE(row##4) OPCODE(row##5) OPCODE(row##6) OPCODE(row##7) \
+    OPCODE(row##8) OPCODE(row##9) OPCODE(row##A) OPCODE(row##B) OPCODE(row##C) OPCODE(row##D) OPCODE(row##E) OPCODE(row##F)
+
+#define THREADED_OPCODES(OPCODE) \
+    THREADED_ROW(0, OPCODE) THREADED_ROW(1, OPCODE) THREADED_ROW(2, OPCODE) THREADED_ROW(3, OPCODE) \
+    THREADED_ROW(4, OPCODE) THREADED_ROW(5, OPCODE) THREADED_ROW(6, OPCODE) THREADED_ROW(7, OPCODE) \
+    THREADED_ROW(8, OPCODE) THREADED_ROW(9, OPCODE) THREADED_ROW(A, OPCODE) THREADED_ROW(B, OPCODE) \
+    THREADED_ROW(C, OPCODE) THREADED_ROW(D, OPCODE) THREADED_ROW(E, OPCODE) THREADED_ROW(F, OPCODE)
+
+#define THREADED_LABEL(opcode) &&opcode_##opcode,
+
+#define THREADED_DISPATCH() \
+    if (!running<Counter>(machine, end)) { \
+        return; \
+    } \
+    goto *labels[Timing::read(machine, machine.cpu.pc++)];
+
+#define THREADED_HANDLER(opcode) \
+    opcode_##opcode: \
+        handle<0x##opcode, Variant, Flags, Timing>(machine); \
+        machine.instructions++; \
+        THREADED_DISPATCH()
+
+// every handler ends in its own indirect jump to the next one, instead of all of them sharing the loop's
+template <uint64_t Machine::* Counter, typename Variant, typename Flags, typename Timing>
+void runThreaded (Machine& machine, uint64_t end) {
+    static const void* const labels[256] { THREADED_OPCODES(THREADED_LABEL) };
+
+    THREADED_DISPATCH()
+    THREADED_OPCODES(THREADED_HANDLER)
+}
+
+#undef THREADED_HANDLER
+#undef THREADED_DISPATCH
+#undef THREADED_LABEL
+#undef THREADED_OPCODES
+#undef THREADED_ROW
+#endif
+
+// with a device on the bus the counters move along with every instruction, so that it sees the same time as under the interpreter
+template <bool CountEach>
+void executeBlock (Machine& machine, const Block& block) {
+    const auto* instruction = block.instructions.data();
+    const auto* last = instruction + block.instructions.size() - 1;
+
+    // only the final control transfer reads pc, everything before it runs without touching it
+    for (; instruction != last; instruction++) {
+        instruction->executor(machine, instruction->operand);
+
+        if constexpr (CountEach) {
+            machine.cycles += instruction->cycles;
+            machine.instructions++;
+        }
+
+        // the instruction wrote over cached code, possibly over this very block, or reached a device
+        if (machine.blockCache.leave) [[unlikely]] {
+            machine.blockCache.leave = false;
+            machine.cpu.pc = instruction->nextPc;
+
+            for (const auto* done = block.instructions.data(); !CountEach && done <= instruction; done++) {
+                machine.cycles += done->cycles;
+                machine.instructions++;
+            }
+
+            return;
+        }
+    }
+
+    machine.cpu.pc = last->nextPc;
+    last->executor(machine, last->operand);
+    machine.blockCache.leave = false;
+
+    if constexpr (CountEach) {
+        machine.cycles += last->cycles;
+        machine.instructions++;
+    } else {
+        machine.cycles += block.cycles;
+        machine.instructions += block.instructions.size();
+    }
+}
+
+void dispatchBlock (Machine& machine, Block& block) {
+#if HAUSTIER_JIT
+    if (machine.engine == Engine::Jit) {
+        if (block.native != nullptr) {
+            block.native(&machine);
+            return;
+        }
+
+        if (++block.executions == jitThreshold) {
+            compileBlock(machine, block);
+        }
+    }
+#endif
+
+    if (machine.bus.hasDevices) {
+        executeBlock<true>(machine, block);
+    } else {
+        executeBlock<false>(machine, block);
+    }
+}
+
+void runBlock (Machine& machine) {
+    withPolicies(machine, [&machine] <typename Variant, typename Flags, typename Timing> (Variant, Flags, Timing) {
+        auto* block = Timing::perCycle ? nullptr : findBlock(machine, machine.cpu.pc);
+
+        if (block == nullptr) {
+            step<Variant, Flags, Timing>(machine);
+            return;
+        }
+
+        dispatchBlock(machine, *block);
+    });
+}
+
+// the debug loop looks for a breakpoint before each instruction and for a watched access after it,
+// with its own instantiation of the handlers, the release loop does neither
+template <bool Debug, uint64_t Machine::* Counter, typename Variant, typename Flags, typename Timing>
+void interpret (Machine& machine, uint64_t end) {
+    if constexpr (Debug) {
+        auto& debugger = *machine.debugger;
+
+        while (running<Counter>(machine, end)) {
+            const auto pc = machine.cpu.pc;
+
+            if (debugger.breakpoints.test(pc) && pc != debugger.skipBreakpoint) {
+                debugger.stopped = true;
+                debugger.stop = { StopReason::Breakpoint, pc };
+                return;
+            }
+
+            debugger.skipBreakpoint = noBreakpoint;
+            step<Variant, Flags, WatchedTiming<Timing>>(machine);
+
+            if (debugger.stopped) {
+                debugger.stop.pc = pc;
+                return;
+            }
+        }
+    } else {
+        while (running<Counter>(machine, end)) {
+            step<Variant, Flags, Timing>(machine);
+        }
+    }
+}
+
+// a run stopped by the debugger goes on from the same instruction, past the breakpoint it stopped at
+void resumeDebugger (Machine& machine) {
+    auto& debugger = *machine.debugger;
+
+    if (debugger.stopped) {
+        debugger.stopped = false;
+        debugger.skipBreakpoint = debugger.stop.reason == StopReason::Breakpoint ? debugger.stop.pc : noBreakpoint;
+    }
+}
+
+bool stoppedByDebugger (const Machine& machine) {
+    return machine.debugging && machine.debugger->stopped;
+}
+
+bool observed (const Machine& machine) {
+#if HAUSTIER_PROFILER
+    return machine.trace != nullptr || machine.heatmap != nullptr || machine.profile != nullptr;
+#else
+    return machine.trace != nullptr || machine.heatmap != nullptr;
+#endif
+}
+
+// a trace, a heatmap or a profile sees each instruction on its own, at the cost of an untaken branch per instruction for the others,
+// the heatmap's accesses are counted by the timing it is run with
+template <uint64_t Machine::* Counter, typename Variant, typename Flags, typename Timing>
+void runObserved (Machine& machine, uint64_t end) {
+    auto* trace = machine.trace;
+    auto* heatmap = machine.heatmap;
+#if HAUSTIER_PROFILER
+    auto* profile = machine.profile;
+#endif
+
+    while (running<Counter>(machine, end)) {
+        [[maybe_unused]] const auto pc = machine.cpu.pc;
+        [[maybe_unused]] const auto cycles = machine.cycles;
+
+        if (trace != nullptr) {
+            traceInstruction<Flags>(machine);
+        }
+
+        if (heatmap != nullptr) {
+            heatmap->executions[pc]++;
+        }
+
+        step<Variant, Flags, Timing>(machine);
+
+#if HAUSTIER_PROFILER
+        if (profile != nullptr) {
+            profile->instructions[pc]++;
+            profile->cycles[pc] += machine.cycles - cycles;
+        }
+#endif
+    }
+}
+
+// Counter is either the cycle or the instruction count, whichever the budget is in
+template <uint64_t Machine::* Counter, typename Variant, typename Flags, typename Timing>
+void runUntilDeadline (Machine& machine, uint64_t end) {
+    auto& counter = machine.*Counter;
+
+    if (machine.debugging) [[unlikely]] {
+        interpret<true, Counter, Variant, Flags, Timing>(machine, end);
+        return;
+    }
+
+    if (observed(machine)) [[unlikely]] {
+        if (machine.heatmap != nullptr) {
+            runObserved<Counter, Variant, Flags, HeatTiming<Timing>>(machine, end);
+        } else {
+            runObserved<Counter, Variant, Flags, Timing>(machine, end);
+        }
+
+        return;
+    }
+
+#if HAUSTIER_THREADED
+    if (machine.engine == Engine::Threaded) {
+        runThreaded<Counter, Variant, Flags, Timing>(machine, end);
+        return;
+    }
+#endif
+
+    // blocks add up their cycles ahead of time, so cycle-accurate runs interpret one instruction at a time
+    if (Timing::perCycle || machine.engine == Engine::Interpreter || machine.engine == Engine::Threaded) {
+        interpret<false, Counter, Variant, Flags, Timing>(machine, end);
+        return;
+    }
+
+    while (running<Counter>(machine, end)) {
+        auto* block = findBlock(machine, machine.cpu.pc);
+
+        // single-step the tail so that the budget and the deadline end on the same instruction as in the interpreter
+        if (
+            block == nullptr || counter + (Counter == &Machine::cycles ? block->cycles : block->instructions.size()) > end ||
+            machine.cycles + block->cycles > machine.scheduler.deadline
+        ) {
+            step<Variant, Flags, Timing>(machine);
+            continue;
+        }
+
+        dispatchBlock(machine, *block);
+    }
+}
+
+// steps once round the loop at pc, when that comes back to the very same state without a store or a device access
+// every further trip would too, so the trips that fit before the deadline are counted instead of run
+template <uint64_t Machine::* Counter, typename Variant, typename Flags, typename Timing>
+bool skipIdleLoop (Machine& machine, uint64_t end) {
+    const auto& cpu = machine.cpu;
+    const auto& bus = machine.bus;
+
+    const auto before = cpu;
+    const auto status = Flags::status(cpu);
+    const auto cycles = machine.cycles;
+    const auto instructions = machine.instructions;
+    const auto accesses = bus.accesses;
+    const auto slowAccesses = bus.slowReads + bus.slowWrites;
+
+    for (size_t count = 0; count < maxIdleLoopInstructions; count++) {
+        const auto& info = Variant::infos[peekByte(machine, cpu.pc)];
+
+        if (!running<Counter>(machine, end) || !info.valid || storesToMemory(info.instruction, info.mode)) {
+            return false;
+        }
+
+        step<Variant, Flags, Timing>(machine);
+
+        if (cpu.pc == before.pc) {
+            break;
+        }
+    }
+
+    const auto unchanged = cpu.pc == before.pc && cpu.a == before.a && cpu.x == before.x && cpu.y == before.y &&
+        cpu.sp == before.sp && Flags::status(cpu) == status && bus.slowReads + bus.slowWrites == slowAccesses;
+
+    if (!unchanged || !running<Counter>(machine, end)) {
+        return false;
+    }
+
+    // every trip starts before the deadline, as it would have when run
+    const auto tripCycles = machine.cycles - cycles;
+    const auto tripInstructions = machine.instructions - instructions;
+    auto trips = (machine.scheduler.deadline - 1 - machine.cycles) / tripCycles;
+
+    if constexpr (Counter == &Machine::instructions) {
+        trips = std::min(trips, (end - machine.instructions) / tripInstructions);
+    }
+
+    machine.cycles += trips * tripCycles;
+    machine.instructions += trips * tripInstructions;
+    machine.bus.accesses += trips * (bus.accesses - accesses);
+    machine.idle.skippedCycles += trips * tripCycles;
+
+    return true;
+}
+
+// the engines run undisturbed from one deadline to the next, with no per-device checks in between
+template <uint64_t Machine::* Counter, typename Variant, typename Flags, typename Timing>
+void run (Machine& machine, uint64_t end) {
+    auto& scheduler = machine.scheduler;
+    auto& idle = machine.idle;
+
+    if (machine.debugging) {
+        resumeDebugger(machine);
+    }
+
+    while (machine.*Counter < end && !machine.halted && !stoppedByDebugger(machine)) {
+        if (machine.cycles >= scheduler.deadline) {
+            service<Variant, Flags, Timing>(machine);
+            continue;
+        }
+
+        // the end of the budget and the next look for an idle loop only make the run loop service nothing now and then
+        if constexpr (Counter == &Machine::cycles) {
+            scheduler.deadline = std::min(scheduler.deadline, end);
+        }
+
+        // bus and instruction traces, heatmaps, profiles and breakpoints want to see every access and instruction of every trip
+        if (idle.skip && machine.busListener == nullptr && !observed(machine) && !machine.debugging) {
+            if (machine.cycles >= idle.nextProbe) {
+                const auto found = skipIdleLoop<Counter, Variant, Flags, Timing>(machine, end);
+                idle.interval = found ? minIdleProbeInterval : std::min(idle.interval * 2, maxIdleProbeInterval);
+                idle.nextProbe = machine.cycles + idle.interval;
+                continue;
+            }
+
+            scheduler.deadline = std::min(scheduler.deadline, idle.nextProbe);
+        }
+
+        runUntilDeadline<Counter, Variant, Flags, Timing>(machine, end);
+    }
+}
+
+void runCycles (Machine& machine, uint64_t cycleBudget) {
+    withPolicies(machine, [&machine, cycleBudget] <typename Variant, typename Flags, typename Timing> (Variant, Flags, Timing) {
+        run<&Machine::cycles, Variant, Flags, Timing>(machine, machine.cycles + cycleBudget);
+    });
+}
+
+void runInstructions (Machine& machine, uint64_t instructionBudget) {
+    withPolicies(machine, [&machine, instructionBudget] <typename Variant, typename Flags, typename Timing> (Variant, Flags, Timing) {
+        run<&Machine::instructions, Variant, Flags, Timing>(machine, machine.instructions + instructionBudget);
+    });
+}
@@ -0,0 +1,21 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <cstdint>
+
+#include "Machine.h"
+
+
+
+void step (Machine&);
+
+// one cached block, or a single instruction where no block can be decoded
+void runBlock (Machine&);
+
+// both stop early when the cpu halts on an opcode that is not in the table
+void runCycles (Machine&, uint64_t cycleBudget);
+void runInstructions (Machine&, uint64_t instructionBudget);
+
+
+
+#endif //CPU_H
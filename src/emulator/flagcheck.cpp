@@ -0,0 +1,98 @@
+#include <cstdio>
+#include <memory>
+
+#include "assembler/opcodes.h"
+
+#include "flagcheck.h"
+#include "Flags.h"
+#include "instructions.h"
+#include "Machine.h"
+
+
+// the interpreter's step, minus the enter and leave around it
+template <typename Variant, typename Flags>
+void stepWith (Machine& machine) {
+    auto& pc = machine.cpu.pc;
+    const auto opcode = readByte(machine, pc);
+    const auto& info = Variant::infos[opcode];
+    uint16_t operand = 0;
+
+    if (operandSize(info.mode) == 1) {
+        operand = readByte(machine, pc + 1);
+    } else if (operandSize(info.mode) == 2) {
+        operand = readWord(machine, pc + 1);
+    }
+
+    pc += 1 + operandSize(info.mode);
+
+    executors<Variant, Flags, FastTiming>[opcode](machine, operand);
+    machine.cycles += info.cycles;
+    machine.instructions++;
+}
+
+std::string describeState (const char* name, const Cpu& cpu, uint8_t p) {
+    char line[80];
+    snprintf(line, sizeof(line), " %-5s pc=%04x a=%02x x=%02x y=%02x sp=%02x p=%02x\n", name, cpu.pc, cpu.a, cpu.x, cpu.y, cpu.sp, p);
+
+    return line;
+}
+
+template <typename Variant>
+std::string checkFlags (const std::vector<uint8_t>& program, uint64_t instructionBudget, CpuVariant variant) {
+    const auto eager = std::make_unique<Machine>();
+    const auto lazy = std::make_unique<Machine>();
+
+    for (auto* machine : { eager.get(), lazy.get() }) {
+        if (!load(*machine, program)) {
+            return "program does not fit in memory\n";
+        }
+
+        reset(*machine);
+        machine->engine = Engine::Interpreter;
+        machine->variant = variant;
+    }
+
+    eager->flags = FlagEvaluation::Eager;
+    lazy->flags = FlagEvaluation::Lazy;
+    LazyFlags::enter(lazy->cpu);
+
+    while (eager->instructions < instructionBudget && !eager->halted) {
+        const auto pc = eager->cpu.pc;
+
+        stepWith<Variant, EagerFlags>(*eager);
+        stepWith<Variant, LazyFlags>(*lazy);
+
+        const auto& a = eager->cpu;
+        const auto& b = lazy->cpu;
+        const auto status = LazyFlags::status(b);
+
+        if (a.p != status || a.a != b.a || a.x != b.x || a.y != b.y || a.sp != b.sp || a.pc != b.pc || eager->halted != lazy->halted) {
+            char line[80];
+            snprintf(
+                line, sizeof(line), "diverged after instruction %llu at $%04x\n",
+                static_cast<unsigned long long>(eager->instructions), pc
+            );
+
+            return line + describeState("eager", a, a.p) + describeState("lazy", b, status);
+        }
+    }
+
+    if (eager->memory != lazy->memory) {
+        return "memory differs, registers and flags matched throughout\n";
+    }
+
+    char line[80];
+    snprintf(line, sizeof(line), "flags match in %llu instructions\n", static_cast<unsigned long long>(eager->instructions));
+
+    return line;
+}
+
+std::string checkFlags (const std::vector<uint8_t>& program, uint64_t instructionBudget, CpuVariant variant) {
+    switch (variant) {
+        case CpuVariant::Nmos: return checkFlags<Nmos6502>(program, instructionBudget, variant);
+        case CpuVariant::NmosUndocumented: return checkFlags<Nmos6502Undocumented>(program, instructionBudget, variant);
+        case CpuVariant::Cmos: return checkFlags<Cmos65C02>(program, instructionBudget, variant);
+    }
+
+    return "unknown cpu variant\n";
+}
@@ -0,0 +1,18 @@
+#ifndef FLAGCHECK_H
+#define FLAGCHECK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Machine.h"
+
+
+
+// steps the program with eager and lazy flags side by side, never folding the lazy sources back into P,
+// and reports the first instruction after which P, a register or memory differs
+std::string checkFlags (const std::vector<uint8_t>& program, uint64_t instructionBudget, CpuVariant);
+
+
+
+#endif //FLAGCHECK_H
@@ -0,0 +1,647 @@
+#ifndef INSTRUCTIONS_H
+#define INSTRUCTIONS_H
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#include "assembler/opcodes.h"
+
+#include "Flags.h"
+#include "Machine.h"
+#include "Timing.h"
+
+
+template <auto>
+constexpr bool dependentFalse = false;
+
+template <typename Timing>
+void push (Machine& machine, uint8_t value) {
+    Timing::write(machine, 0x0100 | machine.cpu.sp, value);
+    machine.cpu.sp--;
+}
+
+template <typename Timing>
+uint8_t pull (Machine& machine) {
+    machine.cpu.sp++;
+    return Timing::readRam(machine, 0x0100 | machine.cpu.sp);
+}
+
+// pointers are read low byte first
+template <typename Timing>
+uint16_t readPointer (Machine& machine, uint16_t low, uint16_t high) {
+    const uint8_t value = Timing::read(machine, low);
+    return value | (Timing::read(machine, high) << 8);
+}
+
+// wraps around within the zero page
+template <typename Timing>
+uint16_t readZeroPagePointer (Machine& machine, uint8_t low) {
+    const uint8_t value = Timing::readRam(machine, low);
+    return value | (Timing::readRam(machine, static_cast<uint8_t>(low + 1)) << 8);
+}
+
+// pushes the return address and status, then jumps through the vector with further IRQs masked
+template <typename Variant, typename Timing>
+void enterInterrupt (Machine& machine, uint16_t returnAddress, uint8_t status, uint16_t vector) {
+    auto& cpu = machine.cpu;
+
+    push<Timing>(machine, returnAddress >> 8);
+    push<Timing>(machine, returnAddress & 0xff);
+    push<Timing>(machine, status);
+    cpu.p |= FlagI;
+
+    if constexpr (Variant::cmos) {
+        cpu.p &= ~FlagD;
+    }
+
+    cpu.pc = readPointer<Timing>(machine, vector, vector + 1);
+}
+
+// IRQ and NMI between two instructions, the pc is read twice without being advanced and B is pushed clear
+template <typename Variant, typename Flags, typename Timing>
+void interrupt (Machine& machine, uint16_t vector) {
+    Timing::dummyRead(machine, machine.cpu.pc);
+    Timing::dummyRead(machine, machine.cpu.pc);
+    enterInterrupt<Variant, Timing>(machine, machine.cpu.pc, (Flags::status(machine.cpu) & ~FlagB) | FlagU, vector);
+    Timing::finish(machine, 7);
+}
+
+// stores, read-modify-writes and pushes, anything after which memory may have changed
+constexpr bool storesToMemory (Instruction instruction, AddressingMode mode) {
+    switch (instruction) {
+        case Instruction::ASL: [[fallthrough]];
+        case Instruction::DEC: [[fallthrough]];
+        case Instruction::INC: [[fallthrough]];
+        case Instruction::LSR: [[fallthrough]];
+        case Instruction::ROL: [[fallthrough]];
+        case Instruction::ROR: return mode != AddressingMode::Accumulator;
+        case Instruction::BRK: [[fallthrough]];
+        case Instruction::DCP: [[fallthrough]];
+        case Instruction::ISC: [[fallthrough]];
+        case Instruction::JSR: [[fallthrough]];
+        case Instruction::PHA: [[fallthrough]];
+        case Instruction::PHP: [[fallthrough]];
+        case Instruction::PHX: [[fallthrough]];
+        case Instruction::PHY: [[fallthrough]];
+        case Instruction::RLA: [[fallthrough]];
+        case Instruction::RRA: [[fallthrough]];
+        case Instruction::SAX: [[fallthrough]];
+        case Instruction::SLO: [[fallthrough]];
+        case Instruction::SRE: [[fallthrough]];
+        case Instruction::STA: [[fallthrough]];
+        case Instruction::STX: [[fallthrough]];
+        case Instruction::STY: [[fallthrough]];
+        case Instruction::STZ: [[fallthrough]];
+        case Instruction::TRB: [[fallthrough]];
+        case Instruction::TSB: return true;
+        default: return false;
+    }
+}
+
+constexpr bool onZeroPage (AddressingMode mode) {
+    return mode == AddressingMode::ZeroPage || mode == AddressingMode::ZeroPageX || mode == AddressingMode::ZeroPageY;
+}
+
+// the operand is the raw 1 or 2 bytes following the opcode, pc already points past them
+template <AddressingMode Mode, typename Timing>
+uint16_t resolve (Machine& machine, uint16_t operand) {
+    const auto& cpu = machine.cpu;
+
+    if constexpr (Mode == AddressingMode::Absolute || Mode == AddressingMode::ZeroPage) {
+        return operand;
+    } else if constexpr (Mode == AddressingMode::AbsoluteX) {
+        return operand + cpu.x;
+    } else if constexpr (Mode == AddressingMode::AbsoluteY) {
+        return operand + cpu.y;
+    } else if constexpr (Mode == AddressingMode::ZeroPageX) {
+        return (operand + cpu.x) & 0xff;
+    } else if constexpr (Mode == AddressingMode::ZeroPageY) {
+        return (operand + cpu.y) & 0xff;
+    } else if constexpr (Mode == AddressingMode::Indirect) {
+        // the pointer's high byte does not carry into the next page
+        const uint16_t high = (operand & 0xff00) | ((operand + 1) & 0x00ff);
+        return readPointer<Timing>(machine, operand, high);
+    } else if constexpr (Mode == AddressingMode::IndirectX) {
+        return readZeroPagePointer<Timing>(machine, operand + cpu.x);
+    } else if constexpr (Mode == AddressingMode::ZeroPageIndirect) {
+        return readZeroPagePointer<Timing>(machine, operand);
+    } else if constexpr (Mode == AddressingMode::AbsoluteIndirectX) {
+        const uint16_t pointer = operand + cpu.x;
+        return readPointer<Timing>(machine, pointer, pointer + 1);
+    } else if constexpr (Mode == AddressingMode::IndirectY) {
+        return readZeroPagePointer<Timing>(machine, operand) + cpu.y;
+    } else if constexpr (Mode == AddressingMode::Relative) {
+        return cpu.pc + static_cast<int8_t>(operand);
+    } else {
+        static_assert(dependentFalse<Mode>, "addressing mode has no effective address");
+    }
+}
+
+template <AddressingMode Mode, typename Timing>
+uint8_t fetch (Machine& machine, uint16_t operand) {
+    if constexpr (Mode == AddressingMode::Immediate) {
+        return operand;
+    } else if constexpr (Mode == AddressingMode::Accumulator) {
+        return machine.cpu.a;
+    } else if constexpr (Mode == AddressingMode::AbsoluteX || Mode == AddressingMode::AbsoluteY || Mode == AddressingMode::IndirectY) {
+        // only reads pay for crossing a page, stores and read-modify-write always take the long way
+        const auto address = resolve<Mode, Timing>(machine, operand);
+        const auto index = Mode == AddressingMode::AbsoluteX ? machine.cpu.x : machine.cpu.y;
+
+        Timing::indexed(machine, address - index, address);
+        return Timing::read(machine, address);
+    } else if constexpr (onZeroPage(Mode)) {
+        return Timing::readRam(machine, resolve<Mode, Timing>(machine, operand));
+    } else {
+        return Timing::read(machine, resolve<Mode, Timing>(machine, operand));
+    }
+}
+
+// read-modify-write instructions operate either on A or on memory
+template <AddressingMode Mode, typename Variant, typename Timing, typename Op>
+void modify (Machine& machine, uint16_t operand, Op op) {
+    if constexpr (Mode == AddressingMode::Accumulator) {
+        machine.cpu.a = op(machine.cpu.a);
+    } else {
+        const auto address = resolve<Mode, Timing>(machine, operand);
+        const auto value = onZeroPage(Mode) ? Timing::readRam(machine, address) : Timing::read(machine, address);
+
+        // while it works on the value the NMOS part writes it back unchanged, the 65C02 reads it again
+        if constexpr (Variant::cmos) {
+            Timing::dummyRead(machine, address);
+        } else {
+            Timing::dummyWrite(machine, address, value);
+        }
+
+        Timing::write(machine, address, op(value));
+    }
+}
+
+template <typename Flags, typename Variant = Nmos6502>
+void adc (Cpu& cpu, uint8_t value) {
+    const unsigned carry = Flags::carry(cpu);
+
+    if (cpu.p & FlagD) {
+        // NMOS decimal mode: Z comes from the binary sum, N and V from the intermediate result
+        unsigned low = (cpu.a & 0x0f) + (value & 0x0f) + carry;
+        unsigned high = (cpu.a & 0xf0) + (value & 0xf0);
+
+        Flags::setZ(cpu, cpu.a + value + carry);
+
+        if (low > 0x09) {
+            low += 0x06;
+        }
+        if (low > 0x0f) {
+            high += 0x10;
+        }
+
+        Flags::setN(cpu, high);
+        Flags::setOverflow(cpu, ~(cpu.a ^ value) & (cpu.a ^ high));
+
+        if (high > 0x90) {
+            high += 0x60;
+        }
+
+        Flags::setCarry(cpu, high > 0xff);
+        cpu.a = (high & 0xf0) | (low & 0x0f);
+
+        // the 65C02 spends a cycle on getting N and Z right
+        if constexpr (Variant::cmos) {
+            Flags::setNZ(cpu, cpu.a);
+        }
+
+        return;
+    }
+
+    const unsigned sum = cpu.a + value + carry;
+
+    Flags::setCarry(cpu, sum > 0xff);
+    Flags::setOverflow(cpu, ~(cpu.a ^ value) & (cpu.a ^ sum));
+    cpu.a = sum;
+    Flags::setNZ(cpu, cpu.a);
+}
+
+template <typename Flags, typename Variant = Nmos6502>
+void sbc (Cpu& cpu, uint8_t value) {
+    const unsigned borrow = Flags::carry(cpu) ^ 1;
+    const unsigned difference = cpu.a - value - borrow;
+
+    // NMOS decimal mode sets every flag from the binary difference
+    Flags::setCarry(cpu, difference < 0x100);
+    Flags::setOverflow(cpu, (cpu.a ^ value) & (cpu.a ^ difference));
+    Flags::setNZ(cpu, difference);
+
+    if (cpu.p & FlagD && Variant::cmos) {
+        const int low = (cpu.a & 0x0f) - (value & 0x0f) - static_cast<int>(borrow);
+        int result = static_cast<int>(cpu.a) - value - static_cast<int>(borrow);
+
+        if (result < 0) {
+            result -= 0x60;
+        }
+        if (low < 0) {
+            result -= 0x06;
+        }
+
+        cpu.a = result;
+        Flags::setNZ(cpu, cpu.a);
+        return;
+    }
+
+    if (cpu.p & FlagD) {
+        int low = (cpu.a & 0x0f) - (value & 0x0f) - static_cast<int>(borrow);
+        int high = (cpu.a >> 4) - (value >> 4);
+
+        if (low < 0) {
+            low -= 0x06;
+            high--;
+        }
+        if (high < 0) {
+            high -= 0x06;
+        }
+
+        cpu.a = (high << 4) | (low & 0x0f);
+        return;
+    }
+
+    cpu.a = difference;
+}
+
+// these flag formulas also step the lockstep lanes, where Byte is a vector of bytes and State a group of lanes
+template <typename Flags, typename State, typename Byte>
+void compare (State& cpu, Byte reg, Byte value) {
+    Flags::setCarry(cpu, reg >= value);
+    Flags::setNZ(cpu, reg - value);
+}
+
+// N and V are bits 7 and 6 of the operand, Z is whether it shares no bit with A
+template <typename Flags, typename State, typename Byte>
+void bit (State& cpu, Byte accumulator, Byte value) {
+    Flags::setN(cpu, value);
+    Flags::setOverflow(cpu, value << 1);
+    Flags::setZ(cpu, accumulator & value);
+}
+
+template <typename Flags, typename State, typename Byte>
+Byte asl (State& cpu, Byte value) {
+    Flags::setCarry(cpu, value & 0x80);
+    value <<= 1;
+    Flags::setNZ(cpu, value);
+    return value;
+}
+
+template <typename Flags, typename State, typename Byte>
+Byte lsr (State& cpu, Byte value) {
+    Flags::setCarry(cpu, value & 0x01);
+    value >>= 1;
+    Flags::setNZ(cpu, value);
+    return value;
+}
+
+template <typename Flags, typename State, typename Byte>
+Byte rol (State& cpu, Byte value) {
+    const Byte result = (value << 1) | Flags::carry(cpu);
+    Flags::setCarry(cpu, value & 0x80);
+    Flags::setNZ(cpu, result);
+    return result;
+}
+
+template <typename Flags, typename State, typename Byte>
+Byte ror (State& cpu, Byte value) {
+    const Byte result = (value >> 1) | (Flags::carry(cpu) << 7);
+    Flags::setCarry(cpu, value & 0x01);
+    Flags::setNZ(cpu, result);
+    return result;
+}
+
+template <typename Timing>
+void branch (Machine& machine, bool condition, uint16_t operand) {
+    if (condition) {
+        const auto target = resolve<AddressingMode::Relative, Timing>(machine, operand);
+
+        Timing::branched(machine, machine.cpu.pc, target);
+        machine.cpu.pc = target;
+    }
+}
+
+// the 65C02 finishes a decimal ADC or SBC one cycle later, and its shifts only take the page-crossing cycle when they cross
+template <Instruction Ins, AddressingMode Mode, typename Variant, typename Timing>
+void cmosCycles (Machine& machine, uint16_t operand) {
+    if constexpr (Variant::cmos && (Ins == Instruction::ADC || Ins == Instruction::SBC)) {
+        if (machine.cpu.p & FlagD) {
+            Timing::idle(machine);
+        }
+    } else if constexpr (Variant::cmos && Mode == AddressingMode::AbsoluteX) {
+        Timing::indexed(machine, operand, operand + machine.cpu.x);
+    }
+}
+
+template <Instruction Ins, AddressingMode Mode, typename Variant, typename Flags, typename Timing>
+void execute (Machine& machine, uint16_t operand) {
+    auto& cpu = machine.cpu;
+
+    if constexpr (Ins == Instruction::ADC) {
+        adc<Flags, Variant>(cpu, fetch<Mode, Timing>(machine, operand));
+        cmosCycles<Ins, Mode, Variant, Timing>(machine, operand);
+    } else if constexpr (Ins == Instruction::AND) {
+        cpu.a &= fetch<Mode, Timing>(machine, operand);
+        Flags::setNZ(cpu, cpu.a);
+    } else if constexpr (Ins == Instruction::ASL) {
+        cmosCycles<Ins, Mode, Variant, Timing>(machine, operand);
+        modify<Mode, Variant, Timing>(machine, operand, [&cpu] (uint8_t value) { return asl<Flags>(cpu, value); });
+    } else if constexpr (Ins == Instruction::BCC) {
+        branch<Timing>(machine, !Flags::carry(cpu), operand);
+    } else if constexpr (Ins == Instruction::BCS) {
+        branch<Timing>(machine, Flags::carry(cpu), operand);
+    } else if constexpr (Ins == Instruction::BEQ) {
+        branch<Timing>(machine, Flags::zero(cpu), operand);
+    } else if constexpr (Ins == Instruction::BIT) {
+        const auto value = fetch<Mode, Timing>(machine, operand);
+
+        // the 65C02's immediate form only sets Z
+        if constexpr (Mode == AddressingMode::Immediate) {
+            Flags::setZ(cpu, cpu.a & value);
+        } else {
+            bit<Flags>(cpu, cpu.a, value);
+        }
+    } else if constexpr (Ins == Instruction::BMI) {
+        branch<Timing>(machine, Flags::negative(cpu), operand);
+    } else if constexpr (Ins == Instruction::BNE) {
+        branch<Timing>(machine, !Flags::zero(cpu), operand);
+    } else if constexpr (Ins == Instruction::BPL) {
+        branch<Timing>(machine, !Flags::negative(cpu), operand);
+    } else if constexpr (Ins == Instruction::BRK) {
+        // the byte after BRK is padding and is skipped on return
+        enterInterrupt<Variant, Timing>(machine, cpu.pc + 1, Flags::status(cpu) | FlagB | FlagU, irqVector);
+    } else if constexpr (Ins == Instruction::BVC) {
+        branch<Timing>(machine, !Flags::overflow(cpu), operand);
+    } else if constexpr (Ins == Instruction::BVS) {
+        branch<Timing>(machine, Flags::overflow(cpu), operand);
+    } else if constexpr (Ins == Instruction::CLC) {
+        Flags::setCarry(cpu, false);
+    } else if constexpr (Ins == Instruction::CLD) {
+        cpu.p &= ~FlagD;
+    } else if constexpr (Ins == Instruction::CLI) {
+        cpu.p &= ~FlagI;
+    } else if constexpr (Ins == Instruction::CLV) {
+        Flags::setOverflow(cpu, 0);
+    } else if constexpr (Ins == Instruction::CMP) {
+        compare<Flags>(cpu, cpu.a, fetch<Mode, Timing>(machine, operand));
+    } else if constexpr (Ins == Instruction::CPX) {
+        compare<Flags>(cpu, cpu.x, fetch<Mode, Timing>(machine, operand));
+    } else if constexpr (Ins == Instruction::CPY) {
+        compare<Flags>(cpu, cpu.y, fetch<Mode, Timing>(machine, operand));
+    } else if constexpr (Ins == Instruction::DEC) {
+        modify<Mode, Variant, Timing>(machine, operand, [&cpu] (uint8_t value) -> uint8_t {
+            value--;
+            Flags::setNZ(cpu, value);
+            return value;
+        });
+    } else if constexpr (Ins == Instruction::DEX) {
+        cpu.x--;
+        Flags::setNZ(cpu, cpu.x);
+    } else if constexpr (Ins == Instruction::DEY) {
+        cpu.y--;
+        Flags::setNZ(cpu, cpu.y);
+    } else if constexpr (Ins == Instruction::EOR) {
+        cpu.a ^= fetch<Mode, Timing>(machine, operand);
+        Flags::setNZ(cpu, cpu.a);
+    } else if constexpr (Ins == Instruction::INC) {
+        modify<Mode, Variant, Timing>(machine, operand, [&cpu] (uint8_t value) -> uint8_t {
+            value++;
+            Flags::setNZ(cpu, value);
+            return value;
+        });
+    } else if constexpr (Ins == Instruction::INX) {
+        cpu.x++;
+        Flags::setNZ(cpu, cpu.x);
+    } else if constexpr (Ins == Instruction::INY) {
+        cpu.y++;
+        Flags::setNZ(cpu, cpu.y);
+    } else if constexpr (Ins == Instruction::JMP && Variant::cmos && Mode == AddressingMode::Indirect) {
+        // the 65C02 carries into the pointer's high byte
+        cpu.pc = readPointer<Timing>(machine, operand, operand + 1);
+    } else if constexpr (Ins == Instruction::JMP) {
+        cpu.pc = resolve<Mode, Timing>(machine, operand);
+    } else if constexpr (Ins == Instruction::JSR) {
+        // pushes the address of the last byte of the JSR
+        const uint16_t pc = cpu.pc - 1;
+        push<Timing>(machine, pc >> 8);
+        push<Timing>(machine, pc & 0xff);
+        cpu.pc = operand;
+    } else if constexpr (Ins == Instruction::LDA) {
+        cpu.a = fetch<Mode, Timing>(machine, operand);
+        Flags::setNZ(cpu, cpu.a);
+    } else if constexpr (Ins == Instruction::LDX) {
+        cpu.x = fetch<Mode, Timing>(machine, operand);
+        Flags::setNZ(cpu, cpu.x);
+    } else if constexpr (Ins == Instruction::LDY) {
+        cpu.y = fetch<Mode, Timing>(machine, operand);
+        Flags::setNZ(cpu, cpu.y);
+    } else if constexpr (Ins == Instruction::LSR) {
+        cmosCycles<Ins, Mode, Variant, Timing>(machine, operand);
+        modify<Mode, Variant, Timing>(machine, operand, [&cpu] (uint8_t value) { return lsr<Flags>(cpu, value); });
+    } else if constexpr (Ins == Instruction::NOP) {
+        // the undocumented forms still read their operand
+        if constexpr (Mode != AddressingMode::Implied && Mode != AddressingMode::Immediate) {
+            fetch<Mode, Timing>(machine, operand);
+        }
+    } else if constexpr (Ins == Instruction::ORA) {
+        cpu.a |= fetch<Mode, Timing>(machine, operand);
+        Flags::setNZ(cpu, cpu.a);
+    } else if constexpr (Ins == Instruction::PHA) {
+        push<Timing>(machine, cpu.a);
+    } else if constexpr (Ins == Instruction::PHP) {
+        push<Timing>(machine, Flags::status(cpu) | FlagB | FlagU);
+    } else if constexpr (Ins == Instruction::PLA) {
+        cpu.a = pull<Timing>(machine);
+        Flags::setNZ(cpu, cpu.a);
+    } else if constexpr (Ins == Instruction::PLP) {
+        Flags::setStatus(cpu, (pull<Timing>(machine) & ~FlagB) | FlagU);
+    } else if constexpr (Ins == Instruction::ROL) {
+        cmosCycles<Ins, Mode, Variant, Timing>(machine, operand);
+        modify<Mode, Variant, Timing>(machine, operand, [&cpu] (uint8_t value) { return rol<Flags>(cpu, value); });
+    } else if constexpr (Ins == Instruction::ROR) {
+        cmosCycles<Ins, Mode, Variant, Timing>(machine, operand);
+        modify<Mode, Variant, Timing>(machine, operand, [&cpu] (uint8_t value) { return ror<Flags>(cpu, value); });
+    } else if constexpr (Ins == Instruction::RTI) {
+        Flags::setStatus(cpu, (pull<Timing>(machine) & ~FlagB) | FlagU);
+        const uint8_t low = pull<Timing>(machine);
+        cpu.pc = low | (pull<Timing>(machine) << 8);
+    } else if constexpr (Ins == Instruction::RTS) {
+        const uint8_t low = pull<Timing>(machine);
+        cpu.pc = (low | (pull<Timing>(machine) << 8)) + 1;
+    } else if constexpr (Ins == Instruction::SBC) {
+        sbc<Flags, Variant>(cpu, fetch<Mode, Timing>(machine, operand));
+        cmosCycles<Ins, Mode, Variant, Timing>(machine, operand);
+    } else if constexpr (Ins == Instruction::SEC) {
+        Flags::setCarry(cpu, true);
+    } else if constexpr (Ins == Instruction::SED) {
+        cpu.p |= FlagD;
+    } else if constexpr (Ins == Instruction::SEI) {
+        cpu.p |= FlagI;
+    } else if constexpr (Ins == Instruction::STA) {
+        Timing::write(machine, resolve<Mode, Timing>(machine, operand), cpu.a);
+    } else if constexpr (Ins == Instruction::STX) {
+        Timing::write(machine, resolve<Mode, Timing>(machine, operand), cpu.x);
+    } else if constexpr (Ins == Instruction::STY) {
+        Timing::write(machine, resolve<Mode, Timing>(machine, operand), cpu.y);
+    } else if constexpr (Ins == Instruction::TAX) {
+        cpu.x = cpu.a;
+        Flags::setNZ(cpu, cpu.x);
+    } else if constexpr (Ins == Instruction::TAY) {
+        cpu.y = cpu.a;
+        Flags::setNZ(cpu, cpu.y);
+    } else if constexpr (Ins == Instruction::TSX) {
+        cpu.x = cpu.sp;
+        Flags::setNZ(cpu, cpu.x);
+    } else if constexpr (Ins == Instruction::TXA) {
+        cpu.a = cpu.x;
+        Flags::setNZ(cpu, cpu.a);
+    } else if constexpr (Ins == Instruction::TXS) {
+        cpu.sp = cpu.x;
+    } else if constexpr (Ins == Instruction::TYA) {
+        cpu.a = cpu.y;
+        Flags::setNZ(cpu, cpu.a);
+    } else if constexpr (Ins == Instruction::ALR) {
+        cpu.a &= fetch<Mode, Timing>(machine, operand);
+        Flags::setCarry(cpu, cpu.a & 0x01);
+        cpu.a >>= 1;
+        Flags::setNZ(cpu, cpu.a);
+    } else if constexpr (Ins == Instruction::ANC) {
+        cpu.a &= fetch<Mode, Timing>(machine, operand);
+        Flags::setNZ(cpu, cpu.a);
+        Flags::setCarry(cpu, cpu.a & 0x80);
+    } else if constexpr (Ins == Instruction::ARR) {
+        const uint8_t value = cpu.a & fetch<Mode, Timing>(machine, operand);
+        const uint8_t result = (value >> 1) | (Flags::carry(cpu) << 7);
+
+        if (cpu.p & FlagD) {
+            // decimal mode fixes up each nibble of the rotated value, like ADC would
+            Flags::setNZ(cpu, result);
+            Flags::setOverflow(cpu, (value ^ result) << 1);
+            cpu.a = result;
+
+            if ((value & 0x0f) + (value & 0x01) > 0x05) {
+                cpu.a = (cpu.a & 0xf0) | ((cpu.a + 0x06) & 0x0f);
+            }
+
+            const auto carry = (value & 0xf0) + (value & 0x10) > 0x50;
+            Flags::setCarry(cpu, carry);
+            cpu.a += carry ? 0x60 : 0x00;
+        } else {
+            cpu.a = result;
+            Flags::setNZ(cpu, cpu.a);
+            Flags::setCarry(cpu, cpu.a & 0x40);
+            Flags::setOverflow(cpu, (cpu.a << 1) ^ (cpu.a << 2));
+        }
+    } else if constexpr (Ins == Instruction::DCP) {
+        modify<Mode, Variant, Timing>(machine, operand, [&cpu] (uint8_t value) -> uint8_t {
+            value--;
+            compare<Flags>(cpu, cpu.a, value);
+            return value;
+        });
+    } else if constexpr (Ins == Instruction::ISC) {
+        modify<Mode, Variant, Timing>(machine, operand, [&cpu] (uint8_t value) -> uint8_t {
+            value++;
+            sbc<Flags, Variant>(cpu, value);
+            return value;
+        });
+    } else if constexpr (Ins == Instruction::LAS) {
+        cpu.a = cpu.x = cpu.sp = cpu.sp & fetch<Mode, Timing>(machine, operand);
+        Flags::setNZ(cpu, cpu.a);
+    } else if constexpr (Ins == Instruction::LAX) {
+        cpu.a = cpu.x = fetch<Mode, Timing>(machine, operand);
+        Flags::setNZ(cpu, cpu.a);
+    } else if constexpr (Ins == Instruction::RLA) {
+        modify<Mode, Variant, Timing>(machine, operand, [&cpu] (uint8_t value) -> uint8_t {
+            const uint8_t result = (value << 1) | Flags::carry(cpu);
+            Flags::setCarry(cpu, value & 0x80);
+            cpu.a &= result;
+            Flags::setNZ(cpu, cpu.a);
+            return result;
+        });
+    } else if constexpr (Ins == Instruction::RRA) {
+        modify<Mode, Variant, Timing>(machine, operand, [&cpu] (uint8_t value) -> uint8_t {
+            const uint8_t result = (value >> 1) | (Flags::carry(cpu) << 7);
+            Flags::setCarry(cpu, value & 0x01);
+            adc<Flags, Variant>(cpu, result);
+            return result;
+        });
+    } else if constexpr (Ins == Instruction::SAX) {
+        Timing::write(machine, resolve<Mode, Timing>(machine, operand), cpu.a & cpu.x);
+    } else if constexpr (Ins == Instruction::SBX) {
+        const uint8_t value = cpu.a & cpu.x;
+        const auto subtrahend = fetch<Mode, Timing>(machine, operand);
+
+        Flags::setCarry(cpu, value >= subtrahend);
+        cpu.x = value - subtrahend;
+        Flags::setNZ(cpu, cpu.x);
+    } else if constexpr (Ins == Instruction::SLO) {
+        modify<Mode, Variant, Timing>(machine, operand, [&cpu] (uint8_t value) -> uint8_t {
+            Flags::setCarry(cpu, value & 0x80);
+            value <<= 1;
+            cpu.a |= value;
+            Flags::setNZ(cpu, cpu.a);
+            return value;
+        });
+    } else if constexpr (Ins == Instruction::SRE) {
+        modify<Mode, Variant, Timing>(machine, operand, [&cpu] (uint8_t value) -> uint8_t {
+            Flags::setCarry(cpu, value & 0x01);
+            value >>= 1;
+            cpu.a ^= value;
+            Flags::setNZ(cpu, cpu.a);
+            return value;
+        });
+    } else if constexpr (Ins == Instruction::BRA) {
+        branch<Timing>(machine, true, operand);
+    } else if constexpr (Ins == Instruction::PHX) {
+        push<Timing>(machine, cpu.x);
+    } else if constexpr (Ins == Instruction::PHY) {
+        push<Timing>(machine, cpu.y);
+    } else if constexpr (Ins == Instruction::PLX) {
+        cpu.x = pull<Timing>(machine);
+        Flags::setNZ(cpu, cpu.x);
+    } else if constexpr (Ins == Instruction::PLY) {
+        cpu.y = pull<Timing>(machine);
+        Flags::setNZ(cpu, cpu.y);
+    } else if constexpr (Ins == Instruction::STZ) {
+        Timing::write(machine, resolve<Mode, Timing>(machine, operand), 0);
+    } else if constexpr (Ins == Instruction::TRB) {
+        modify<Mode, Variant, Timing>(machine, operand, [&cpu] (uint8_t value) -> uint8_t {
+            Flags::setZ(cpu, cpu.a & value);
+            return value & ~cpu.a;
+        });
+    } else if constexpr (Ins == Instruction::TSB) {
+        modify<Mode, Variant, Timing>(machine, operand, [&cpu] (uint8_t value) -> uint8_t {
+            Flags::setZ(cpu, cpu.a & value);
+            return value | cpu.a;
+        });
+    } else {
+        static_assert(dependentFalse<Ins>, "unhandled instruction");
+    }
+}
+
+template <uint8_t Opcode, typename Variant, typename Flags, typename Timing>
+void executeOpcode (Machine& machine, uint16_t operand) {
+    constexpr auto info = Variant::infos[Opcode];
+
+    if constexpr (!info.valid) {
+        // opcodes missing from the table jam the cpu, pc stays on the opcode and the run loops stop at the deadline
+        machine.cpu.pc--;
+        machine.halted = true;
+        machine.scheduler.deadline = 0;
+    } else {
+        execute<info.instruction, info.mode, Variant, Flags, Timing>(machine, operand);
+    }
+}
+
+// one executor per opcode byte, instantiated from the variant's opcode infos at compile time
+template <typename Variant, typename Flags, typename Timing>
+constexpr auto executors = [] <size_t ...Opcodes> (std::index_sequence<Opcodes...>) {
+    return std::array<Executor, 256> { &executeOpcode<Opcodes, Variant, Flags, Timing>... };
+}(std::make_index_sequence<256> {});
+
+
+
+#endif //INSTRUCTIONS_H
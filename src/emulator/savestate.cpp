@@ -0,0 +1,488 @@
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "savestate.h"
+
+
+enum PageEncoding : uint8_t {
+    PageZero,
+    PageRaw,
+    PagePacked,
+};
+
+constexpr uint8_t chunkCpu[4] { 'C', 'P', 'U', ' ' };
+constexpr uint8_t chunkInterrupts[4] { 'I', 'R', 'Q', ' ' };
+constexpr uint8_t chunkMemory[4] { 'M', 'E', 'M', ' ' };
+constexpr uint8_t chunkMemoryDelta[4] { 'X', 'M', 'E', 'M' };
+constexpr uint8_t chunkTimer[4] { 'T', 'I', 'M', 'R' };
+constexpr uint8_t chunkInput[4] { 'I', 'N', 'P', 'T' };
+
+void put8 (std::vector<uint8_t>& state, uint8_t value) {
+    state.push_back(value);
+}
+
+void put16 (std::vector<uint8_t>& state, uint16_t value) {
+    put8(state, value & 0xff);
+    put8(state, value >> 8);
+}
+
+void put32 (std::vector<uint8_t>& state, uint32_t value) {
+    put16(state, value & 0xffff);
+    put16(state, value >> 16);
+}
+
+void put64 (std::vector<uint8_t>& state, uint64_t value) {
+    put32(state, value & 0xffffffff);
+    put32(state, value >> 32);
+}
+
+// returns where the length goes once the chunk is complete
+size_t beginChunk (std::vector<uint8_t>& state, const uint8_t (&tag)[4]) {
+    state.insert(state.end(), tag, tag + 4);
+    put32(state, 0);
+
+    return state.size();
+}
+
+void endChunk (std::vector<uint8_t>& state, size_t start) {
+    const auto length = state.size() - start;
+
+    for (size_t index = 0; index < 4; index++) {
+        state[start - 4 + index] = length >> (index * 8);
+    }
+}
+
+// a header below 0x80 is followed by header + 1 literal bytes, one above by a byte repeated header - 0x80 + 2 times
+void packPage (const uint8_t* page, std::vector<uint8_t>& state) {
+    size_t at = 0;
+
+    while (at < 0x100) {
+        size_t run = 1;
+
+        // a word at a time first, delta pages are mostly long runs of zeros
+        const auto repeated = page[at] * uint64_t { 0x0101010101010101 };
+        uint64_t word;
+
+        while (at + run + 8 <= 0x100 && run + 8 <= 0x81 && (memcpy(&word, page + at + run, 8), word == repeated)) {
+            run += 8;
+        }
+
+        while (at + run < 0x100 && run < 0x81 && page[at + run] == page[at]) {
+            run++;
+        }
+
+        if (run >= 3) {
+            put8(state, 0x80 + run - 2);
+            put8(state, page[at]);
+            at += run;
+            continue;
+        }
+
+        // literals up to the next run worth its two bytes
+        const auto start = at;
+
+        while (at < 0x100 && at - start < 0x80) {
+            if (at + 2 < 0x100 && page[at] == page[at + 1] && page[at] == page[at + 2]) {
+                break;
+            }
+
+            at++;
+        }
+
+        put8(state, at - start - 1);
+        state.insert(state.end(), page + start, page + at);
+    }
+}
+
+void savePage (const uint8_t* bytes, std::vector<uint8_t>& state) {
+    if (bytes[0] == 0 && memcmp(bytes, bytes + 1, 0xff) == 0) {
+        put8(state, PageZero);
+        return;
+    }
+
+    const auto header = state.size();
+    put8(state, PagePacked);
+    packPage(bytes, state);
+
+    if (state.size() - header > 0x100) {
+        state.resize(header);
+        put8(state, PageRaw);
+        state.insert(state.end(), bytes, bytes + 0x100);
+    }
+}
+
+void saveMemory (const Machine& machine, std::vector<uint8_t>& state) {
+    for (size_t page = 0; page < 0x100; page++) {
+        savePage(&machine.memory[page << 8], state);
+    }
+}
+
+// only the pages that differ from the base, each as its number and its XOR with the base, which is mostly zeros
+void saveMemoryDelta (const Machine& machine, const uint8_t* base, const PageSet* pages, std::vector<uint8_t>& state) {
+    constexpr PageSet allPages { ~uint64_t { 0 }, ~uint64_t { 0 }, ~uint64_t { 0 }, ~uint64_t { 0 } };
+    const auto& compared = pages == nullptr ? allPages : *pages;
+    uint8_t difference[0x100];
+
+    for (size_t word = 0; word < compared.size(); word++) {
+        for (auto set = compared[word]; set != 0; set &= set - 1) {
+            const auto page = word * 64 + std::countr_zero(set);
+            const auto* bytes = &machine.memory[page << 8];
+            const auto* baseBytes = base + (page << 8);
+
+            if (memcmp(bytes, baseBytes, 0x100) == 0) {
+                continue;
+            }
+
+            for (size_t index = 0; index < 0x100; index++) {
+                difference[index] = bytes[index] ^ baseBytes[index];
+            }
+
+            put8(state, page);
+            savePage(difference, state);
+        }
+    }
+}
+
+void saveState (const Machine& machine, const StateDevices& devices, std::vector<uint8_t>& state, const uint8_t* base, const PageSet* pages) {
+    const auto& cpu = machine.cpu;
+
+    state.clear();
+    state.insert(state.end(), saveStateMagic, saveStateMagic + 4);
+    put16(state, saveStateVersion);
+
+    auto chunk = beginChunk(state, chunkCpu);
+    put8(state, static_cast<uint8_t>(machine.variant));
+    put8(state, cpu.a);
+    put8(state, cpu.x);
+    put8(state, cpu.y);
+    put8(state, cpu.sp);
+    put8(state, cpu.p);
+    put16(state, cpu.pc);
+    put8(state, machine.halted);
+    put64(state, machine.cycles);
+    put64(state, machine.instructions);
+    endChunk(state, chunk);
+
+    chunk = beginChunk(state, chunkInterrupts);
+    put32(state, machine.scheduler.irqLines);
+    put8(state, machine.scheduler.nmiPending);
+    endChunk(state, chunk);
+
+    if (base == nullptr) {
+        chunk = beginChunk(state, chunkMemory);
+        saveMemory(machine, state);
+    } else {
+        chunk = beginChunk(state, chunkMemoryDelta);
+        saveMemoryDelta(machine, base, pages, state);
+    }
+
+    endChunk(state, chunk);
+
+    if (const auto* timer = devices.timer) {
+        chunk = beginChunk(state, chunkTimer);
+        put16(state, timer->period);
+        put8(state, timer->control);
+        put8(state, timer->expired);
+        put8(state, timer->expiry.slot != unscheduled);
+        put64(state, timer->expiry.cycle);
+        endChunk(state, chunk);
+    }
+
+    if (const auto* input = devices.input) {
+        chunk = beginChunk(state, chunkInput);
+        put8(state, input->buttons);
+        put8(state, input->character);
+        endChunk(state, chunk);
+    }
+}
+
+// reading past the end yields zeros and marks the reader failed
+struct StateReader {
+    const uint8_t* data;
+    size_t size;
+    size_t at = 0;
+    bool failed = false;
+};
+
+uint8_t get8 (StateReader& reader) {
+    if (reader.at >= reader.size) {
+        reader.failed = true;
+        return 0;
+    }
+
+    return reader.data[reader.at++];
+}
+
+uint16_t get16 (StateReader& reader) {
+    const auto low = get8(reader);
+    return low | (get8(reader) << 8);
+}
+
+uint32_t get32 (StateReader& reader) {
+    const auto low = get16(reader);
+    return low | (static_cast<uint32_t>(get16(reader)) << 16);
+}
+
+uint64_t get64 (StateReader& reader) {
+    const auto low = get32(reader);
+    return low | (static_cast<uint64_t>(get32(reader)) << 32);
+}
+
+bool loadPage (StateReader& reader, uint8_t* page) {
+    switch (get8(reader)) {
+        case PageZero:
+            memset(page, 0, 0x100);
+            return !reader.failed;
+
+        case PageRaw:
+            if (reader.size - reader.at < 0x100) {
+                return false;
+            }
+
+            memcpy(page, reader.data + reader.at, 0x100);
+            reader.at += 0x100;
+            return true;
+
+        case PagePacked:
+            break;
+
+        default:
+            return false;
+    }
+
+    for (size_t at = 0; at < 0x100 && !reader.failed;) {
+        const auto header = get8(reader);
+        const size_t count = header < 0x80 ? header + 1 : header - 0x80 + 2;
+
+        if (at + count > 0x100) {
+            return false;
+        }
+
+        if (header < 0x80) {
+            for (size_t index = 0; index < count; index++) {
+                page[at++] = get8(reader);
+            }
+        } else {
+            memset(page + at, get8(reader), count);
+            at += count;
+        }
+    }
+
+    return !reader.failed;
+}
+
+// everything is read and checked before any of it is applied
+struct LoadedState {
+    CpuVariant variant = CpuVariant::Nmos;
+    Cpu cpu;
+    bool halted = false;
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint32_t irqLines = 0;
+    bool nmiPending = false;
+    std::vector<uint8_t> memory;
+
+    bool hasTimer = false;
+    Timer timer;
+    bool timerScheduled = false;
+    uint64_t timerCycle = 0;
+
+    bool hasInput = false;
+    Input input;
+};
+
+bool parseState (const std::vector<uint8_t>& state, const uint8_t* base, LoadedState& loaded) {
+    StateReader reader { state.data(), state.size() };
+
+    if (state.size() < 6 || memcmp(state.data(), saveStateMagic, 4) != 0) {
+        return false;
+    }
+
+    reader.at = 4;
+
+    if (get16(reader) > saveStateVersion) {
+        return false;
+    }
+
+    auto hasCpu = false;
+
+    while (reader.at < reader.size) {
+        if (reader.size - reader.at < 8) {
+            return false;
+        }
+
+        const auto* tag = reader.data + reader.at;
+        reader.at += 4;
+        const auto length = get32(reader);
+
+        if (reader.size - reader.at < length) {
+            return false;
+        }
+
+        // each chunk is read on its own, up to its length
+        StateReader chunk { reader.data + reader.at, length };
+        reader.at += length;
+
+        if (memcmp(tag, chunkCpu, 4) == 0) {
+            loaded.variant = static_cast<CpuVariant>(get8(chunk));
+            loaded.cpu.a = get8(chunk);
+            loaded.cpu.x = get8(chunk);
+            loaded.cpu.y = get8(chunk);
+            loaded.cpu.sp = get8(chunk);
+            loaded.cpu.p = get8(chunk);
+            loaded.cpu.pc = get16(chunk);
+            loaded.halted = get8(chunk) != 0;
+            loaded.cycles = get64(chunk);
+            loaded.instructions = get64(chunk);
+            hasCpu = true;
+        } else if (memcmp(tag, chunkInterrupts, 4) == 0) {
+            loaded.irqLines = get32(chunk);
+            loaded.nmiPending = get8(chunk) != 0;
+        } else if (memcmp(tag, chunkMemory, 4) == 0) {
+            loaded.memory.resize(0x10000);
+
+            for (size_t page = 0; page < 0x100; page++) {
+                if (!loadPage(chunk, &loaded.memory[page << 8])) {
+                    return false;
+                }
+            }
+        } else if (memcmp(tag, chunkMemoryDelta, 4) == 0) {
+            if (base == nullptr) {
+                return false;
+            }
+
+            loaded.memory.assign(base, base + 0x10000);
+            uint8_t difference[0x100];
+
+            while (chunk.at < chunk.size) {
+                auto* bytes = &loaded.memory[get8(chunk) << 8];
+
+                if (!loadPage(chunk, difference)) {
+                    return false;
+                }
+
+                for (size_t index = 0; index < 0x100; index++) {
+                    bytes[index] ^= difference[index];
+                }
+            }
+        } else if (memcmp(tag, chunkTimer, 4) == 0) {
+            loaded.timer.period = get16(chunk);
+            loaded.timer.control = get8(chunk);
+            loaded.timer.expired = get8(chunk) != 0;
+            loaded.timerScheduled = get8(chunk) != 0;
+            loaded.timerCycle = get64(chunk);
+            loaded.hasTimer = true;
+        } else if (memcmp(tag, chunkInput, 4) == 0) {
+            loaded.input.buttons = get8(chunk);
+            loaded.input.character = get8(chunk);
+            loaded.hasInput = true;
+        }
+
+        if (chunk.failed) {
+            return false;
+        }
+    }
+
+    return hasCpu && !loaded.memory.empty();
+}
+
+// pages without cached code are copied whole, the others byte by byte so that only overwritten code is dropped,
+// either way a page that changes is dirty
+void restoreMemory (Machine& machine, const std::vector<uint8_t>& memory) {
+    for (size_t page = 0; page < 0x100; page++) {
+        const auto start = page << 8;
+
+        if (memcmp(&machine.memory[start], &memory[start], 0x100) == 0) {
+            continue;
+        }
+
+        markDirtyPage(machine, page);
+
+        if (machine.blockCache.pageRefs[page] == 0) {
+            memcpy(&machine.memory[start], &memory[start], 0x100);
+            continue;
+        }
+
+        for (auto address = start; address < start + 0x100; address++) {
+            if (machine.memory[address] != memory[address]) {
+                machine.memory[address] = memory[address];
+                invalidateCode(machine, address);
+            }
+        }
+    }
+
+    machine.blockCache.leave = false;
+}
+
+bool loadState (Machine& machine, const StateDevices& devices, const std::vector<uint8_t>& state, const uint8_t* base) {
+    LoadedState loaded;
+
+    if (!parseState(state, base, loaded) || loaded.variant != machine.variant) {
+        return false;
+    }
+
+    restoreMemory(machine, loaded.memory);
+
+    machine.cpu = loaded.cpu;
+    machine.halted = loaded.halted;
+    machine.cycles = loaded.cycles;
+    machine.instructions = loaded.instructions;
+    machine.scheduler.irqLines = loaded.irqLines;
+    machine.scheduler.nmiPending = loaded.nmiPending;
+
+    if (auto* timer = devices.timer; timer != nullptr && loaded.hasTimer) {
+        timer->period = loaded.timer.period;
+        timer->control = loaded.timer.control;
+        timer->expired = loaded.timer.expired;
+        cancel(machine, timer->expiry);
+
+        if (loaded.timerScheduled) {
+            schedule(machine, timer->expiry, loaded.timerCycle);
+        }
+    }
+
+    if (auto* input = devices.input; input != nullptr && loaded.hasInput) {
+        *input = loaded.input;
+    }
+
+    if (auto* framebuffer = devices.framebuffer) {
+        framebuffer->dirtyRows.fill(true);
+        framebuffer->dirty = true;
+    }
+
+    // the counters may have gone back, anything timed against them starts over from here
+    machine.idle.interval = minIdleProbeInterval;
+    machine.idle.nextProbe = machine.cycles + minIdleProbeInterval;
+    updateDeadline(machine);
+
+    return true;
+}
+
+// through a temporary file, so that a run stopped mid-write keeps its previous state
+bool writeStateFile (const std::string& path, const std::vector<uint8_t>& state) {
+    const auto temporary = path + ".tmp";
+
+    {
+        std::ofstream file { temporary, std::ios::binary | std::ios::trunc };
+        file.write(reinterpret_cast<const char*>(state.data()), state.size());
+
+        if (!file) {
+            return false;
+        }
+    }
+
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+bool readStateFile (const std::string& path, std::vector<uint8_t>& state) {
+    std::ifstream file { path, std::ios::binary };
+
+    if (!file.is_open()) {
+        return false;
+    }
+
+    state.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
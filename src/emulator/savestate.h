@@ -0,0 +1,42 @@
+#ifndef SAVESTATE_H
+#define SAVESTATE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Framebuffer.h"
+#include "Input.h"
+#include "Machine.h"
+#include "Timer.h"
+
+
+
+// "HSTA", then the version and tagged chunks of a 32-bit length each, all little-endian,
+// a loader skips chunks it does not know and refuses versions newer than its own
+constexpr uint8_t saveStateMagic[4] { 'H', 'S', 'T', 'A' };
+constexpr uint16_t saveStateVersion = 1;
+
+// the devices saved along with the machine, null for those that are not attached
+struct StateDevices {
+    Timer* timer = nullptr;
+    Input* input = nullptr;
+    Framebuffer* framebuffer = nullptr;
+};
+
+// registers, counters, pending interrupts, memory and the devices' registers and events,
+// memory goes page by page as all zeros, as runs and literals or as it is, whichever is shortest
+// given a 64 KiB base, only the pages that differ from it are saved, and the state only loads against the same base,
+// given pages as well, only those are compared and the rest have to match the base
+void saveState (const Machine&, const StateDevices&, std::vector<uint8_t>& state, const uint8_t* base = nullptr, const PageSet* pages = nullptr);
+
+// false, leaving the machine as it was, when the state is malformed, newer, or for another cpu variant
+// cached code that the restored memory overwrites is dropped, the rest stays
+bool loadState (Machine&, const StateDevices&, const std::vector<uint8_t>& state, const uint8_t* base = nullptr);
+
+bool writeStateFile (const std::string& path, const std::vector<uint8_t>& state);
+bool readStateFile (const std::string& path, std::vector<uint8_t>& state);
+
+
+
+#endif //SAVESTATE_H
@@ -0,0 +1,256 @@
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "emulator/cpu.h"
+#include "Emulation.h"
+
+
+bool attachDevices (Emulation& emulation) {
+    return attachTimer(emulation.machine, emulation.timer)
+        && attachFramebuffer(emulation.machine, emulation.framebuffer)
+        && attachInput(emulation.machine, emulation.input);
+}
+
+StateDevices stateDevices (Emulation& emulation) {
+    return { &emulation.timer, &emulation.input, &emulation.framebuffer };
+}
+
+bool saveStateFile (Emulation& emulation) {
+    saveState(emulation.machine, stateDevices(emulation), emulation.state);
+
+    if (!writeStateFile(emulation.stateFile, emulation.state)) {
+        fprintf(stderr, "cannot write %s\n", emulation.stateFile.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool loadStateFile (Emulation& emulation) {
+    if (!readStateFile(emulation.stateFile, emulation.state)) {
+        fprintf(stderr, "cannot read %s\n", emulation.stateFile.c_str());
+        return false;
+    }
+
+    if (!loadState(emulation.machine, stateDevices(emulation), emulation.state)) {
+        fprintf(stderr, "%s is not a state of this machine\n", emulation.stateFile.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// shows the frame runAhead frames on from this one, run with the input as it stands, then takes them back
+// the framebuffer's pixels are left showing that future frame, false when the machine could not be restored
+bool runAhead (Emulation& emulation, uint64_t frameEnd) {
+    auto& machine = emulation.machine;
+    const auto devices = stateDevices(emulation);
+
+    // what runs ahead is taken back, so it is left out of the heatmap
+    auto* heatmap = machine.heatmap;
+    machine.heatmap = nullptr;
+
+    emulation.aheadMemory = machine.memory;
+    saveState(machine, devices, emulation.aheadState, emulation.aheadMemory.data());
+
+    for (uint32_t ahead = 1; ahead <= emulation.runAhead && !machine.halted; ahead++) {
+        const auto end = frameEnd + ahead * emulation.cyclesPerSecond / framesPerSecond;
+
+        if (machine.cycles < end) {
+            runCycles(machine, end - machine.cycles);
+        }
+    }
+
+    convertFramebuffer(machine, emulation.framebuffer);
+    machine.heatmap = heatmap;
+
+    // every row is converted again next time, from the restored memory on
+    return loadState(machine, devices, emulation.aheadState, emulation.aheadMemory.data());
+}
+
+// a movie ends with the state the machine reached, a reason says what ended it early
+void endRecording (Emulation& emulation, uint64_t frame, const char* reason) {
+    if (!emulation.movie.open) {
+        return;
+    }
+
+    if (!closeMovie(emulation.movie, frame, emulation.machine, stateDevices(emulation))) {
+        fprintf(stderr, "cannot write %s\n", emulation.movieFile.c_str());
+    } else if (reason != nullptr) {
+        fprintf(stderr, "%s ends the recording at frame %llu\n", reason, static_cast<unsigned long long>(frame));
+    }
+}
+
+// the sleep can only be trusted to within spinMargin, the last of the wait polls the clock
+void waitUntil (std::chrono::steady_clock::time_point due) {
+    std::this_thread::sleep_until(due - spinMargin);
+
+    while (std::chrono::steady_clock::now() < due) {
+    }
+}
+
+void emulate (Emulation& emulation) {
+    auto& machine = emulation.machine;
+    const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::seconds(1)) / framesPerSecond;
+    auto firstCycle = machine.cycles;
+
+    auto due = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration lateness {};
+    std::chrono::steady_clock::duration emulated {};
+    std::chrono::steady_clock::time_point inputSent {};
+    uint64_t number = 0;
+    uint64_t firstFrame = 0;
+    uint64_t version = 0;
+    auto held = false;
+    uint64_t decayed = 0;
+
+    while (!emulation.stop.load(std::memory_order_relaxed)) {
+        if (emulation.saveRequested.exchange(false, std::memory_order_relaxed)) {
+            saveStateFile(emulation);
+        }
+
+        // the frames' cycles count on from the loaded one
+        if (emulation.loadRequested.exchange(false, std::memory_order_relaxed)) {
+            endRecording(emulation, number, "loading a state");
+
+            if (loadStateFile(emulation)) {
+                firstCycle = machine.cycles;
+                firstFrame = number;
+            }
+        }
+
+        // counting starts afresh every time the heatmap is shown
+        if (emulation.heatmapShown.load(std::memory_order_relaxed) != (machine.heatmap != nullptr)) {
+            emulation.heatmap = {};
+            machine.heatmap = machine.heatmap == nullptr ? &emulation.heatmap : nullptr;
+        }
+
+        if (emulation.clearRequested.exchange(false, std::memory_order_relaxed)) {
+            clearDebugger(machine);
+            held = false;
+        }
+
+        if (emulation.resumeRequested.exchange(false, std::memory_order_relaxed)) {
+            held = false;
+        }
+
+        while (const auto queued = pop(emulation.inputs)) {
+            applyInput(emulation.input, queued->event);
+
+            if (emulation.movie.open) {
+                recordMovieInput(emulation.movie, number + 1, machine.cycles, queued->event);
+            }
+
+            if (inputSent == std::chrono::steady_clock::time_point {}) {
+                inputSent = queued->sent;
+            }
+        }
+
+        number++;
+        const auto frameStart = std::chrono::steady_clock::now();
+
+        // a frame back through the history takes the place of running one, the next frame runs on from it
+        if (emulation.rewinding.load(std::memory_order_relaxed)) {
+            endRecording(emulation, number, "rewinding");
+
+            if (stepBack(emulation.rewind, machine, stateDevices(emulation))) {
+                firstCycle = machine.cycles;
+                firstFrame = number;
+            }
+        } else if (held) {
+            if (emulation.stepRequested.exchange(false, std::memory_order_relaxed)) {
+                runInstructions(machine, 1);
+            }
+
+            // the frames' cycles count on from wherever the machine goes on
+            firstCycle = machine.cycles;
+            firstFrame = number;
+        } else {
+            // every frame ends on the cycle its share of the clock rate adds up to, whatever the last instruction ran over
+            const auto end = firstCycle + (number - firstFrame) * emulation.cyclesPerSecond / framesPerSecond;
+            const auto start = std::chrono::steady_clock::now();
+
+            if (machine.cycles < end) {
+                runCycles(machine, end - machine.cycles);
+            }
+
+            emulated += std::chrono::steady_clock::now() - start;
+            recordFrame(emulation.rewind, machine, stateDevices(emulation));
+            held = machine.debugging && emulation.debugger.stopped;
+
+            if (emulation.movie.open && number % movieCheckpointFrames == 0) {
+                recordMovieCheckpoint(emulation.movie, number, machine, stateDevices(emulation));
+            }
+        }
+
+        // a held machine is shown paced, and frames ahead of it would run into its breakpoints
+        const auto warp = emulation.warp.load(std::memory_order_relaxed) && !held;
+        const auto ahead = emulation.runAhead != 0 && !warp && !emulation.rewinding.load(std::memory_order_relaxed) && !machine.debugging;
+
+        if (!warp || number % warpPresentInterval == 0) {
+            const auto changed = ahead
+                ? runAhead(emulation, firstCycle + (number - firstFrame) * emulation.cyclesPerSecond / framesPerSecond)
+                : convertFramebuffer(machine, emulation.framebuffer);
+
+            if (changed) {
+                version++;
+            }
+
+            // running the frame and the ones ahead of it has to fit in the frame it stands for
+            const auto busy = std::chrono::steady_clock::now() - frameStart;
+            emulation.aheadMissed += ahead && busy > period;
+
+            auto& frame = backSlot(emulation.frames);
+
+            if (frame.version != version) {
+                frame.pixels = emulation.framebuffer.pixels;
+                frame.version = version;
+            }
+
+            frame.number = number;
+            frame.inputSent = inputSent;
+            frame.lateness = lateness;
+            frame.warp = warp;
+            frame.rewindFrames = rewindFrames(emulation.rewind);
+            frame.rewindBytes = emulation.rewind.used;
+            frame.rewindShare = emulated.count() == 0 ? 0 : static_cast<double>(emulation.rewind.spent.count()) / emulated.count();
+            frame.runAhead = ahead ? emulation.runAhead : 0;
+            frame.aheadBusy = std::chrono::duration<double>(busy) / period;
+            frame.aheadMissed = emulation.aheadMissed;
+            frame.stopped = held;
+            frame.stop = emulation.debugger.stop;
+            frame.heatmap = machine.heatmap != nullptr;
+
+            // every frame halves the counts, those in between frames that are shown all at once
+            if (frame.heatmap) {
+                paintHeatmap(emulation.heatmap, frame.heat.data());
+                decayHeatmap(emulation.heatmap, number - decayed);
+            }
+
+            decayed = number;
+            publish(emulation.frames);
+
+            inputSent = {};
+        }
+
+        if (warp) {
+            due = std::chrono::steady_clock::now();
+            lateness = {};
+            continue;
+        }
+
+        due += period;
+
+        // after falling behind, say while the process was stopped, carry on from now instead of catching up in a burst
+        if (std::chrono::steady_clock::now() > due + period) {
+            due = std::chrono::steady_clock::now();
+        } else {
+            waitUntil(due);
+        }
+
+        lateness = std::chrono::steady_clock::now() - due;
+    }
+
+    endRecording(emulation, number, nullptr);
+}
@@ -0,0 +1,135 @@
+#ifndef EMULATION_H
+#define EMULATION_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "emulator/Debugger.h"
+#include "emulator/Framebuffer.h"
+#include "emulator/Heatmap.h"
+#include "emulator/Input.h"
+#include "emulator/Machine.h"
+#include "emulator/Movie.h"
+#include "emulator/Rewind.h"
+#include "emulator/savestate.h"
+#include "emulator/Timer.h"
+#include "SpscQueue.h"
+#include "TripleBuffer.h"
+
+
+
+constexpr uint32_t framesPerSecond = 60;
+
+// warp mode runs frames back to back and only hands every this many over to the window
+constexpr uint64_t warpPresentInterval = 8;
+
+// how far ahead of a frame's deadline paced mode stops sleeping and polls the clock instead
+constexpr std::chrono::microseconds spinMargin { 1000 };
+
+struct Frame {
+    std::array<Rgba, framebufferWidth * framebufferHeight> pixels {};
+
+    // counts changes to the framebuffer, pixels are only copied into a slot and uploaded when it moved on
+    uint64_t version = 0;
+
+    // emulated frames since the start
+    uint64_t number = 0;
+
+    // when the window sent the earliest input this frame is the first to show, the epoch without one
+    std::chrono::steady_clock::time_point inputSent {};
+
+    // how far past its deadline the emulation woke up for this frame, zero in warp mode
+    std::chrono::steady_clock::duration lateness {};
+    bool warp = false;
+
+    // the rewind history, and the time spent recording it against the time spent running frames
+    size_t rewindFrames = 0;
+    size_t rewindBytes = 0;
+    double rewindShare = 0;
+
+    // the frames shown ahead of this one, the share of the frame period it took to run them all, and the frames so far
+    // that took longer than the period
+    uint32_t runAhead = 0;
+    double aheadBusy = 0;
+    uint64_t aheadMissed = 0;
+
+    // the machine is held where the debugger stopped it
+    bool stopped = false;
+    DebugStop stop;
+
+    // painted while the window shows the heatmap
+    bool heatmap = false;
+    std::array<Rgba, heatmapSide * heatmapSide> heat {};
+};
+
+struct QueuedInput {
+    InputEvent event;
+    std::chrono::steady_clock::time_point sent;
+};
+
+// the machine and its devices belong to the emulation thread once it started,
+// the render thread only takes frames and hands input and the mode over
+struct Emulation {
+    Machine machine;
+    Timer timer;
+    Framebuffer framebuffer;
+    Input input;
+
+    // paced mode runs exactly this many cycles per second of real time
+    uint32_t cyclesPerSecond = clockRate;
+
+    // saved to and loaded from between frames, when the window asks for it
+    std::string stateFile;
+    std::vector<uint8_t> state;
+
+    // every frame that runs is recorded, while rewinding is set the frames step back through them instead
+    Rewind rewind;
+
+    // paced frames show the machine this many frames on, run with the same input and then taken back
+    uint32_t runAhead = 0;
+    std::vector<uint8_t> aheadState;
+    std::array<uint8_t, 0x10000> aheadMemory {};
+    uint64_t aheadMissed = 0;
+
+    // a stop holds the machine, paced, until the window asks to go on, to step one instruction or to clear the debugger
+    Debugger debugger;
+
+    // the input as it is applied, with checkpoints, until the window closes or the machine is rewound or loaded
+    std::string movieFile;
+    Movie movie;
+
+    // counted from when the window shows it, painted into the frames it is shown with
+    Heatmap heatmap;
+
+    TripleBuffer<Frame> frames;
+    SpscQueue<QueuedInput, 256> inputs;
+    std::atomic<bool> warp = false;
+    std::atomic<bool> saveRequested = false;
+    std::atomic<bool> loadRequested = false;
+    std::atomic<bool> rewinding = false;
+    std::atomic<bool> resumeRequested = false;
+    std::atomic<bool> stepRequested = false;
+    std::atomic<bool> clearRequested = false;
+    std::atomic<bool> heatmapShown = false;
+    std::atomic<bool> stop = false;
+};
+
+// false when a device page is already taken
+bool attachDevices (Emulation&);
+
+StateDevices stateDevices (Emulation&);
+
+// false, with a message, when the state file cannot be written, read or loaded
+bool saveStateFile (Emulation&);
+bool loadStateFile (Emulation&);
+
+// runs frames until stop is set, each one 1/framesPerSecond seconds of emulated time with the input sent before it,
+// paced to real time and published every frame, or as fast as the host goes and published every warpPresentInterval frames
+void emulate (Emulation&);
+
+
+
+#endif //EMULATION_H
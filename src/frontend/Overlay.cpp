@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "Overlay.h"
+
+
+void recordPresent (Overlay& overlay, const Frame& frame, std::chrono::steady_clock::time_point presented) {
+    if (frame.inputSent != std::chrono::steady_clock::time_point {}) {
+        overlay.latency = std::chrono::duration<double, std::milli>(presented - frame.inputSent).count();
+    }
+
+    overlay.rewindSeconds = static_cast<double>(frame.rewindFrames) / framesPerSecond;
+    overlay.rewindMegabytes = frame.rewindBytes / 1048576.0;
+    overlay.rewindShare = frame.rewindShare;
+    overlay.runAhead = frame.runAhead;
+    overlay.aheadBusy = frame.aheadBusy;
+    overlay.aheadMissed = frame.aheadMissed;
+    overlay.stopped = frame.stopped;
+    overlay.stop = frame.stop;
+
+    if (overlay.secondStart == std::chrono::steady_clock::time_point {} || frame.warp != overlay.warp) {
+        overlay.secondStart = presented;
+        overlay.secondFirstFrame = frame.number;
+        overlay.secondJitter = {};
+        overlay.warp = frame.warp;
+        return;
+    }
+
+    overlay.secondJitter = std::max(overlay.secondJitter, frame.lateness);
+
+    const auto elapsed = std::chrono::duration<double>(presented - overlay.secondStart).count();
+
+    if (elapsed >= 1.0) {
+        overlay.jitter = std::chrono::duration<double, std::milli>(overlay.secondJitter).count();
+        overlay.speed = (frame.number - overlay.secondFirstFrame) / (elapsed * framesPerSecond);
+
+        overlay.secondStart = presented;
+        overlay.secondFirstFrame = frame.number;
+        overlay.secondJitter = {};
+    }
+}
+
+std::string formatOverlay (const Overlay& overlay) {
+    char line[400];
+    int length;
+
+    if (overlay.warp) {
+        length = snprintf(line, sizeof(line), "warp %.1fx, latency %.1f ms", overlay.speed, overlay.latency);
+    } else {
+        length = snprintf(line, sizeof(line), "paced %.2fx, latency %.1f ms, jitter %.3f ms", overlay.speed, overlay.latency, overlay.jitter);
+    }
+
+    length += snprintf(
+        line + length, sizeof(line) - length, "\nrewind %.1f s in %.1f MiB, recorded in %.1f%% of emulation time",
+        overlay.rewindSeconds, overlay.rewindMegabytes, 100 * overlay.rewindShare
+    );
+
+    if (overlay.runAhead != 0) {
+        length += snprintf(
+            line + length, sizeof(line) - length, "\nrun-ahead %u frames in %.0f%% of a frame, %s%llu missed",
+            overlay.runAhead, 100 * overlay.aheadBusy, overlay.aheadBusy > 1 ? "cannot keep up, " : "",
+            static_cast<unsigned long long>(overlay.aheadMissed)
+        );
+    }
+
+    if (overlay.stopped) {
+        snprintf(line + length, sizeof(line) - length, "\n%s, F6 goes on, F7 steps, F8 clears", formatStop(overlay.stop).c_str());
+    }
+
+    return line;
+}
@@ -0,0 +1,44 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "Emulation.h"
+
+
+
+// what the window shows in its corner, gathered from the frames as they are presented
+struct Overlay {
+    // from the key event to the end of the swap that first showed a frame run with it, for the latest input
+    double latency = 0;
+
+    // over the last whole second, the emulation's worst wake-up past a deadline and its speed against real time
+    double jitter = 0;
+    double speed = 0;
+    bool warp = false;
+
+    double rewindSeconds = 0;
+    double rewindMegabytes = 0;
+    double rewindShare = 0;
+
+    uint32_t runAhead = 0;
+    double aheadBusy = 0;
+    uint64_t aheadMissed = 0;
+
+    bool stopped = false;
+    DebugStop stop;
+
+    std::chrono::steady_clock::time_point secondStart {};
+    uint64_t secondFirstFrame = 0;
+    std::chrono::steady_clock::duration secondJitter {};
+};
+
+void recordPresent (Overlay&, const Frame&, std::chrono::steady_clock::time_point presented);
+
+std::string formatOverlay (const Overlay&);
+
+
+
+#endif //OVERLAY_H
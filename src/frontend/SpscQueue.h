@@ -0,0 +1,52 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+
+
+// a ring for one producer thread and one consumer thread, head and tail only ever grow
+template <typename T, size_t Capacity>
+struct SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "the capacity has to be a power of two");
+
+    std::array<T, Capacity> items {};
+
+    // written by the consumer and the producer alone, on lines of their own
+    alignas(64) std::atomic<size_t> head = 0;
+    alignas(64) std::atomic<size_t> tail = 0;
+};
+
+// false when the queue is full, the producer never waits
+template <typename T, size_t Capacity>
+bool push (SpscQueue<T, Capacity>& queue, const T& item) {
+    const auto tail = queue.tail.load(std::memory_order_relaxed);
+
+    if (tail - queue.head.load(std::memory_order_acquire) == Capacity) {
+        return false;
+    }
+
+    queue.items[tail & (Capacity - 1)] = item;
+    queue.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T, size_t Capacity>
+std::optional<T> pop (SpscQueue<T, Capacity>& queue) {
+    const auto head = queue.head.load(std::memory_order_relaxed);
+
+    if (head == queue.tail.load(std::memory_order_acquire)) {
+        return std::nullopt;
+    }
+
+    const auto item = queue.items[head & (Capacity - 1)];
+    queue.head.store(head + 1, std::memory_order_release);
+    return item;
+}
+
+
+
+#endif //SPSCQUEUE_H
@@ -0,0 +1,52 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+
+
+constexpr uint8_t tripleBufferFresh = 0x04;
+
+// one producer fills the back slot while one consumer reads the front one, neither ever waits for the other
+// they only swap their slot with the middle one, which carries tripleBufferFresh while it holds a frame not yet taken
+template <typename T>
+struct TripleBuffer {
+    std::array<T, 3> slots {};
+
+    uint8_t back = 0;
+    uint8_t front = 1;
+    std::atomic<uint8_t> middle = 2;
+};
+
+template <typename T>
+T& backSlot (TripleBuffer<T>& buffer) {
+    return buffer.slots[buffer.back];
+}
+
+template <typename T>
+const T& frontSlot (const TripleBuffer<T>& buffer) {
+    return buffer.slots[buffer.front];
+}
+
+// hands the back slot over, a frame the consumer has not taken yet is overwritten from then on
+template <typename T>
+void publish (TripleBuffer<T>& buffer) {
+    buffer.back = buffer.middle.exchange(buffer.back | tripleBufferFresh, std::memory_order_acq_rel) & 0x03;
+}
+
+// false, keeping the front slot, when nothing was published since the last take
+template <typename T>
+bool takeNewest (TripleBuffer<T>& buffer) {
+    if ((buffer.middle.load(std::memory_order_relaxed) & tripleBufferFresh) == 0) {
+        return false;
+    }
+
+    buffer.front = buffer.middle.exchange(buffer.front, std::memory_order_acq_rel) & 0x03;
+    return true;
+}
+
+
+
+#endif //TRIPLEBUFFER_H
@@ -0,0 +1,45 @@
+#include <cstring>
+
+#if HAUSTIER_JIT
+#include <sys/mman.h>
+#endif
+
+#include "CodeBuffer.h"
+
+
+constexpr size_t codeBufferSize = 4 << 20;
+
+CodeBuffer::~CodeBuffer () {
+#if HAUSTIER_JIT
+    if (memory != nullptr) {
+        munmap(memory, capacity);
+    }
+#endif
+}
+
+uint8_t* append (CodeBuffer& buffer, const uint8_t* code, size_t size) {
+#if HAUSTIER_JIT
+    if (buffer.memory == nullptr) {
+        void* memory = mmap(nullptr, codeBufferSize, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (memory == MAP_FAILED) {
+            return nullptr;
+        }
+
+        buffer.memory = static_cast<uint8_t*>(memory);
+        buffer.capacity = codeBufferSize;
+    }
+
+    if (buffer.used + size > buffer.capacity) {
+        return nullptr;
+    }
+
+    auto* start = buffer.memory + buffer.used;
+    memcpy(start, code, size);
+    buffer.used += size;
+
+    return start;
+#else
+    return nullptr;
+#endif
+}
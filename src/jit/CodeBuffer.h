@@ -0,0 +1,26 @@
+#ifndef CODEBUFFER_H
+#define CODEBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+
+
+
+// executable memory for recompiled blocks, mapped on first use and only ever appended to
+struct CodeBuffer {
+    uint8_t* memory = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+
+    CodeBuffer () = default;
+    CodeBuffer (const CodeBuffer&) = delete;
+    CodeBuffer& operator= (const CodeBuffer&) = delete;
+    ~CodeBuffer ();
+};
+
+// null when the buffer cannot be mapped or is full
+uint8_t* append (CodeBuffer&, const uint8_t* code, size_t size);
+
+
+
+#endif //CODEBUFFER_H
@@ -0,0 +1,922 @@
+#if HAUSTIER_JIT
+
+#include <cstdio>
+#include <memory>
+
+#include "assembler/opcodes.h"
+#include "emulator/cpu.h"
+#include "emulator/instructions.h"
+
+#include "jit.h"
+#include "x64.h"
+
+
+using namespace x64;
+
+// 6502 state pinned for the whole block, all callee-saved so helper calls keep them
+constexpr Reg regA = RBX;
+constexpr Reg regX = R12;
+constexpr Reg regY = R13;
+constexpr Reg regP = RBP;
+constexpr Reg regMachine = R14;
+constexpr Reg regMemory = R15;
+
+constexpr uint8_t flagsNZCV = FlagN | FlagZ | FlagC | FlagV;
+
+struct Offsets {
+    int32_t a;
+    int32_t x;
+    int32_t y;
+    int32_t sp;
+    int32_t p;
+    int32_t pc;
+    int32_t cycles;
+    int32_t instructions;
+    int32_t memory;
+    int32_t readPages;
+    int32_t writePages;
+};
+
+Offsets offsetsOf (const Machine& machine) {
+    const auto offset = [&machine] (const void* field) {
+        return static_cast<int32_t>(static_cast<const uint8_t*>(field) - reinterpret_cast<const uint8_t*>(&machine));
+    };
+
+    return {
+        offset(&machine.cpu.a),
+        offset(&machine.cpu.x),
+        offset(&machine.cpu.y),
+        offset(&machine.cpu.sp),
+        offset(&machine.cpu.p),
+        offset(&machine.cpu.pc),
+        offset(&machine.cycles),
+        offset(&machine.instructions),
+        offset(machine.memory.data()),
+        offset(machine.bus.readPages.data()),
+        offset(machine.bus.writePages.data()),
+    };
+}
+
+// blocks count their cycles on the way out, devices are shown the cycles the block has run so far
+uint32_t jitRead (Machine* machine, uint32_t address, uint32_t elapsed) {
+    machine->cycles += elapsed;
+    const auto value = readSlow(*machine, address);
+    machine->cycles -= elapsed;
+
+    return value;
+}
+
+// whether the block has to stop after the store
+uint32_t jitWrote (Machine* machine, uint32_t address, uint32_t elapsed) {
+    machine->cycles += elapsed;
+    wroteSlow(*machine, address);
+    machine->cycles -= elapsed;
+
+    const auto leave = machine->blockCache.leave;
+    machine->blockCache.leave = false;
+
+    return leave;
+}
+
+void jitAdc (Machine* machine, uint32_t value) {
+    adc<EagerFlags>(machine->cpu, value);
+}
+
+void jitSbc (Machine* machine, uint32_t value) {
+    sbc<EagerFlags>(machine->cpu, value);
+}
+
+uint8_t flagsRead (Instruction instruction) {
+    switch (instruction) {
+        case Instruction::ADC: [[fallthrough]];
+        case Instruction::SBC: [[fallthrough]];
+        case Instruction::ROL: [[fallthrough]];
+        case Instruction::ROR: [[fallthrough]];
+        case Instruction::BCC: [[fallthrough]];
+        case Instruction::BCS: return FlagC;
+        case Instruction::BEQ: [[fallthrough]];
+        case Instruction::BNE: return FlagZ;
+        case Instruction::BMI: [[fallthrough]];
+        case Instruction::BPL: return FlagN;
+        case Instruction::BVC: [[fallthrough]];
+        case Instruction::BVS: return FlagV;
+        case Instruction::PHP: return flagsNZCV;
+        default: return 0;
+    }
+}
+
+uint8_t flagsWritten (Instruction instruction) {
+    switch (instruction) {
+        case Instruction::ADC: [[fallthrough]];
+        case Instruction::SBC: [[fallthrough]];
+        case Instruction::PLP: return flagsNZCV;
+        case Instruction::ASL: [[fallthrough]];
+        case Instruction::LSR: [[fallthrough]];
+        case Instruction::ROL: [[fallthrough]];
+        case Instruction::ROR: [[fallthrough]];
+        case Instruction::CMP: [[fallthrough]];
+        case Instruction::CPX: [[fallthrough]];
+        case Instruction::CPY: return FlagN | FlagZ | FlagC;
+        case Instruction::BIT: return FlagN | FlagZ | FlagV;
+        case Instruction::CLC: [[fallthrough]];
+        case Instruction::SEC: return FlagC;
+        case Instruction::CLV: return FlagV;
+        case Instruction::AND: [[fallthrough]];
+        case Instruction::DEC: [[fallthrough]];
+        case Instruction::DEX: [[fallthrough]];
+        case Instruction::DEY: [[fallthrough]];
+        case Instruction::EOR: [[fallthrough]];
+        case Instruction::INC: [[fallthrough]];
+        case Instruction::INX: [[fallthrough]];
+        case Instruction::INY: [[fallthrough]];
+        case Instruction::LDA: [[fallthrough]];
+        case Instruction::LDX: [[fallthrough]];
+        case Instruction::LDY: [[fallthrough]];
+        case Instruction::ORA: [[fallthrough]];
+        case Instruction::PLA: [[fallthrough]];
+        case Instruction::TAX: [[fallthrough]];
+        case Instruction::TAY: [[fallthrough]];
+        case Instruction::TSX: [[fallthrough]];
+        case Instruction::TXA: [[fallthrough]];
+        case Instruction::TYA: return FlagN | FlagZ;
+        default: return 0;
+    }
+}
+
+bool writesMemory (Instruction instruction, AddressingMode mode) {
+    switch (instruction) {
+        case Instruction::STA: [[fallthrough]];
+        case Instruction::STX: [[fallthrough]];
+        case Instruction::STY: return true;
+        case Instruction::ASL: [[fallthrough]];
+        case Instruction::LSR: [[fallthrough]];
+        case Instruction::ROL: [[fallthrough]];
+        case Instruction::ROR: [[fallthrough]];
+        case Instruction::INC: [[fallthrough]];
+        case Instruction::DEC: return mode != AddressingMode::Accumulator;
+        default: return false;
+    }
+}
+
+bool hasConstantAddress (AddressingMode mode) {
+    return mode == AddressingMode::Absolute || mode == AddressingMode::ZeroPage;
+}
+
+struct Item {
+    OpcodeInfo info;
+    uint16_t pc;
+    uint16_t operand;
+    uint16_t nextPc;
+    uint8_t cycles;
+
+    // flags this instruction has to produce because something reads them before they are overwritten
+    uint8_t liveWrites;
+
+    // a computed store may land inside this very block or on a device, which ends the block right after it
+    bool mayExit;
+};
+
+struct Compiler {
+    Emitter emitter;
+    Offsets offsets;
+    const Block& block;
+    std::vector<Item> items;
+
+    // computed loads only check their page when some device handles reads
+    bool checkReads;
+
+    // cycles of the instructions ahead of the one being compiled
+    uint32_t elapsed = 0;
+
+    Mem cpuField (int32_t offset) const { return at(regMachine, offset); }
+
+    void prologue () {
+        for (const auto reg : { RBX, RBP, R12, R13, R14, R15 }) {
+            emitter.push(reg);
+        }
+
+        // six pushes and the return address leave rsp 8 bytes short of the alignment calls need
+        emitter.subRsp(8);
+        emitter.movR64(regMachine, RDI);
+        emitter.lea64(regMemory, at(regMachine, offsets.memory));
+
+        emitter.movzx8(regA, cpuField(offsets.a));
+        emitter.movzx8(regX, cpuField(offsets.x));
+        emitter.movzx8(regY, cpuField(offsets.y));
+        emitter.movzx8(regP, cpuField(offsets.p));
+    }
+
+    // pc has already been stored, the counters cover the first `done` instructions
+    void exit (size_t done) {
+        uint32_t cycles = 0;
+
+        for (size_t index = 0; index < done; index++) {
+            cycles += items[index].cycles;
+        }
+
+        emitter.movMR8(cpuField(offsets.a), regA);
+        emitter.movMR8(cpuField(offsets.x), regX);
+        emitter.movMR8(cpuField(offsets.y), regY);
+        emitter.movRR(RAX, regP);
+        emitter.movMR8(cpuField(offsets.p), RAX);
+
+        emitter.addMI64(cpuField(offsets.cycles), cycles);
+        emitter.addMI64(cpuField(offsets.instructions), done);
+
+        emitter.addRsp(8);
+
+        for (const auto reg : { R15, R14, R13, R12, RBP, RBX }) {
+            emitter.pop(reg);
+        }
+
+        emitter.ret();
+    }
+
+    void storePc (uint16_t pc) {
+        emitter.movRI(RAX, pc);
+        emitter.movMR16(cpuField(offsets.pc), RAX);
+    }
+
+    void callHelper (const void* helper) {
+        emitter.movR64(RDI, regMachine);
+        emitter.movRI64(RAX, reinterpret_cast<uint64_t>(helper));
+        emitter.call(RAX);
+    }
+
+    // setcc into scratch registers first, merging into P clobbers the host flags
+    void captureFlags (uint8_t mask, Cond carry = C) {
+        if (mask & FlagC) {
+            emitter.setcc(carry, RCX);
+        }
+        if (mask & FlagV) {
+            emitter.setcc(O, R8);
+        }
+        if (mask & FlagN) {
+            emitter.setcc(S, R9);
+        }
+        if (mask & FlagZ) {
+            emitter.setcc(Z, R10);
+        }
+    }
+
+    void mergeFlags (uint8_t mask) {
+        if (mask == 0) {
+            return;
+        }
+
+        emitter.aluI(AND, regP, ~mask);
+
+        const std::pair<uint8_t, Reg> sources[] { { FlagC, RCX }, { FlagZ, R10 }, { FlagV, R8 }, { FlagN, R9 } };
+
+        for (const auto& [flag, reg] : sources) {
+            if (mask & flag) {
+                emitter.movzx8(reg, reg);
+
+                if (flag != FlagC) {
+                    emitter.shiftI(SHL, reg, __builtin_ctz(flag));
+                }
+
+                emitter.alu(OR, regP, reg);
+            }
+        }
+    }
+
+    void setNZ (Reg value, uint8_t mask) {
+        mask &= FlagN | FlagZ;
+
+        if (mask != 0) {
+            emitter.test8(value, value);
+            captureFlags(mask);
+            mergeFlags(mask);
+        }
+    }
+
+    // the operand of an indexed or indirect mode ends up in eax, constant addresses are folded in
+    Mem memoryOperand (AddressingMode mode, uint16_t operand) {
+        switch (mode) {
+            case AddressingMode::Absolute: [[fallthrough]];
+            case AddressingMode::ZeroPage:
+                return at(regMemory, operand);
+
+            case AddressingMode::ZeroPageX: [[fallthrough]];
+            case AddressingMode::ZeroPageY:
+                emitter.lea(RAX, at(mode == AddressingMode::ZeroPageX ? regX : regY, operand));
+                emitter.movzx8(RAX, RAX);
+                break;
+
+            case AddressingMode::AbsoluteX: [[fallthrough]];
+            case AddressingMode::AbsoluteY:
+                emitter.lea(RAX, at(mode == AddressingMode::AbsoluteX ? regX : regY, operand));
+                emitter.movzx16(RAX, RAX);
+                break;
+
+            case AddressingMode::Indirect: {
+                const uint16_t high = (operand & 0xff00) | ((operand + 1) & 0x00ff);
+                emitter.movzx8(RAX, at(regMemory, operand));
+                emitter.movzx8(RDX, at(regMemory, high));
+                emitter.shiftI(SHL, RDX, 8);
+                emitter.alu(OR, RAX, RDX);
+                break;
+            }
+
+            case AddressingMode::IndirectX:
+                emitter.lea(RCX, at(regX, operand));
+                emitter.movzx8(RCX, RCX);
+                emitter.movzx8(RAX, at(regMemory, RCX));
+                emitter.lea(RDX, at(RCX, 1));
+                emitter.movzx8(RDX, RDX);
+                emitter.movzx8(RDX, at(regMemory, RDX));
+                emitter.shiftI(SHL, RDX, 8);
+                emitter.alu(OR, RAX, RDX);
+                break;
+
+            case AddressingMode::IndirectY:
+                emitter.movzx8(RAX, at(regMemory, operand));
+                emitter.movzx8(RDX, at(regMemory, (operand + 1) & 0xff));
+                emitter.shiftI(SHL, RDX, 8);
+                emitter.alu(OR, RAX, RDX);
+                emitter.alu(ADD, RAX, regY);
+                emitter.movzx16(RAX, RAX);
+                break;
+
+            default:
+                break;
+        }
+
+        return at(regMemory, RAX);
+    }
+
+    // edx, constant addresses are never on a device page, compilable leaves those to the interpreter
+    void load (const Mem& mem) {
+        if (!checkReads || mem.index == noIndex) {
+            emitter.movzx8(RDX, mem);
+            return;
+        }
+
+        emitter.movRR(RCX, RAX);
+        emitter.shiftI(SHR, RCX, 8);
+        emitter.cmpMI64(at(regMachine, RCX, offsets.readPages, 3), 0);
+        const auto toDevice = emitter.jcc(Z);
+        emitter.movzx8(RDX, mem);
+        const auto done = emitter.jmp();
+
+        // the address outlives the call in the alignment slot
+        emitter.patch(toDevice, emitter.size());
+        emitter.movMR32(at(RSP, 0), RAX);
+        emitter.movRR(RSI, RAX);
+        emitter.movRI(RDX, elapsed);
+        callHelper(reinterpret_cast<const void*>(&jitRead));
+        emitter.movzx8(RDX, RAX);
+        emitter.movzx16(RAX, at(RSP, 0));
+        emitter.patch(done, emitter.size());
+    }
+
+    // operand value into edx
+    void fetch (AddressingMode mode, uint16_t operand) {
+        if (mode == AddressingMode::Immediate) {
+            emitter.movRI(RDX, operand);
+        } else {
+            load(memoryOperand(mode, operand));
+        }
+    }
+
+    // after a store through `mem` to a page off the fast path, lets its device and the block cache see it
+    void wrote (const Mem& mem, size_t index) {
+        const auto& item = items[index];
+
+        if (mem.index == noIndex) {
+            const uint16_t address = mem.disp;
+
+            emitter.cmpMI64(cpuField(offsets.writePages + (address >> 8) * 8), 0);
+            const auto skip = emitter.jcc(NZ);
+            emitter.movRI(RSI, address);
+            emitter.movRI(RDX, elapsed);
+            callHelper(reinterpret_cast<const void*>(&jitWrote));
+            emitter.patch(skip, emitter.size());
+            return;
+        }
+
+        emitter.movRR(RCX, RAX);
+        emitter.shiftI(SHR, RCX, 8);
+        emitter.cmpMI64(at(regMachine, RCX, offsets.writePages, 3), 0);
+        const auto skip = emitter.jcc(NZ);
+
+        emitter.movRR(RSI, RAX);
+        emitter.movRI(RDX, elapsed);
+        callHelper(reinterpret_cast<const void*>(&jitWrote));
+
+        if (!item.mayExit) {
+            emitter.patch(skip, emitter.size());
+            return;
+        }
+
+        // the rest of this block may be stale now, or a device moved the deadline in, leave right after the store
+        emitter.test8(RAX, RAX);
+        const auto stay = emitter.jcc(Z);
+        storePc(item.nextPc);
+        exit(index + 1);
+
+        emitter.patch(skip, emitter.size());
+        emitter.patch(stay, emitter.size());
+    }
+
+    void push (Reg value) {
+        emitter.movzx8(RCX, cpuField(offsets.sp));
+        emitter.movMR8(at(regMemory, RCX, 0x0100), value);
+        emitter.lea(RAX, at(RCX, 0x0100));
+        emitter.dec8(RCX);
+        emitter.movMR8(cpuField(offsets.sp), RCX);
+    }
+
+    // edx
+    void pull () {
+        emitter.movzx8(RCX, cpuField(offsets.sp));
+        emitter.inc8(RCX);
+        emitter.movMR8(cpuField(offsets.sp), RCX);
+        emitter.movzx8(RDX, at(regMemory, RCX, 0x0100));
+    }
+
+    void decimalHelper (const void* helper) {
+        emitter.movMR8(cpuField(offsets.a), regA);
+        emitter.movRR(RAX, regP);
+        emitter.movMR8(cpuField(offsets.p), RAX);
+        emitter.movRR(RSI, RDX);
+        callHelper(helper);
+        emitter.movzx8(regA, cpuField(offsets.a));
+        emitter.movzx8(regP, cpuField(offsets.p));
+    }
+
+    // dispatches to the binary path unless D is set
+    template <typename Binary>
+    void arithmetic (const void* decimal, Binary binary) {
+        emitter.testI(regP, FlagD);
+        const auto toDecimal = emitter.jcc(NZ);
+        binary();
+        const auto done = emitter.jmp();
+        emitter.patch(toDecimal, emitter.size());
+        decimalHelper(decimal);
+        emitter.patch(done, emitter.size());
+    }
+
+    void branch (const Item& item, uint8_t flag, bool whenSet) {
+        emitter.movRI(RAX, item.nextPc);
+        emitter.movRI(RDX, static_cast<uint16_t>(item.nextPc + static_cast<int8_t>(item.operand)));
+        emitter.testI(regP, flag);
+        emitter.cmov(whenSet ? NZ : Z, RAX, RDX);
+        emitter.movMR16(cpuField(offsets.pc), RAX);
+    }
+
+    template <typename Op>
+    void readModifyWrite (const Item& item, size_t index, Op op) {
+        if (item.info.mode == AddressingMode::Accumulator) {
+            op(regA);
+            return;
+        }
+
+        const auto mem = memoryOperand(item.info.mode, item.operand);
+        load(mem);
+        op(RDX);
+        emitter.movMR8(mem, RDX);
+        wrote(mem, index);
+    }
+
+    void shift (Shift kind, Reg value, uint8_t live) {
+        const auto rotates = kind == RCL || kind == RCR;
+
+        if (rotates) {
+            emitter.bt(regP, 0);
+        }
+
+        emitter.shift8(kind, value);
+
+        if (rotates) {
+            // rcl and rcr leave SF and ZF alone
+            captureFlags(live & FlagC);
+            emitter.test8(value, value);
+            captureFlags(live & (FlagN | FlagZ));
+        } else {
+            captureFlags(live);
+        }
+
+        mergeFlags(live);
+    }
+
+    // false when the instruction ends the block, pc has then been stored
+    bool instruction (size_t index) {
+        const auto& item = items[index];
+        const auto mode = item.info.mode;
+        const auto live = item.liveWrites;
+
+        switch (item.info.instruction) {
+            case Instruction::ADC:
+                fetch(mode, item.operand);
+                arithmetic(reinterpret_cast<const void*>(&jitAdc), [&] {
+                    emitter.bt(regP, 0);
+                    emitter.alu8(ADC, regA, RDX);
+                    captureFlags(live);
+                    mergeFlags(live);
+                });
+                break;
+
+            case Instruction::SBC:
+                fetch(mode, item.operand);
+                arithmetic(reinterpret_cast<const void*>(&jitSbc), [&] {
+                    emitter.bt(regP, 0);
+                    emitter.cmc();
+                    emitter.alu8(SBB, regA, RDX);
+                    captureFlags(live, NC);
+                    mergeFlags(live);
+                });
+                break;
+
+            case Instruction::AND: [[fallthrough]];
+            case Instruction::ORA: [[fallthrough]];
+            case Instruction::EOR: {
+                const auto kind = item.info.instruction == Instruction::AND ? AND : item.info.instruction == Instruction::ORA ? OR : XOR;
+                fetch(mode, item.operand);
+                emitter.alu8(kind, regA, RDX);
+                captureFlags(live);
+                mergeFlags(live);
+                break;
+            }
+
+            case Instruction::CMP: [[fallthrough]];
+            case Instruction::CPX: [[fallthrough]];
+            case Instruction::CPY: {
+                const auto reg = item.info.instruction == Instruction::CMP ? regA : item.info.instruction == Instruction::CPX ? regX : regY;
+                fetch(mode, item.operand);
+                emitter.alu8(CMP, reg, RDX);
+                captureFlags(live, NC);
+                mergeFlags(live);
+                break;
+            }
+
+            case Instruction::BIT:
+                fetch(mode, item.operand);
+                emitter.test8(regA, RDX);
+                captureFlags(live & FlagZ);
+                mergeFlags(live & FlagZ);
+
+                if (live & (FlagN | FlagV)) {
+                    emitter.aluI(AND, regP, ~(live & (FlagN | FlagV)));
+                    emitter.aluI(AND, RDX, live & (FlagN | FlagV));
+                    emitter.alu(OR, regP, RDX);
+                }
+                break;
+
+            case Instruction::ASL:
+                readModifyWrite(item, index, [&] (Reg value) { shift(SHL, value, live); });
+                break;
+
+            case Instruction::LSR:
+                readModifyWrite(item, index, [&] (Reg value) { shift(SHR, value, live); });
+                break;
+
+            case Instruction::ROL:
+                readModifyWrite(item, index, [&] (Reg value) { shift(RCL, value, live); });
+                break;
+
+            case Instruction::ROR:
+                readModifyWrite(item, index, [&] (Reg value) { shift(RCR, value, live); });
+                break;
+
+            case Instruction::INC:
+                readModifyWrite(item, index, [&] (Reg value) {
+                    emitter.inc8(value);
+                    captureFlags(live);
+                    mergeFlags(live);
+                });
+                break;
+
+            case Instruction::DEC:
+                readModifyWrite(item, index, [&] (Reg value) {
+                    emitter.dec8(value);
+                    captureFlags(live);
+                    mergeFlags(live);
+                });
+                break;
+
+            case Instruction::INX: [[fallthrough]];
+            case Instruction::INY: [[fallthrough]];
+            case Instruction::DEX: [[fallthrough]];
+            case Instruction::DEY: {
+                const auto instruction = item.info.instruction;
+                const auto reg = instruction == Instruction::INX || instruction == Instruction::DEX ? regX : regY;
+
+                if (instruction == Instruction::INX || instruction == Instruction::INY) {
+                    emitter.inc8(reg);
+                } else {
+                    emitter.dec8(reg);
+                }
+
+                captureFlags(live);
+                mergeFlags(live);
+                break;
+            }
+
+            case Instruction::LDA: [[fallthrough]];
+            case Instruction::LDX: [[fallthrough]];
+            case Instruction::LDY: {
+                const auto reg = item.info.instruction == Instruction::LDA ? regA : item.info.instruction == Instruction::LDX ? regX : regY;
+                fetch(mode, item.operand);
+                emitter.movRR(reg, RDX);
+                setNZ(reg, live);
+                break;
+            }
+
+            case Instruction::STA: [[fallthrough]];
+            case Instruction::STX: [[fallthrough]];
+            case Instruction::STY: {
+                const auto reg = item.info.instruction == Instruction::STA ? regA : item.info.instruction == Instruction::STX ? regX : regY;
+                const auto mem = memoryOperand(mode, item.operand);
+                emitter.movMR8(mem, reg);
+                wrote(mem, index);
+                break;
+            }
+
+            case Instruction::TAX: [[fallthrough]];
+            case Instruction::TAY: [[fallthrough]];
+            case Instruction::TXA: [[fallthrough]];
+            case Instruction::TYA: {
+                const auto instruction = item.info.instruction;
+                const auto dst = instruction == Instruction::TAX ? regX : instruction == Instruction::TAY ? regY : regA;
+                const auto src = instruction == Instruction::TXA ? regX : instruction == Instruction::TYA ? regY : regA;
+                emitter.movRR(dst, src);
+                setNZ(dst, live);
+                break;
+            }
+
+            case Instruction::TSX:
+                emitter.movzx8(regX, cpuField(offsets.sp));
+                setNZ(regX, live);
+                break;
+
+            case Instruction::TXS:
+                emitter.movMR8(cpuField(offsets.sp), regX);
+                break;
+
+            case Instruction::CLC: emitter.aluI(AND, regP, ~FlagC); break;
+            case Instruction::SEC: emitter.aluI(OR, regP, FlagC); break;
+            case Instruction::CLD: emitter.aluI(AND, regP, ~FlagD); break;
+            case Instruction::SED: emitter.aluI(OR, regP, FlagD); break;
+            case Instruction::CLI: emitter.aluI(AND, regP, ~FlagI); break;
+            case Instruction::SEI: emitter.aluI(OR, regP, FlagI); break;
+            case Instruction::CLV: emitter.aluI(AND, regP, ~FlagV); break;
+            case Instruction::NOP: break;
+
+            case Instruction::PHA:
+                push(regA);
+                wrote(at(regMemory, RAX), index);
+                break;
+
+            case Instruction::PHP:
+                emitter.movRR(RDX, regP);
+                emitter.aluI(OR, RDX, FlagB | FlagU);
+                push(RDX);
+                wrote(at(regMemory, RAX), index);
+                break;
+
+            case Instruction::PLA:
+                pull();
+                emitter.movRR(regA, RDX);
+                setNZ(regA, live);
+                break;
+
+            case Instruction::PLP:
+                pull();
+                emitter.aluI(AND, RDX, ~FlagB);
+                emitter.aluI(OR, RDX, FlagU);
+                emitter.movRR(regP, RDX);
+                break;
+
+            case Instruction::BCC: branch(item, FlagC, false); return false;
+            case Instruction::BCS: branch(item, FlagC, true); return false;
+            case Instruction::BEQ: branch(item, FlagZ, true); return false;
+            case Instruction::BMI: branch(item, FlagN, true); return false;
+            case Instruction::BNE: branch(item, FlagZ, false); return false;
+            case Instruction::BPL: branch(item, FlagN, false); return false;
+            case Instruction::BVC: branch(item, FlagV, false); return false;
+            case Instruction::BVS: branch(item, FlagV, true); return false;
+
+            case Instruction::JMP:
+                if (mode == AddressingMode::Absolute) {
+                    storePc(item.operand);
+                } else {
+                    memoryOperand(mode, item.operand);
+                    emitter.movMR16(cpuField(offsets.pc), RAX);
+                }
+                return false;
+
+            case Instruction::JSR: {
+                const uint16_t returnAddress = item.nextPc - 1;
+                emitter.movRI(RDX, returnAddress >> 8);
+                push(RDX);
+                wrote(at(regMemory, RAX), index);
+                emitter.movRI(RDX, returnAddress & 0xff);
+                push(RDX);
+                wrote(at(regMemory, RAX), index);
+                storePc(item.operand);
+                return false;
+            }
+
+            case Instruction::RTS:
+                pull();
+                emitter.movRR(RSI, RDX);
+                pull();
+                emitter.shiftI(SHL, RDX, 8);
+                emitter.alu(OR, RDX, RSI);
+                emitter.aluI(ADD, RDX, 1);
+                emitter.movMR16(cpuField(offsets.pc), RDX);
+                return false;
+
+            default:
+                break;
+        }
+
+        return true;
+    }
+};
+
+bool compilable (const Machine& machine, const Item& item, const Block& block) {
+    if (!item.info.valid) {
+        return false;
+    }
+
+    // loads from a device page at a known address stay in the interpreter, only computed ones are checked
+    const auto mode = item.info.mode;
+
+    if ((hasConstantAddress(mode) || mode == AddressingMode::Indirect) && machine.bus.readPages[item.operand >> 8] == nullptr) {
+        return false;
+    }
+
+    // interrupt entry and return stay in the interpreter
+    if (item.info.instruction == Instruction::BRK || item.info.instruction == Instruction::RTI) {
+        return false;
+    }
+
+    // a store that provably lands inside the block or on a device would need the block to end mid-way
+    if (writesMemory(item.info.instruction, item.info.mode) && hasConstantAddress(item.info.mode)) {
+        return (item.operand < block.start || item.operand > block.end) && machine.bus.mappings[item.operand >> 8].write == nullptr;
+    }
+
+    return true;
+}
+
+void compileBlock (Machine& machine, Block& block) {
+    // pushes and zero page stores would be able to overwrite code in the first two pages
+    if (block.start < 0x0200) {
+        return;
+    }
+
+    // the recompiler knows the documented NMOS set, the 65C02 differs even in some of those opcodes
+    if (machine.variant == CpuVariant::Cmos) {
+        return;
+    }
+
+    Compiler compiler { {}, offsetsOf(machine), block, {}, machine.bus.hasDeviceReads };
+    auto& items = compiler.items;
+    uint16_t pc = block.start;
+
+    for (const auto& decoded : block.instructions) {
+        const Item item { Nmos6502::infos[peekByte(machine, pc)], pc, decoded.operand, decoded.nextPc, decoded.cycles, 0, false };
+
+        if (!compilable(machine, item, block)) {
+            return;
+        }
+
+        items.push_back(item);
+        pc = decoded.nextPc;
+    }
+
+    // every flag is live when the block ends and right after any store that may end it early
+    uint8_t live = flagsNZCV;
+
+    for (auto index = items.size(); index-- > 0;) {
+        auto& item = items[index];
+        const auto instruction = item.info.instruction;
+
+        item.mayExit = writesMemory(instruction, item.info.mode) && !hasConstantAddress(item.info.mode);
+
+        if (item.mayExit) {
+            live = flagsNZCV;
+        }
+
+        item.liveWrites = flagsWritten(instruction) & live;
+        live = (live & ~flagsWritten(instruction)) | flagsRead(instruction);
+    }
+
+    compiler.prologue();
+
+    auto fellThrough = true;
+
+    for (size_t index = 0; index < items.size() && fellThrough; index++) {
+        fellThrough = compiler.instruction(index);
+        compiler.elapsed += items[index].cycles;
+    }
+
+    if (fellThrough) {
+        compiler.storePc(items.back().nextPc);
+    }
+
+    compiler.exit(items.size());
+
+    auto& cache = machine.blockCache;
+    auto* code = append(cache.code, compiler.emitter.code.data(), compiler.emitter.size());
+
+    // a full buffer is dropped wholesale, every block starts counting again
+    if (code == nullptr && cache.code.memory != nullptr) {
+        for (auto& cached : cache.blocks) {
+            if (cached) {
+                cached->native = nullptr;
+                cached->executions = 0;
+            }
+        }
+
+        cache.code.used = 0;
+        code = append(cache.code, compiler.emitter.code.data(), compiler.emitter.size());
+    }
+
+    if (code != nullptr) {
+        block.native = reinterpret_cast<NativeBlock>(code);
+        cache.compiledBlocks++;
+    }
+}
+
+std::string describe (const char* name, const Machine& machine) {
+    const auto& cpu = machine.cpu;
+    char line[160];
+
+    snprintf(
+        line, sizeof(line), " %-11s pc=%04x a=%02x x=%02x y=%02x sp=%02x p=%02x cycles=%llu instructions=%llu\n",
+        name, cpu.pc, cpu.a, cpu.x, cpu.y, cpu.sp, cpu.p,
+        static_cast<unsigned long long>(machine.cycles), static_cast<unsigned long long>(machine.instructions)
+    );
+
+    return line;
+}
+
+bool same (const Machine& left, const Machine& right) {
+    const auto& a = left.cpu;
+    const auto& b = right.cpu;
+
+    return a.a == b.a && a.x == b.x && a.y == b.y && a.sp == b.sp && a.p == b.p && a.pc == b.pc &&
+        left.cycles == right.cycles && left.instructions == right.instructions && left.halted == right.halted &&
+        left.memory == right.memory;
+}
+
+std::string diffJit (const std::vector<uint8_t>& program, uint64_t cycleBudget) {
+    const auto jit = std::make_unique<Machine>();
+    const auto interpreter = std::make_unique<Machine>();
+
+    for (auto* machine : { jit.get(), interpreter.get() }) {
+        if (!load(*machine, program)) {
+            return "program does not fit in memory\n";
+        }
+
+        reset(*machine);
+    }
+
+    jit->engine = Engine::Jit;
+    interpreter->engine = Engine::Interpreter;
+
+    while (jit->cycles < cycleBudget && !jit->halted) {
+        const auto blockStart = jit->cpu.pc;
+        const auto before = jit->instructions;
+
+        runBlock(*jit);
+        runInstructions(*interpreter, jit->instructions - before);
+
+        if (!same(*jit, *interpreter)) {
+            char line[80];
+            snprintf(line, sizeof(line), "diverged in the block at $%04x\n", blockStart);
+
+            auto report = std::string(line);
+            report += describe("jit", *jit);
+            report += describe("interpreter", *interpreter);
+
+            for (size_t address = 0; address < jit->memory.size(); address++) {
+                if (jit->memory[address] != interpreter->memory[address]) {
+                    snprintf(
+                        line, sizeof(line), " memory at $%04zx: jit %02x, interpreter %02x\n",
+                        address, jit->memory[address], interpreter->memory[address]
+                    );
+                    report += line;
+                    break;
+                }
+            }
+
+            return report;
+        }
+    }
+
+    char line[120];
+    snprintf(
+        line, sizeof(line), "no divergence in %llu instructions, %llu blocks compiled\n",
+        static_cast<unsigned long long>(jit->instructions),
+        static_cast<unsigned long long>(jit->blockCache.compiledBlocks)
+    );
+
+    return line;
+}
+
+#endif
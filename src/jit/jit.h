@@ -0,0 +1,24 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "emulator/Machine.h"
+
+
+
+// interpreted executions of a block before it is recompiled
+constexpr uint32_t jitThreshold = 16;
+
+// leaves block.native null when the block uses something the recompiler does not handle
+void compileBlock (Machine&, Block&);
+
+// runs the program block by block with the recompiler and instruction by instruction with the interpreter
+// and reports the first point where registers, counters or memory differ
+std::string diffJit (const std::vector<uint8_t>& program, uint64_t cycleBudget);
+
+
+
+#endif //JIT_H
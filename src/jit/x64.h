@@ -0,0 +1,234 @@
+#ifndef X64_H
+#define X64_H
+
+#include <cstdint>
+#include <vector>
+
+
+// just the x86-64 encodings the recompiler needs, always with 32-bit displacements
+namespace x64 {
+
+enum Reg : uint8_t {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15,
+};
+
+enum Cond : uint8_t {
+    O = 0x0, NO = 0x1, C = 0x2, NC = 0x3, Z = 0x4, NZ = 0x5, BE = 0x6, A = 0x7,
+    S = 0x8, NS = 0x9,
+};
+
+enum Alu : uint8_t {
+    ADD = 0, OR = 1, ADC = 2, SBB = 3, AND = 4, SUB = 5, XOR = 6, CMP = 7,
+};
+
+enum Shift : uint8_t {
+    ROL = 0, ROR = 1, RCL = 2, RCR = 3, SHL = 4, SHR = 5,
+};
+
+constexpr int8_t noIndex = -1;
+
+// [base + (index << scale) + disp]
+struct Mem {
+    Reg base;
+    int8_t index;
+    uint8_t scale;
+    int32_t disp;
+};
+
+inline Mem at (Reg base, int32_t disp) {
+    return { base, noIndex, 0, disp };
+}
+
+inline Mem at (Reg base, Reg index, int32_t disp = 0, uint8_t scale = 0) {
+    return { base, static_cast<int8_t>(index), scale, disp };
+}
+
+struct Emitter {
+    std::vector<uint8_t> code;
+
+    size_t size () const { return code.size(); }
+
+    void byte (uint8_t value) { code.push_back(value); }
+
+    void word (uint16_t value) {
+        byte(value);
+        byte(value >> 8);
+    }
+
+    void dword (uint32_t value) {
+        for (auto shift = 0; shift < 32; shift += 8) {
+            byte(value >> shift);
+        }
+    }
+
+    void qword (uint64_t value) {
+        dword(value);
+        dword(value >> 32);
+    }
+
+    // byte registers 4-7 are never used, so a REX prefix is only needed for r8-r15 and 64-bit operands
+    void rex (bool wide, int reg, int index, int base) {
+        const uint8_t bits = (wide << 3) | ((reg >> 3) << 2) | ((index >> 3 & 1) << 1) | (base >> 3);
+
+        if (bits != 0) {
+            byte(0x40 | bits);
+        }
+    }
+
+    void modrm (int mod, int reg, int rm) { byte((mod << 6) | ((reg & 7) << 3) | (rm & 7)); }
+
+    void operand (int reg, Reg rm) { modrm(3, reg, rm); }
+
+    void operand (int reg, const Mem& mem) {
+        if (mem.index == noIndex) {
+            if ((mem.base & 7) == RSP) {
+                modrm(2, reg, RSP);
+                byte(0x24);
+            } else {
+                modrm(2, reg, mem.base);
+            }
+        } else {
+            modrm(2, reg, RSP);
+            byte((mem.scale << 6) | ((mem.index & 7) << 3) | (mem.base & 7));
+        }
+
+        dword(mem.disp);
+    }
+
+    void prefix (bool wide, int reg, Reg rm) { rex(wide, reg, 0, rm); }
+    void prefix (bool wide, int reg, const Mem& mem) { rex(wide, reg, mem.index == noIndex ? 0 : mem.index, mem.base); }
+
+    template <typename Rm>
+    void op (bool wide, std::initializer_list<uint8_t> opcode, int reg, const Rm& rm) {
+        prefix(wide, reg, rm);
+
+        for (const auto part : opcode) {
+            byte(part);
+        }
+
+        operand(reg, rm);
+    }
+
+    void movRR (Reg dst, Reg src) { op(false, { 0x89 }, src, dst); }
+    void movRI (Reg dst, uint32_t imm) {
+        rex(false, 0, 0, dst);
+        byte(0xB8 | (dst & 7));
+        dword(imm);
+    }
+    void movRI64 (Reg dst, uint64_t imm) {
+        rex(true, 0, 0, dst);
+        byte(0xB8 | (dst & 7));
+        qword(imm);
+    }
+    void movRR8 (Reg dst, Reg src) { op(false, { 0x88 }, src, dst); }
+    void movMR8 (const Mem& dst, Reg src) { op(false, { 0x88 }, src, dst); }
+    void movMR16 (const Mem& dst, Reg src) {
+        byte(0x66);
+        op(false, { 0x89 }, src, dst);
+    }
+    void movMR32 (const Mem& dst, Reg src) { op(false, { 0x89 }, src, dst); }
+    void movMI8 (const Mem& dst, uint8_t imm) {
+        op(false, { 0xC6 }, 0, dst);
+        byte(imm);
+    }
+    void movzx8 (Reg dst, Reg src) { op(false, { 0x0F, 0xB6 }, dst, src); }
+    void movzx8 (Reg dst, const Mem& src) { op(false, { 0x0F, 0xB6 }, dst, src); }
+    void movzx16 (Reg dst, Reg src) { op(false, { 0x0F, 0xB7 }, dst, src); }
+    void movzx16 (Reg dst, const Mem& src) { op(false, { 0x0F, 0xB7 }, dst, src); }
+    void lea (Reg dst, const Mem& src) { op(false, { 0x8D }, dst, src); }
+    void lea64 (Reg dst, const Mem& src) { op(true, { 0x8D }, dst, src); }
+
+    void alu (Alu kind, Reg dst, Reg src) { op(false, { static_cast<uint8_t>((kind << 3) | 1) }, src, dst); }
+    void alu8 (Alu kind, Reg dst, Reg src) { op(false, { static_cast<uint8_t>(kind << 3) }, src, dst); }
+    void aluI (Alu kind, Reg dst, int32_t imm) {
+        op(false, { 0x81 }, kind, dst);
+        dword(imm);
+    }
+    void aluI8 (Alu kind, Reg dst, uint8_t imm) {
+        op(false, { 0x80 }, kind, dst);
+        byte(imm);
+    }
+    void addMI64 (const Mem& dst, int32_t imm) {
+        op(true, { 0x81 }, ADD, dst);
+        dword(imm);
+    }
+    void cmpMI8 (const Mem& dst, uint8_t imm) {
+        op(false, { 0x80 }, CMP, dst);
+        byte(imm);
+    }
+    void cmpMI16 (const Mem& dst, uint8_t imm) {
+        byte(0x66);
+        op(false, { 0x83 }, CMP, dst);
+        byte(imm);
+    }
+    void cmpMI64 (const Mem& dst, uint8_t imm) {
+        op(true, { 0x83 }, CMP, dst);
+        byte(imm);
+    }
+    void test8 (Reg dst, Reg src) { op(false, { 0x84 }, src, dst); }
+    void testI (Reg dst, uint32_t imm) {
+        op(false, { 0xF7 }, 0, dst);
+        dword(imm);
+    }
+    void inc8 (Reg dst) { op(false, { 0xFE }, 0, dst); }
+    void dec8 (Reg dst) { op(false, { 0xFE }, 1, dst); }
+    void shift8 (Shift kind, Reg dst) { op(false, { 0xD0 }, kind, dst); }
+    void shiftI (Shift kind, Reg dst, uint8_t imm) {
+        op(false, { 0xC1 }, kind, dst);
+        byte(imm);
+    }
+    void bt (Reg dst, uint8_t bit) {
+        op(false, { 0x0F, 0xBA }, 4, dst);
+        byte(bit);
+    }
+    void cmc () { byte(0xF5); }
+    void setcc (Cond cond, Reg dst) { op(false, { 0x0F, static_cast<uint8_t>(0x90 | cond) }, 0, dst); }
+    void cmov (Cond cond, Reg dst, Reg src) { op(false, { 0x0F, static_cast<uint8_t>(0x40 | cond) }, dst, src); }
+
+    void push (Reg reg) {
+        rex(false, 0, 0, reg);
+        byte(0x50 | (reg & 7));
+    }
+    void pop (Reg reg) {
+        rex(false, 0, 0, reg);
+        byte(0x58 | (reg & 7));
+    }
+    void subRsp (int32_t imm) {
+        op(true, { 0x81 }, SUB, RSP);
+        dword(imm);
+    }
+    void addRsp (int32_t imm) {
+        op(true, { 0x81 }, ADD, RSP);
+        dword(imm);
+    }
+    void movR64 (Reg dst, Reg src) { op(true, { 0x89 }, src, dst); }
+    void call (Reg target) { op(false, { 0xFF }, 2, target); }
+    void ret () { byte(0xC3); }
+
+    // jumps are emitted with a zero rel32 and patched once the target is known
+    size_t jcc (Cond cond) {
+        byte(0x0F);
+        byte(0x80 | cond);
+        dword(0);
+        return size();
+    }
+    size_t jmp () {
+        byte(0xE9);
+        dword(0);
+        return size();
+    }
+    void patch (size_t jumpEnd, size_t target) {
+        const auto rel = static_cast<int32_t>(target - jumpEnd);
+
+        for (auto index = 0; index < 4; index++) {
+            code[jumpEnd - 4 + index] = rel >> (index * 8);
+        }
+    }
+};
+
+}
+
+
+
+#endif //X64_H
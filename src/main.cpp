@@ -1,7 +1,11 @@
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <fstream>
+#include <memory>
 #include <streambuf>
 #include <string>
+#include <thread>
 #include <variant>
 #include <vector>
 
@@ -9,28 +13,254 @@
 
 #include "assembler/tokenize.h"
 #include "assembler/asm.h"
+#include "assembler/opcodes.h"
+#include "assembler/symbols.h"
+#include "batch/batch.h"
+#include "batch/bench.h"
+#include "batch/lockstep.h"
 #include "disassembler/disasm.h"
+#include "emulator/cpu.h"
+#include "emulator/Debugger.h"
+#include "emulator/flagcheck.h"
+#include "emulator/Machine.h"
+#include "emulator/Movie.h"
+#include "emulator/Profile.h"
+#include "emulator/Timer.h"
+#include "emulator/Trace.h"
+#include "frontend/Emulation.h"
+#include "frontend/Overlay.h"
+#include "jit/jit.h"
 
 
 
-void run (const char* binaryFile) {
-    InitWindow(640, 400, "haustier-emu");
+struct KeyButton {
+    int key;
+    Button button;
+};
 
-    SetTargetFPS(60);
+constexpr KeyButton keyButtons[] {
+    { KEY_UP, ButtonUp },
+    { KEY_DOWN, ButtonDown },
+    { KEY_LEFT, ButtonLeft },
+    { KEY_RIGHT, ButtonRight },
+    { KEY_Z, ButtonA },
+    { KEY_X, ButtonB },
+    { KEY_TAB, ButtonSelect },
+    { KEY_ENTER, ButtonStart },
+};
+
+// input that does not fit the queue is dropped rather than have the window wait for the emulation
+void sendInput (Emulation& emulation) {
+    const auto now = std::chrono::steady_clock::now();
+
+    for (const auto& [key, button] : keyButtons) {
+        if (IsKeyPressed(key)) {
+            push(emulation.inputs, { { InputKind::Press, button }, now });
+        }
+
+        if (IsKeyReleased(key)) {
+            push(emulation.inputs, { { InputKind::Release, button }, now });
+        }
+    }
+
+    for (auto character = GetCharPressed(); character != 0; character = GetCharPressed()) {
+        if (character < 0x80) {
+            push(emulation.inputs, { { InputKind::Character, static_cast<uint8_t>(character) }, now });
+        }
+    }
+}
+
+struct RunOptions {
+    Engine engine;
+    FlagEvaluation flags;
+    Accuracy accuracy;
+    CpuVariant variant;
+    uint32_t clockRate;
+    bool warp;
+    uint32_t runAhead;
+
+    // <binary-file>.state when empty
+    std::string stateFile;
+    bool resume;
+
+    std::vector<uint16_t> breakpoints;
+    std::vector<Watch> watches;
+
+    // recorded to when set
+    std::string movieFile;
+};
+
+void run (const char* binaryFile, const RunOptions& options) {
+    std::ifstream file { binaryFile, std::ios::binary };
+    const std::vector<uint8_t> bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+    const auto emulation = std::make_unique<Emulation>();
+    auto& machine = emulation->machine;
+
+    if (!load(machine, bytes)) {
+        fprintf(stderr, "%s does not fit in memory\n", binaryFile);
+        return;
+    }
+
+    const std::vector<uint8_t> loaded { machine.memory.begin(), machine.memory.end() };
+    reset(machine);
+    machine.engine = options.engine;
+    machine.flags = options.flags;
+    machine.accuracy = options.accuracy;
+    machine.variant = options.variant;
+    attachDevices(*emulation);
+    emulation->cyclesPerSecond = options.clockRate;
+    emulation->warp = options.warp;
+    emulation->runAhead = options.runAhead;
+    emulation->stateFile = options.stateFile.empty() ? std::string(binaryFile) + ".state" : options.stateFile;
+    machine.debugger = &emulation->debugger;
+
+    for (const auto pc : options.breakpoints) {
+        setBreakpoint(machine, pc, true);
+    }
+
+    for (const auto& watch : options.watches) {
+        setWatch(machine, watch);
+    }
+
+    if (options.resume && !loadStateFile(*emulation)) {
+        return;
+    }
+
+    // the movie starts from the machine as it is now, saved against the memory the binary loaded into
+    if (!options.movieFile.empty()) {
+        emulation->movieFile = options.movieFile;
+
+        if (!openMovie(emulation->movie, options.movieFile.c_str(), machine, stateDevices(*emulation), loaded.data())) {
+            fprintf(stderr, "cannot write %s\n", options.movieFile.c_str());
+            return;
+        }
+    }
+
+    InitWindow(framebufferWidth * 4, framebufferHeight * 4, "haustier-emu");
+
+    SetTargetFPS(framesPerSecond);
+
+    const auto image = GenImageColor(framebufferWidth, framebufferHeight, BLACK);
+    const auto texture = LoadTextureFromImage(image);
+    UnloadImage(image);
+    SetTextureFilter(texture, TEXTURE_FILTER_POINT);
+
+    const auto heatImage = GenImageColor(heatmapSide, heatmapSide, BLACK);
+    const auto heatTexture = LoadTextureFromImage(heatImage);
+    UnloadImage(heatImage);
+    SetTextureFilter(heatTexture, TEXTURE_FILTER_POINT);
+
+    // a slow present or a dragged window only delays what is shown, the emulation keeps its own pace
+    std::thread thread { emulate, std::ref(*emulation) };
+
+    std::chrono::steady_clock::duration videoTime {};
+    uint64_t frames = 0;
+    uint64_t uploaded = 0;
+    Overlay overlay;
 
     while (!WindowShouldClose()) {
         if (IsKeyPressed(KEY_Q)) {
             break;
         }
 
+        if (IsKeyPressed(KEY_W)) {
+            emulation->warp = !emulation->warp;
+        }
+
+        if (IsKeyPressed(KEY_H)) {
+            emulation->heatmapShown = !emulation->heatmapShown;
+        }
+
+        emulation->rewinding = IsKeyDown(KEY_BACKSPACE);
+
+        if (IsKeyPressed(KEY_F5)) {
+            emulation->saveRequested = true;
+        }
+
+        if (IsKeyPressed(KEY_F9)) {
+            emulation->loadRequested = true;
+        }
+
+        if (IsKeyPressed(KEY_F6)) {
+            emulation->resumeRequested = true;
+        }
+
+        if (IsKeyPressed(KEY_F7)) {
+            emulation->stepRequested = true;
+        }
+
+        if (IsKeyPressed(KEY_F8)) {
+            emulation->clearRequested = true;
+        }
+
+        sendInput(*emulation);
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto taken = takeNewest(emulation->frames);
+        const auto& frame = frontSlot(emulation->frames);
+
+        if (taken && frame.version != uploaded) {
+            UpdateTexture(texture, frame.pixels.data());
+            uploaded = frame.version;
+        }
+
+        if (taken && frame.heatmap) {
+            UpdateTexture(heatTexture, frame.heat.data());
+        }
+
+        // the heatmap takes a square on the right, the display the largest whole multiple that fits what is left, centred
+        const auto heatSide = frame.heatmap ? std::min(GetScreenHeight(), GetScreenWidth() / 2) : 0;
+        const auto displayWidth = GetScreenWidth() - heatSide;
+        const auto scale = std::max(1, std::min(displayWidth / framebufferWidth, GetScreenHeight() / framebufferHeight));
+        const auto width = static_cast<float>(framebufferWidth * scale);
+        const auto height = static_cast<float>(framebufferHeight * scale);
+        const Rectangle source { 0, 0, framebufferWidth, framebufferHeight };
+        const Rectangle target { (displayWidth - width) / 2, (GetScreenHeight() - height) / 2, width, height };
+
         BeginDrawing();
 
-        ClearBackground(WHITE);
+        ClearBackground(BLACK);
+        DrawTexturePro(texture, source, target, { 0, 0 }, 0, WHITE);
+
+        if (heatSide != 0) {
+            const Rectangle heatSource { 0, 0, heatmapSide, heatmapSide };
+            const Rectangle heatTarget {
+                static_cast<float>(displayWidth), static_cast<float>(GetScreenHeight() - heatSide) / 2,
+                static_cast<float>(heatSide), static_cast<float>(heatSide)
+            };
+
+            DrawTexturePro(heatTexture, heatSource, heatTarget, { 0, 0 }, 0, WHITE);
+        }
+        DrawText(formatOverlay(overlay).c_str(), 4, 4, 10, GREEN);
+
+        // up to the swap, which waits for the next frame
+        videoTime += std::chrono::steady_clock::now() - start;
+        frames++;
 
         EndDrawing();
+
+        if (taken) {
+            recordPresent(overlay, frame, std::chrono::steady_clock::now());
+        }
     }
 
+    emulation->stop = true;
+    thread.join();
+
+    UnloadTexture(heatTexture);
+    UnloadTexture(texture);
     CloseWindow();
+
+    fprintf(stderr, "bus: %s", formatBusStats(machine).c_str());
+
+    if (frames != 0) {
+        fprintf(stderr, "video: %.3f ms per frame\n", std::chrono::duration<double, std::milli>(videoTime).count() / frames);
+    }
+
+    if (emulation->aheadMissed != 0) {
+        fprintf(stderr, "run-ahead: %llu frames took longer than a frame to run\n", static_cast<unsigned long long>(emulation->aheadMissed));
+    }
 }
 
 void tokenizeDebug (const std::string& source) {
@@ -49,7 +279,17 @@ void tokenizeDebug (const std::string& source) {
     }
 }
 
-std::vector<uint8_t> assemble (const std::string& source) {
+std::variant<std::vector<uint8_t>, ParserError> assemble (const std::vector<Token>& tokens, CpuVariant variant, Labels* labels) {
+    switch (variant) {
+        case CpuVariant::Nmos: return assemble<Nmos6502>(tokens, labels);
+        case CpuVariant::NmosUndocumented: return assemble<Nmos6502Undocumented>(tokens, labels);
+        case CpuVariant::Cmos: return assemble<Cmos65C02>(tokens, labels);
+    }
+
+    return ParserError { "unknown cpu variant", 0 };
+}
+
+std::vector<uint8_t> assemble (const std::string& source, CpuVariant variant, Labels* labels = nullptr) {
     const auto tokensOrError = tokenize(source);
 
     if (const auto* error = std::get_if<ParserError>(&tokensOrError)) {
@@ -57,7 +297,7 @@ std::vector<uint8_t> assemble (const std::string& source) {
         return {};
     }
 
-    const auto bytesOrError = assemble(std::get<std::vector<Token>>(tokensOrError));
+    const auto bytesOrError = assemble(std::get<std::vector<Token>>(tokensOrError), variant, labels);
 
     if (const auto* error = std::get_if<ParserError>(&bytesOrError)) {
         printf("error in line %d: %s\n", error->lineIndex + 1, error->message.c_str());
@@ -67,8 +307,8 @@ std::vector<uint8_t> assemble (const std::string& source) {
     return std::get<std::vector<uint8_t>>(bytesOrError);
 }
 
-void assembleDebug (const std::string& source) {
-    const auto bytes = assemble(source);
+void assembleDebug (const std::string& source, CpuVariant variant) {
+    const auto bytes = assemble(source, variant);
 
     for (const auto byte : bytes) {
         printf("0x%02x ", byte);
@@ -77,30 +317,877 @@ void assembleDebug (const std::string& source) {
     printf("\n");
 }
 
-void assembleBytes (const std::string& source) {
-    const auto bytes = assemble(source);
+void assembleBytes (const std::string& source, CpuVariant variant) {
+    const auto bytes = assemble(source, variant);
 
     fwrite(bytes.data(), 1, bytes.size(), stdout);
 }
 
-void disassembleBytes (const std::vector<uint8_t>& bytes) {
-    const auto source = disassemble(bytes);
+// as loaded at programStart
+void assembleSymbols (const std::string& source, CpuVariant variant) {
+    Labels labels;
+
+    if (assemble(source, variant, &labels).empty()) {
+        return;
+    }
+
+    printf("%s", formatSymbols(makeSymbols(labels, programStart)).c_str());
+}
+
+void disassembleBytes (const std::vector<uint8_t>& bytes, CpuVariant variant) {
+    std::string source;
+
+    switch (variant) {
+        case CpuVariant::Nmos: source = disassemble<Nmos6502>(bytes); break;
+        case CpuVariant::NmosUndocumented: source = disassemble<Nmos6502Undocumented>(bytes); break;
+        case CpuVariant::Cmos: source = disassemble<Cmos65C02>(bytes); break;
+    }
 
     printf("%s", source.data());
 }
 
+bool parseCount (const char* text, uint64_t& count) {
+    char* end;
+    count = strtoull(text, &end, 0);
+    return *text != '\0' && *end == '\0';
+}
+
+bool parseRange (const char* text, uint64_t& first, uint64_t& last) {
+    const auto* dash = strchr(text, '-');
+
+    if (dash == nullptr) {
+        return false;
+    }
+
+    return parseCount(std::string(text, dash).c_str(), first) && parseCount(dash + 1, last) && first <= last;
+}
+
+// a single address or a range of them
+bool parseWatch (const char* text, uint8_t kinds, Watch& watch) {
+    uint64_t first;
+    uint64_t last;
+
+    if (!parseRange(text, first, last)) {
+        if (!parseCount(text, first)) {
+            return false;
+        }
+
+        last = first;
+    }
+
+    watch = { static_cast<uint16_t>(first), static_cast<uint16_t>(last), kinds };
+    return last <= 0xffff;
+}
+
+bool parseEngine (const char* text, Engine& engine) {
+    for (const auto& [named, name] : engineNames) {
+        if (name == text) {
+            engine = named;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool parseFlags (const char* text, FlagEvaluation& flags) {
+    if (strcmp(text, "lazy") == 0) {
+        flags = FlagEvaluation::Lazy;
+    } else if (strcmp(text, "eager") == 0) {
+        flags = FlagEvaluation::Eager;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+bool parseVariant (const char* text, CpuVariant& variant) {
+    if (strcmp(text, "nmos") == 0) {
+        variant = CpuVariant::Nmos;
+    } else if (strcmp(text, "nmos-undocumented") == 0) {
+        variant = CpuVariant::NmosUndocumented;
+    } else if (strcmp(text, "65c02") == 0) {
+        variant = CpuVariant::Cmos;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+bool parseAccuracy (const char* text, Accuracy& accuracy) {
+    if (strcmp(text, "fast") == 0) {
+        accuracy = Accuracy::Fast;
+    } else if (strcmp(text, "cycle") == 0) {
+        accuracy = Accuracy::Cycle;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+std::string engineList () {
+    std::string list;
+
+    for (const auto& [engine, name] : engineNames) {
+        list += list.empty() ? "" : "|";
+        list += name;
+    }
+
+    return list;
+}
+
+bool runCommand (int argc, char* argv[]) {
+    RunOptions options { Engine::BlockCache, FlagEvaluation::Lazy, Accuracy::Fast, CpuVariant::Nmos, clockRate, false, 0, {}, false, {}, {}, {} };
+    uint64_t rate = clockRate;
+    uint64_t frames = 0;
+    uint64_t pc = 0;
+    Watch watch;
+    const char* binaryFile = nullptr;
+
+    for (auto index = 0; index < argc; index++) {
+        const auto hasValue = index + 1 < argc;
+
+        if (strcmp(argv[index], "--engine") == 0 && hasValue && parseEngine(argv[index + 1], options.engine)) {
+            index++;
+        } else if (strcmp(argv[index], "--flags") == 0 && hasValue && parseFlags(argv[index + 1], options.flags)) {
+            index++;
+        } else if (strcmp(argv[index], "--accuracy") == 0 && hasValue && parseAccuracy(argv[index + 1], options.accuracy)) {
+            index++;
+        } else if (strcmp(argv[index], "--cpu") == 0 && hasValue && parseVariant(argv[index + 1], options.variant)) {
+            index++;
+        } else if (strcmp(argv[index], "--clock") == 0 && hasValue && parseCount(argv[index + 1], rate) && rate != 0 && rate <= UINT32_MAX) {
+            options.clockRate = rate;
+            index++;
+        } else if (strcmp(argv[index], "--warp") == 0) {
+            options.warp = true;
+        } else if (strcmp(argv[index], "--run-ahead") == 0 && hasValue && parseCount(argv[index + 1], frames) && frames <= framesPerSecond) {
+            options.runAhead = frames;
+            index++;
+        } else if (strcmp(argv[index], "--state") == 0 && hasValue) {
+            options.stateFile = argv[index + 1];
+            index++;
+        } else if (strcmp(argv[index], "--resume") == 0) {
+            options.resume = true;
+        } else if (strcmp(argv[index], "--record") == 0 && hasValue) {
+            options.movieFile = argv[index + 1];
+            index++;
+        } else if (strcmp(argv[index], "--break") == 0 && hasValue && parseCount(argv[index + 1], pc) && pc <= 0xffff) {
+            options.breakpoints.push_back(pc);
+            index++;
+        } else if (strcmp(argv[index], "--watch-read") == 0 && hasValue && parseWatch(argv[index + 1], WatchRead, watch)) {
+            options.watches.push_back(watch);
+            index++;
+        } else if (strcmp(argv[index], "--watch-write") == 0 && hasValue && parseWatch(argv[index + 1], WatchWrite, watch)) {
+            options.watches.push_back(watch);
+            index++;
+        } else if (strncmp(argv[index], "--", 2) != 0 && binaryFile == nullptr) {
+            binaryFile = argv[index];
+        } else {
+            return false;
+        }
+    }
+
+    if (binaryFile == nullptr) {
+        return false;
+    }
+
+    run(binaryFile, options);
+    return true;
+}
+
+bool replay (int argc, char* argv[]) {
+    auto engine = Engine::BlockCache;
+    const char* binaryFile = nullptr;
+    const char* movieFile = nullptr;
+    const char* stateFile = nullptr;
+
+    for (auto index = 0; index < argc; index++) {
+        const auto hasValue = index + 1 < argc;
+
+        if (strcmp(argv[index], "--engine") == 0 && hasValue && parseEngine(argv[index + 1], engine)) {
+            index++;
+        } else if (strcmp(argv[index], "--save") == 0 && hasValue) {
+            stateFile = argv[index + 1];
+            index++;
+        } else if (strncmp(argv[index], "--", 2) != 0 && binaryFile == nullptr) {
+            binaryFile = argv[index];
+        } else if (strncmp(argv[index], "--", 2) != 0 && movieFile == nullptr) {
+            movieFile = argv[index];
+        } else {
+            return false;
+        }
+    }
+
+    if (movieFile == nullptr) {
+        return false;
+    }
+
+    std::ifstream file { binaryFile, std::ios::binary };
+    const std::vector<uint8_t> bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+    MovieReader reader;
+
+    if (!openMovieReader(reader, movieFile)) {
+        fprintf(stderr, "%s is not a movie this build can replay\n", movieFile);
+        return true;
+    }
+
+    // set up as the window's machine is, without the window
+    const auto emulation = std::make_unique<Emulation>();
+    auto& machine = emulation->machine;
+
+    if (!load(machine, bytes)) {
+        fprintf(stderr, "%s does not fit in memory\n", binaryFile);
+        return true;
+    }
+
+    reset(machine);
+    machine.engine = engine;
+    attachDevices(*emulation);
+
+    Replay replayed;
+    const auto start = std::chrono::steady_clock::now();
+
+    if (!replayMovie(machine, stateDevices(*emulation), reader, replayed)) {
+        fprintf(stderr, "%s was not recorded with %s\n", movieFile, binaryFile);
+        return true;
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    printf("%s", formatReplay(replayed).c_str());
+    fprintf(
+        stderr, "replay: %.3f s, %.1f times real time\n", elapsed.count(),
+        static_cast<double>(replayed.frames) / framesPerSecond / elapsed.count()
+    );
+
+    if (stateFile != nullptr) {
+        saveState(machine, stateDevices(*emulation), emulation->state);
+
+        if (!writeStateFile(stateFile, emulation->state)) {
+            fprintf(stderr, "cannot write %s\n", stateFile);
+        }
+    }
+
+    return true;
+}
+
+bool batch (int argc, char* argv[]) {
+    BatchOptions options { 10'000'000, BudgetUnit::Cycles, std::max(1u, std::thread::hardware_concurrency()), Engine::BlockCache, FlagEvaluation::Lazy, Accuracy::Fast, CpuVariant::Nmos, false, false, true, {}, 0 };
+    const char* reportFile = nullptr;
+    std::vector<std::string> binaryFiles;
+
+    for (auto index = 0; index < argc; index++) {
+        const auto hasValue = index + 1 < argc;
+        uint64_t count;
+
+        if (strcmp(argv[index], "--cycles") == 0 && hasValue && parseCount(argv[index + 1], count)) {
+            options.budget = count;
+            options.unit = BudgetUnit::Cycles;
+            index++;
+        } else if (strcmp(argv[index], "--instructions") == 0 && hasValue && parseCount(argv[index + 1], count)) {
+            options.budget = count;
+            options.unit = BudgetUnit::Instructions;
+            index++;
+        } else if (strcmp(argv[index], "--threads") == 0 && hasValue && parseCount(argv[index + 1], count) && count > 0) {
+            options.threadCount = count;
+            index++;
+        } else if (strcmp(argv[index], "--engine") == 0 && hasValue && parseEngine(argv[index + 1], options.engine)) {
+            index++;
+        } else if (strcmp(argv[index], "--flags") == 0 && hasValue && parseFlags(argv[index + 1], options.flags)) {
+            index++;
+        } else if (strcmp(argv[index], "--accuracy") == 0 && hasValue && parseAccuracy(argv[index + 1], options.accuracy)) {
+            index++;
+        } else if (strcmp(argv[index], "--cpu") == 0 && hasValue && parseVariant(argv[index + 1], options.variant)) {
+            index++;
+        } else if (strcmp(argv[index], "--lockstep") == 0) {
+            options.lockstep = true;
+        } else if (strcmp(argv[index], "--timer") == 0) {
+            options.timer = true;
+        } else if (strcmp(argv[index], "--no-idle-skip") == 0) {
+            options.skipIdle = false;
+        } else if (strcmp(argv[index], "--state-dir") == 0 && hasValue) {
+            options.stateDirectory = argv[index + 1];
+            index++;
+        } else if (strcmp(argv[index], "--checkpoint") == 0 && hasValue && parseCount(argv[index + 1], count)) {
+            options.checkpointInterval = count;
+            index++;
+        } else if (strcmp(argv[index], "--report") == 0 && hasValue) {
+            reportFile = argv[index + 1];
+            index++;
+        } else if (strncmp(argv[index], "--", 2) == 0) {
+            return false;
+        } else {
+            binaryFiles.emplace_back(argv[index]);
+        }
+    }
+
+    // lanes step whole NMOS instructions with table cycles and have no devices or states
+    const auto lanesCannot = options.accuracy == Accuracy::Cycle || options.variant != CpuVariant::Nmos || options.timer || !options.stateDirectory.empty();
+
+    if (binaryFiles.empty() || (options.lockstep && lanesCannot)) {
+        return false;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto results = runBatch(binaryFiles, options);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    uint64_t instructions = 0;
+    uint64_t slowAccesses = 0;
+    uint64_t skippedCycles = 0;
+
+    for (const auto& result : results) {
+        instructions += result.status == BatchStatus::LoadFailed ? 0 : result.instructions;
+        slowAccesses += result.status == BatchStatus::LoadFailed ? 0 : result.slowAccesses;
+        skippedCycles += result.status == BatchStatus::LoadFailed ? 0 : result.skippedCycles;
+    }
+
+    // on stderr so that the report stays comparable between runs
+    fprintf(
+        stderr, "%llu instructions in %.3f s, %.1f MIPS aggregate, %llu slow bus accesses, %llu cycles skipped in idle loops\n",
+        static_cast<unsigned long long>(instructions), elapsed.count(), instructions / elapsed.count() / 1e6,
+        static_cast<unsigned long long>(slowAccesses), static_cast<unsigned long long>(skippedCycles)
+    );
+
+    const auto report = formatReport(binaryFiles, results);
+
+    if (reportFile == nullptr) {
+        printf("%s", report.c_str());
+    } else {
+        std::ofstream { reportFile } << report;
+    }
+
+    return true;
+}
+
+#if HAUSTIER_JIT
+bool jitDiff (int argc, char* argv[]) {
+    uint64_t cycleBudget = 10'000'000;
+    const char* binaryFile = nullptr;
+
+    for (auto index = 0; index < argc; index++) {
+        const auto hasValue = index + 1 < argc;
+
+        if (strcmp(argv[index], "--cycles") == 0 && hasValue && parseCount(argv[index + 1], cycleBudget)) {
+            index++;
+        } else if (strncmp(argv[index], "--", 2) != 0 && binaryFile == nullptr) {
+            binaryFile = argv[index];
+        } else {
+            return false;
+        }
+    }
+
+    if (binaryFile == nullptr) {
+        return false;
+    }
+
+    std::ifstream file { binaryFile, std::ios::binary };
+    const std::vector<uint8_t> bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+    printf("%s", diffJit(bytes, cycleBudget).c_str());
+    return true;
+}
+#endif
+
+// sources ending in .htr are assembled first, anything else is a binary
+bool bench (int argc, char* argv[]) {
+    BenchOptions options { 100'000'000, 1'000'000, 5, {} };
+    std::vector<std::string> files;
+
+    for (auto index = 0; index < argc; index++) {
+        const auto hasValue = index + 1 < argc;
+        uint64_t count;
+        Engine engine;
+
+        if (strcmp(argv[index], "--cycles") == 0 && hasValue && parseCount(argv[index + 1], options.cycleBudget)) {
+            index++;
+        } else if (strcmp(argv[index], "--warmup") == 0 && hasValue && parseCount(argv[index + 1], options.warmupCycles)) {
+            index++;
+        } else if (strcmp(argv[index], "--repeat") == 0 && hasValue && parseCount(argv[index + 1], count) && count > 0 && count <= UINT32_MAX) {
+            options.repetitions = count;
+            index++;
+        } else if (strcmp(argv[index], "--engine") == 0 && hasValue && parseEngine(argv[index + 1], engine)) {
+            options.engines.push_back(engine);
+            index++;
+        } else if (strncmp(argv[index], "--", 2) == 0) {
+            return false;
+        } else {
+            files.emplace_back(argv[index]);
+        }
+    }
+
+    if (files.empty()) {
+        files.assign(std::begin(benchSamples), std::end(benchSamples));
+    }
+
+    std::vector<BenchResult> results;
+
+    for (const auto& path : files) {
+        std::ifstream file { path, std::ios::binary };
+
+        if (!file.is_open()) {
+            fprintf(stderr, "cannot read %s\n", path.c_str());
+            continue;
+        }
+
+        std::vector<uint8_t> bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+        if (path.ends_with(".htr")) {
+            bytes = assemble(std::string { bytes.begin(), bytes.end() }, CpuVariant::Nmos);
+
+            if (bytes.empty()) {
+                continue;
+            }
+        }
+
+        const auto programResults = runBench(path, bytes, options);
+        results.insert(results.end(), programResults.begin(), programResults.end());
+    }
+
+    printf("%s", formatBench(options, results).c_str());
+    return true;
+}
+
+void printBusEvent (const Machine&, const BusEvent& event) {
+    printf(
+        "%10llu %04x %c %02x\n",
+        static_cast<unsigned long long>(event.cycle), event.address, event.write ? 'w' : 'r', event.value
+    );
+}
+
+bool busTrace (int argc, char* argv[]) {
+    uint64_t cycleBudget = 1'000;
+    auto variant = CpuVariant::Nmos;
+    auto withTimer = false;
+    const char* binaryFile = nullptr;
+
+    for (auto index = 0; index < argc; index++) {
+        const auto hasValue = index + 1 < argc;
+
+        if (strcmp(argv[index], "--cycles") == 0 && hasValue && parseCount(argv[index + 1], cycleBudget)) {
+            index++;
+        } else if (strcmp(argv[index], "--cpu") == 0 && hasValue && parseVariant(argv[index + 1], variant)) {
+            index++;
+        } else if (strcmp(argv[index], "--timer") == 0) {
+            withTimer = true;
+        } else if (strncmp(argv[index], "--", 2) != 0 && binaryFile == nullptr) {
+            binaryFile = argv[index];
+        } else {
+            return false;
+        }
+    }
+
+    if (binaryFile == nullptr) {
+        return false;
+    }
+
+    std::ifstream file { binaryFile, std::ios::binary };
+    const std::vector<uint8_t> bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+    const auto machine = std::make_unique<Machine>();
+
+    if (!load(*machine, bytes)) {
+        fprintf(stderr, "%s does not fit in memory\n", binaryFile);
+        return true;
+    }
+
+    reset(*machine);
+    machine->engine = Engine::Interpreter;
+    machine->accuracy = Accuracy::Cycle;
+    machine->variant = variant;
+    machine->busListener = printBusEvent;
+
+    Timer timer;
+
+    if (withTimer) {
+        attachTimer(*machine, timer);
+    }
+
+    runCycles(*machine, cycleBudget);
+
+    fprintf(stderr, "bus: %s", formatBusStats(*machine).c_str());
+    return true;
+}
+
+bool instructionTrace (int argc, char* argv[]) {
+    uint64_t cycleBudget = 1'000'000;
+    auto variant = CpuVariant::Nmos;
+    auto accuracy = Accuracy::Fast;
+    auto withTimer = false;
+    const char* binaryFile = nullptr;
+    const char* traceFile = nullptr;
+
+    for (auto index = 0; index < argc; index++) {
+        const auto hasValue = index + 1 < argc;
+
+        if (strcmp(argv[index], "--cycles") == 0 && hasValue && parseCount(argv[index + 1], cycleBudget)) {
+            index++;
+        } else if (strcmp(argv[index], "--cpu") == 0 && hasValue && parseVariant(argv[index + 1], variant)) {
+            index++;
+        } else if (strcmp(argv[index], "--accuracy") == 0 && hasValue && parseAccuracy(argv[index + 1], accuracy)) {
+            index++;
+        } else if (strcmp(argv[index], "--timer") == 0) {
+            withTimer = true;
+        } else if (strncmp(argv[index], "--", 2) != 0 && binaryFile == nullptr) {
+            binaryFile = argv[index];
+        } else if (strncmp(argv[index], "--", 2) != 0 && traceFile == nullptr) {
+            traceFile = argv[index];
+        } else {
+            return false;
+        }
+    }
+
+    if (traceFile == nullptr) {
+        return false;
+    }
+
+    std::ifstream file { binaryFile, std::ios::binary };
+    const std::vector<uint8_t> bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+    const auto machine = std::make_unique<Machine>();
+
+    if (!load(*machine, bytes)) {
+        fprintf(stderr, "%s does not fit in memory\n", binaryFile);
+        return true;
+    }
+
+    reset(*machine);
+    machine->accuracy = accuracy;
+    machine->variant = variant;
+
+    Timer timer;
+
+    if (withTimer) {
+        attachTimer(*machine, timer);
+    }
+
+    Trace trace;
+
+    if (!openTrace(trace, traceFile, variant)) {
+        fprintf(stderr, "cannot write %s\n", traceFile);
+        return true;
+    }
+
+    machine->trace = &trace;
+
+    const auto start = std::chrono::steady_clock::now();
+    runCycles(*machine, cycleBudget);
+    const auto complete = closeTrace(trace);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    fprintf(
+        stderr, "trace: %llu instructions, %llu bytes, %.1f mips%s\n",
+        static_cast<unsigned long long>(trace.records),
+        static_cast<unsigned long long>(traceHeaderSize + trace.records * sizeof(TraceRecord)),
+        trace.records / elapsed.count() / 1e6, complete ? "" : ", cut short writing the file"
+    );
+
+    return true;
+}
+
+template <typename Variant>
+void printTraceRecord (const TraceRecord& record) {
+    printf(
+        "%s ; a %02x x %02x y %02x p %02x sp %02x ; %llu\n",
+        disassembleInstruction<Variant>(record.opcode, record.operandLow, record.operandHigh, record.pc).c_str(),
+        record.a, record.x, record.y, record.p, record.sp, static_cast<unsigned long long>(traceCycle(record))
+    );
+}
+
+// streams the trace a block of records at a time, starting from the first record of the cycle window
+bool traceDump (int argc, char* argv[]) {
+    uint64_t firstPc = 0;
+    uint64_t lastPc = 0xffff;
+    uint64_t firstCycle = 0;
+    uint64_t lastCycle = UINT64_MAX;
+    const char* traceFile = nullptr;
+
+    for (auto index = 0; index < argc; index++) {
+        const auto hasValue = index + 1 < argc;
+
+        if (strcmp(argv[index], "--pc") == 0 && hasValue && parseRange(argv[index + 1], firstPc, lastPc)) {
+            index++;
+        } else if (strcmp(argv[index], "--cycles") == 0 && hasValue && parseRange(argv[index + 1], firstCycle, lastCycle)) {
+            index++;
+        } else if (strncmp(argv[index], "--", 2) != 0 && traceFile == nullptr) {
+            traceFile = argv[index];
+        } else {
+            return false;
+        }
+    }
+
+    if (traceFile == nullptr) {
+        return false;
+    }
+
+    TraceReader reader;
+
+    if (!openTraceReader(reader, traceFile)) {
+        fprintf(stderr, "%s is no trace this build can read\n", traceFile);
+        return true;
+    }
+
+    const auto print = [&] <typename Variant> (Variant) {
+        std::vector<TraceRecord> records(0x10000);
+        auto next = findTraceCycle(reader, firstCycle);
+
+        while (const auto count = readTrace(reader, next, records.data(), records.size())) {
+            for (size_t index = 0; index < count; index++) {
+                const auto& record = records[index];
+
+                if (traceCycle(record) > lastCycle) {
+                    return;
+                }
+
+                if (record.pc >= firstPc && record.pc <= lastPc) {
+                    printTraceRecord<Variant>(record);
+                }
+            }
+
+            next += count;
+        }
+    };
+
+    switch (reader.variant) {
+        case CpuVariant::Nmos: print(Nmos6502 {}); break;
+        case CpuVariant::NmosUndocumented: print(Nmos6502Undocumented {}); break;
+        case CpuVariant::Cmos: print(Cmos65C02 {}); break;
+    }
+
+    return true;
+}
+
+#if HAUSTIER_PROFILER
+// a source ending in .htr is assembled first and brings its own labels, a binary can be given a symbol file
+bool runProfile (int argc, char* argv[]) {
+    uint64_t cycleBudget = 100'000'000;
+    auto variant = CpuVariant::Nmos;
+    auto accuracy = Accuracy::Fast;
+    auto withTimer = false;
+    const char* symbolFile = nullptr;
+    const char* programFile = nullptr;
+
+    for (auto index = 0; index < argc; index++) {
+        const auto hasValue = index + 1 < argc;
+
+        if (strcmp(argv[index], "--cycles") == 0 && hasValue && parseCount(argv[index + 1], cycleBudget)) {
+            index++;
+        } else if (strcmp(argv[index], "--cpu") == 0 && hasValue && parseVariant(argv[index + 1], variant)) {
+            index++;
+        } else if (strcmp(argv[index], "--accuracy") == 0 && hasValue && parseAccuracy(argv[index + 1], accuracy)) {
+            index++;
+        } else if (strcmp(argv[index], "--timer") == 0) {
+            withTimer = true;
+        } else if (strcmp(argv[index], "--symbols") == 0 && hasValue) {
+            symbolFile = argv[index + 1];
+            index++;
+        } else if (strncmp(argv[index], "--", 2) != 0 && programFile == nullptr) {
+            programFile = argv[index];
+        } else {
+            return false;
+        }
+    }
+
+    if (programFile == nullptr) {
+        return false;
+    }
+
+    std::ifstream file { programFile, std::ios::binary };
+    std::vector<uint8_t> bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    std::vector<Symbol> symbols;
+
+    if (std::string_view { programFile }.ends_with(".htr")) {
+        Labels labels;
+        bytes = assemble(std::string { bytes.begin(), bytes.end() }, variant, &labels);
+        symbols = makeSymbols(labels, programStart);
+    }
+
+    if (symbolFile != nullptr && !readSymbols(symbolFile, symbols)) {
+        fprintf(stderr, "cannot read the symbols in %s\n", symbolFile);
+        return true;
+    }
+
+    const auto machine = std::make_unique<Machine>();
+
+    if (!load(*machine, bytes)) {
+        fprintf(stderr, "%s does not fit in memory\n", programFile);
+        return true;
+    }
+
+    reset(*machine);
+    machine->accuracy = accuracy;
+    machine->variant = variant;
+
+    Timer timer;
+
+    if (withTimer) {
+        attachTimer(*machine, timer);
+    }
+
+    const auto profile = std::make_unique<Profile>();
+    machine->profile = profile.get();
+
+    runCycles(*machine, cycleBudget);
+
+    printf("%s", formatProfile(*machine, *profile, symbols).c_str());
+    return true;
+}
+#endif
+
+// sources ending in .htr are assembled first, anything else is a binary
+bool flagsCheck (int argc, char* argv[]) {
+    uint64_t instructionBudget = 10'000'000;
+    auto variant = CpuVariant::Nmos;
+    std::vector<std::string> files;
+
+    for (auto index = 0; index < argc; index++) {
+        const auto hasValue = index + 1 < argc;
+
+        if (strcmp(argv[index], "--instructions") == 0 && hasValue && parseCount(argv[index + 1], instructionBudget)) {
+            index++;
+        } else if (strcmp(argv[index], "--cpu") == 0 && hasValue && parseVariant(argv[index + 1], variant)) {
+            index++;
+        } else if (strncmp(argv[index], "--", 2) == 0) {
+            return false;
+        } else {
+            files.emplace_back(argv[index]);
+        }
+    }
+
+    if (files.empty()) {
+        return false;
+    }
+
+    for (const auto& path : files) {
+        std::ifstream file { path, std::ios::binary };
+        std::vector<uint8_t> bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+        if (path.ends_with(".htr")) {
+            bytes = assemble(std::string { bytes.begin(), bytes.end() }, variant);
+
+            if (bytes.empty()) {
+                continue;
+            }
+        }
+
+        printf("%s: %s", path.c_str(), checkFlags(bytes, instructionBudget, variant).c_str());
+    }
+
+    return true;
+}
+
+// sources ending in .htr are assembled first, anything else is a binary
+bool lockstepDiff (int argc, char* argv[]) {
+    uint64_t instructionBudget = 10'000'000;
+    std::vector<std::string> files;
+
+    for (auto index = 0; index < argc; index++) {
+        const auto hasValue = index + 1 < argc;
+
+        if (strcmp(argv[index], "--instructions") == 0 && hasValue && parseCount(argv[index + 1], instructionBudget)) {
+            index++;
+        } else if (strncmp(argv[index], "--", 2) == 0) {
+            return false;
+        } else {
+            files.emplace_back(argv[index]);
+        }
+    }
+
+    if (files.empty()) {
+        files.assign(std::begin(lockstepSamples), std::end(lockstepSamples));
+    }
+
+    for (const auto& path : files) {
+        std::ifstream file { path, std::ios::binary };
+
+        if (!file.is_open()) {
+            fprintf(stderr, "cannot read %s\n", path.c_str());
+            continue;
+        }
+
+        std::vector<uint8_t> bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+        if (path.ends_with(".htr")) {
+            bytes = assemble(std::string { bytes.begin(), bytes.end() }, CpuVariant::Nmos);
+
+            if (bytes.empty()) {
+                continue;
+            }
+        }
+
+        printf("%s: %s", path.c_str(), diffLockstep(bytes, instructionBudget).c_str());
+    }
+
+    return true;
+}
+
 void printUsage (char* path) {
+    const auto engines = engineList();
+
     fprintf(
         stderr,
         "Usage:\n"
-        " %s <binary-file>\n"
+        " %s [--engine %s] [--flags lazy|eager] [--accuracy fast|cycle] [--cpu <cpu>] [--clock <hz>] [--warp] [--run-ahead <frames>] [--state <file>] [--resume] [--break <pc>]... [--watch-read <first>[-<last>]]... [--watch-write <first>[-<last>]]... [--record <movie-file>] <binary-file>\n"
         " %s help\n"
-        " %s compile <source-file>\n"
+        " %s compile [--cpu <cpu>] <source-file>\n"
+        " %s symbols [--cpu <cpu>] <source-file>\n"
+        " %s decompile [--cpu <cpu>] <binary-file>\n"
+        " %s batch [--cycles <n> | --instructions <n>] [--threads <n>] [--engine %s | --lockstep] [--flags lazy|eager] [--accuracy fast|cycle] [--cpu <cpu>] [--timer] [--no-idle-skip] [--state-dir <dir> [--checkpoint <n>]] [--report <file>] <binary-file>...\n"
+        " %s bench [--cycles <n>] [--warmup <n>] [--repeat <n>] [--engine %s]... [<source-or-binary-file>...]\n"
+        " %s replay [--engine %s] [--save <state-file>] <binary-file> <movie-file>\n"
+        " %s flags-check [--instructions <n>] [--cpu <cpu>] <source-or-binary-file>...\n"
+        " %s lockstep-diff [--instructions <n>] [<source-or-binary-file>...]\n"
+        " %s bus-trace [--cycles <n>] [--cpu <cpu>] [--timer] <binary-file>\n"
+        " %s trace [--cycles <n>] [--cpu <cpu>] [--accuracy fast|cycle] [--timer] <binary-file> <trace-file>\n"
+        " %s trace-dump [--pc <first>-<last>] [--cycles <first>-<last>] <trace-file>\n"
         "\n"
         " %s tokenize <source-file>\n"
-        " %s compile-debug <source-file>\n",
-        path, path, path, path, path
+        " %s compile-debug [--cpu <cpu>] <source-file>\n"
+        "\n"
+        " <cpu> is nmos (default), nmos-undocumented or 65c02, lockstep batches and the jit run nmos only\n"
+        " the interval timer sits at $FE00 when running a binary, batches and bus traces map it with --timer\n"
+        " running a binary also shows the 160x100 framebuffer at $8000, one RRRGGGBB byte per pixel,\n"
+        " and maps the buttons held at $FD00 and the last character typed at $FD01\n"
+        " arrows, Z, X, tab and enter are up, down, left, right, A, B, select and start\n"
+        " W switches between warp and running paced at the clock rate, 1000000 by default, Q quits\n"
+        " paced frames with --run-ahead show the machine that many frames on, which hides as many frames of input lag\n"
+        " holding backspace rewinds, by up to a minute or more\n"
+        " H shows how often each byte was read in green, written in red and run in blue, a row per page with the zero page on top,\n"
+        " the machine runs on the interpreter while it is shown\n"
+        " F5 saves the machine to <binary-file>.state or the --state file and F9 loads it, --resume loads it at the start\n"
+        " --record writes the input with the cycle it was applied at and a state hash every second, until rewinding or loading a state,\n"
+        " replay runs that headless from the same start and reports the first frame whose state differs, --save keeps the final state\n"
+        " the machine stops before running a --break pc or after an instruction that read or wrote a watched address,\n"
+        " and runs on the interpreter while any are set, F6 goes on from a stop, F7 runs one instruction and F8 clears them all\n"
+        " batches with a --state-dir resume each binary from its state there, saved every --checkpoint cycles or instructions and at the end\n"
+        " bench times each program, by default the ones in samples/bench run from the top of the repository, on each engine\n"
+        " for --repeat runs of 5 by default, every one on a fresh machine warmed up for --warmup cycles first,\n"
+        " and prints a line of space-separated columns per program and engine with the median time of the runs\n"
+        " trace writes every instruction run with the registers before it, on the interpreter and 16 bytes each,\n"
+        " trace-dump prints those that ran in the pc and cycle ranges, both inclusive, as decompile would with the registers and cycle after them\n"
+        " lockstep-diff runs each program on the interpreter and in a lockstep lane, by default the samples that run on nmos,\n"
+        " and prints the first instruction after which they differ\n"
+        " symbols lists the labels of a source as loaded at $0200, for profiles of its binary\n",
+        path, engines.c_str(), path, path, path, path, path, engines.c_str(), path, engines.c_str(), path, engines.c_str(), path, path, path, path, path, path, path
     );
+
+#if HAUSTIER_JIT
+    fprintf(stderr, " %s jit-diff [--cycles <n>] <binary-file>\n", path);
+#endif
+
+#if HAUSTIER_PROFILER
+    fprintf(
+        stderr,
+        " %s profile [--cycles <n>] [--cpu <cpu>] [--accuracy fast|cycle] [--timer] [--symbols <file>] <source-or-binary-file>\n"
+        "  counts the instructions and cycles run at each pc on the interpreter, and lists them as decompile would\n"
+        "  with the hottest pcs and labels after them\n",
+        path
+    );
+#endif
 }
 
 int main (int argc, char* argv[]) {
@@ -109,46 +1196,151 @@ int main (int argc, char* argv[]) {
         return 1;
     }
 
-    if (argc == 2) {
-        if (strcmp(argv[1], "help") == 0) {
+    if (strcmp(argv[1], "batch") == 0) {
+        if (!batch(argc - 2, argv + 2)) {
             printUsage(argv[0]);
-        } else {
-            run(argv[1]);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (strcmp(argv[1], "bench") == 0) {
+        if (!bench(argc - 2, argv + 2)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (strcmp(argv[1], "bus-trace") == 0) {
+        if (!busTrace(argc - 2, argv + 2)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (strcmp(argv[1], "replay") == 0) {
+        if (!replay(argc - 2, argv + 2)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (strcmp(argv[1], "trace") == 0) {
+        if (!instructionTrace(argc - 2, argv + 2)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (strcmp(argv[1], "trace-dump") == 0) {
+        if (!traceDump(argc - 2, argv + 2)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        return 0;
+    }
+
+#if HAUSTIER_PROFILER
+    if (strcmp(argv[1], "profile") == 0) {
+        if (!runProfile(argc - 2, argv + 2)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        return 0;
+    }
+#endif
+
+    if (strcmp(argv[1], "flags-check") == 0) {
+        if (!flagsCheck(argc - 2, argv + 2)) {
+            printUsage(argv[0]);
+            return 1;
         }
 
         return 0;
     }
 
-    if (argc == 3) {
+    if (strcmp(argv[1], "lockstep-diff") == 0) {
+        if (!lockstepDiff(argc - 2, argv + 2)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        return 0;
+    }
+
+#if HAUSTIER_JIT
+    if (strcmp(argv[1], "jit-diff") == 0) {
+        if (!jitDiff(argc - 2, argv + 2)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        return 0;
+    }
+#endif
+
+    if (argc == 2 && strcmp(argv[1], "help") == 0) {
+        printUsage(argv[0]);
+        return 0;
+    }
+
+    auto variant = CpuVariant::Nmos;
+
+    // the file commands take an optional --cpu ahead of their file
+    if (argc == 3 || (argc == 5 && strcmp(argv[2], "--cpu") == 0 && parseVariant(argv[3], variant))) {
+        const auto* path = argv[argc - 1];
+
         if (strcmp(argv[1], "tokenize") == 0) {
-            std::ifstream file { argv[2] };
+            std::ifstream file { path };
             const std::string source { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
             tokenizeDebug(source);
             return 0;
         }
 
         if (strcmp(argv[1], "compile-debug") == 0) {
-            std::ifstream file { argv[2] };
+            std::ifstream file { path };
             const std::string source { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
-            assembleDebug(source);
+            assembleDebug(source, variant);
             return 0;
         }
 
         if (strcmp(argv[1], "compile") == 0) {
-            std::ifstream file { argv[2] };
+            std::ifstream file { path };
             const std::string source { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
-            assembleBytes(source);
+            assembleBytes(source, variant);
+            return 0;
+        }
+
+        if (strcmp(argv[1], "symbols") == 0) {
+            std::ifstream file { path };
+            const std::string source { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+            assembleSymbols(source, variant);
             return 0;
         }
 
         if (strcmp(argv[1], "decompile") == 0) {
-            std::ifstream file { argv[2], std::ios::binary };
+            std::ifstream file { path, std::ios::binary };
             const std::vector<uint8_t> bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
-            disassembleBytes(bytes);
+            disassembleBytes(bytes, variant);
             return 0;
         }
     }
 
-    printUsage(argv[0]);
-    return 1;
+    if (!runCommand(argc - 1, argv + 1)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    return 0;
 }
\ No newline at end of file